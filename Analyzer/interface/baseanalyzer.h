@@ -2,6 +2,10 @@
 #define BASEANALYZER_H
 
 #include <memory>
+#include <string>
+#include <cstdlib>
+#include <typeinfo>
+#include <cxxabi.h>
 
 #include <TFile.h>
 
@@ -26,6 +30,19 @@ class BaseAnalyzer {
         virtual void BeginJob(const pt::ptree& skim, const pt::ptree& sf) = 0;
         virtual void Analyze(T& input, Output& out) = 0;
         virtual void EndJob(const std::shared_ptr<TFile>& outFile) = 0;
+
+        //Name used for timing/tracing, class name without template arguments and "Analyzer" suffix
+        virtual std::string Name() const {
+            int status;
+            char* demangled = abi::__cxa_demangle(typeid(*this).name(), nullptr, nullptr, &status);
+            std::string name = status == 0 ? demangled : typeid(*this).name();
+            std::free(demangled);
+
+            name = name.substr(0, name.find('<'));
+            if(name.size() > 8 and name.substr(name.size() - 8) == "Analyzer") name = name.substr(0, name.size() - 8);
+
+            return name;
+        }
 };
 
 #endif
@@ -0,0 +1,83 @@
+#ifndef CORRECTIONCACHE_H
+#define CORRECTIONCACHE_H
+
+#include <map>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <string>
+
+/// Process wide cache of loaded configs and corrections (JEC parameters, JER,
+/// correctionlib sets, Rochester corrections), keyed by their source. In a single skim
+/// every key is loaded once anyway, in the NanoSkim server mode all jobs of an era
+/// share the loaded objects. Only objects which are not modified during the event loop
+/// are cached, stateful correctors are constructed per analyzer from cached parameters.
+/// Each key is loaded once outside of the cache lock, so only jobs waiting for the same
+/// key block each other.
+
+class CorrectionCache {
+    private:
+        static std::mutex& Mutex(){
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        using Entry = std::shared_future<std::shared_ptr<const void>>;
+
+        static std::map<std::string, Entry>& Objects(){
+            static std::map<std::string, Entry> objects;
+            return objects;
+        }
+
+    public:
+        //Object for the key, loaded with the given function (returning a shared_ptr<V>) if not cached yet
+        template <typename V, typename F>
+        static std::shared_ptr<const V> Get(const std::string& key, F load){
+            std::promise<std::shared_ptr<const void>> promise;
+            Entry entry;
+            bool isLoader = false;
+
+            {
+                std::lock_guard<std::mutex> lock(Mutex());
+                std::map<std::string, Entry>& objects = Objects();
+
+                if(!objects.count(key)){
+                    objects[key] = promise.get_future().share();
+                    isLoader = true;
+                }
+
+                entry = objects.at(key);
+            }
+
+            //Concurrent jobs asking for the same key wait for the first one instead of loading twice
+            if(isLoader){
+                try {
+                    promise.set_value(std::shared_ptr<const V>(load()));
+                }
+
+                //Failed load is not cached, waiting jobs get the exception and the next Get tries again
+                catch(...){
+                    {
+                        std::lock_guard<std::mutex> lock(Mutex());
+                        Objects().erase(key);
+                    }
+
+                    promise.set_exception(std::current_exception());
+                }
+            }
+
+            return std::static_pointer_cast<const V>(entry.get());
+        }
+
+        static std::size_t Size(){
+            std::lock_guard<std::mutex> lock(Mutex());
+            return Objects().size();
+        }
+
+        static void Clear(){
+            std::lock_guard<std::mutex> lock(Mutex());
+            Objects().clear();
+        }
+};
+
+#endif
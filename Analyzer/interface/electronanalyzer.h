@@ -99,6 +99,7 @@ class ElectronAnalyzer : public BaseAnalyzer<T> {
                     out.eleCharge[out.nElectrons] = input.eleCharge;
                     out.eleCutID[out.nElectrons] = input.eleCutID;
                     out.eleMVAID[out.nElectrons] =  input.eleMVAID;
+                    out.eleInputIdx[out.nElectrons] = i;
 
                     ++out.nElectrons;
                 }
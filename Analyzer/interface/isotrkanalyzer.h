@@ -44,6 +44,7 @@ class IsotrkAnalyzer : public BaseAnalyzer<T> {
                     //Charge
                     out.isotrkCharge[out.isotrkSize] = input.isotrkPDG > 0 ? 1 : -1;
                     out.isotrkPDG[out.isotrkSize] = input.isotrkPDG;
+                    out.isotrkInputIdx[out.isotrkSize] = i;
 
                     ++out.isotrkSize;
                 }
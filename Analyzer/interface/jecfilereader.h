@@ -0,0 +1,92 @@
+#ifndef JECFILEREADER_H
+#define JECFILEREADER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <CondFormats/JetMETObjects/interface/JetCorrectorParameters.h>
+
+/// JEC text file read in a single pass. The lines of all sections ([name] blocks, or
+/// the unnamed section of files without any) are indexed, parameters of a section are
+/// only parsed if requested. Replaces one full read of the file per uncertainty source
+/// with JetCorrectorParameters(file, section).
+
+class JECFileReader {
+    private:
+        struct Section {
+            std::string definitions;
+            std::vector<std::string> records;
+        };
+
+        std::string fileName;
+        std::map<std::string, Section> sections;
+
+    public:
+        JECFileReader(const std::string& fileName) : fileName(fileName) {
+            std::ifstream in(fileName);
+            if(!in) throw std::runtime_error("File not exists" + fileName);
+
+            std::string line;
+            Section* current = &sections[""];
+
+            while(std::getline(in, line)){
+                std::size_t first = line.find_first_not_of(" \t\r");
+                if(first == std::string::npos or line[first] == '#') continue;
+
+                if(line[first] == '['){
+                    std::size_t end = line.find(']', first);
+                    if(end == std::string::npos) throw std::runtime_error("Unclosed section in '" + fileName + "': " + line);
+
+                    current = &sections[line.substr(first + 1, end - first - 1)];
+                }
+
+                else if(line[first] == '{'){
+                    std::size_t end = line.find('}', first);
+                    if(end == std::string::npos) throw std::runtime_error("Unclosed definitions in '" + fileName + "': " + line);
+
+                    current->definitions = line.substr(first + 1, end - first - 1);
+                }
+
+                else current->records.push_back(line);
+            }
+        }
+
+        bool Has(const std::string& section) const {
+            return sections.count(section) and sections.at(section).definitions != "";
+        }
+
+        //Parameters of a section, empty name for files without sections
+        JetCorrectorParameters Get(const std::string& section = "") const {
+            if(!Has(section)) throw std::runtime_error("Section '" + section + "' not found in '" + fileName + "'");
+
+            const Section& s = sections.at(section);
+            JetCorrectorParameters::Definitions definitions(s.definitions);
+            std::vector<JetCorrectorParameters::Record> records;
+            records.reserve(s.records.size());
+
+            for(const std::string& line : s.records){
+                JetCorrectorParameters::Record record(line, definitions.nBinVar());
+
+                //Same check as in the text file constructor of JetCorrectorParameters
+                bool valid = record.nParameters() != 0;
+                for(unsigned i = 0; i < definitions.nBinVar(); ++i){
+                    if(record.xMin(i) == 0 and record.xMax(i) == 0) valid = false;
+                }
+
+                if(valid) records.push_back(record);
+            }
+
+            std::sort(records.begin(), records.end());
+
+            JetCorrectorParameters p(definitions, records);
+            p.init();
+
+            return p;
+        }
+};
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef JECSNAPSHOT_H
+#define JECSNAPSHOT_H
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <experimental/filesystem>
+
+#include <CondFormats/JetMETObjects/interface/JetCorrectorParameters.h>
+
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+/// Binary snapshot of the parsed JEC parameters (correction levels and uncertainty
+/// sources) of one era, run period and data/MC configuration. The file name contains
+/// a FNV-1a hash of the configuration and the content of all source text files, so a
+/// changed source file results in a new snapshot, independent of the install path.
+/// The snapshot is memory-mapped and the parameters are constructed from the stored
+/// binning records without parsing the text files. A corrupt or incomplete snapshot
+/// is dropped (the text files are parsed and it is written again) and failing to
+/// write a snapshot only costs the parsing in the next job.
+///
+/// Layout: header | entries (key, definitions line, records) | offset table
+
+class JECSnapshot {
+    private:
+        static constexpr char magic[8] = {'J', 'E', 'C', 'S', 'N', 'A', 'P', '1'};
+
+        struct Header {
+            char magic[8];
+            std::uint64_t nEntries, indexOffset;
+        };
+
+        std::string fileName;
+        bool enabled = false;
+
+        //Loaded snapshot
+        std::unique_ptr<Util::MappedFile> file;
+        const char* data = nullptr;
+        std::size_t size = 0;
+        std::map<std::string, std::uint64_t> index;
+
+        //All parameters returned by Get, so a snapshot dropped after some of them were read from it can be written again
+        std::vector<std::pair<std::string, JetCorrectorParameters>> added;
+
+        //Advance the read position by n bytes, offsets and counts of a corrupt snapshot could point outside of the mapping
+        const char* Take(const char*& pos, const std::size_t& n) const {
+            if(pos < data or n > std::size_t(data + size - pos)) throw std::runtime_error("JEC snapshot is corrupt: '" + fileName + "'");
+
+            const char* begin = pos;
+            pos += n;
+
+            return begin;
+        }
+
+        std::uint32_t ReadCount(const char*& pos) const {
+            std::uint32_t n;
+            std::memcpy(&n, Take(pos, 4), 4);
+
+            return n;
+        }
+
+        std::string ReadString(const char*& pos) const {
+            std::uint32_t length = ReadCount(pos);
+
+            return std::string(Take(pos, length), length);
+        }
+
+        std::vector<float> ReadFloats(const char*& pos) const {
+            std::uint32_t n = ReadCount(pos);
+            std::vector<float> v(n);
+            std::memcpy(v.data(), Take(pos, std::size_t(n) * 4), std::size_t(n) * 4);
+
+            return v;
+        }
+
+        void Unmap(){
+            file.reset();
+            data = nullptr;
+            size = 0;
+            index.clear();
+        }
+
+        //Map the snapshot and read its offset table
+        void Map(){
+            file = std::make_unique<Util::MappedFile>(fileName, "JEC snapshot");
+            data = file->Data();
+            size = file->Size();
+
+            Header header;
+            if(size < sizeof(Header)) throw std::runtime_error("JEC snapshot is too small: '" + fileName + "'");
+
+            std::memcpy(&header, data, sizeof(Header));
+            if(std::memcmp(header.magic, magic, sizeof(magic)) != 0) throw std::runtime_error("Not a JEC snapshot: '" + fileName + "'");
+            if(header.indexOffset < sizeof(Header) or header.indexOffset > size) throw std::runtime_error("JEC snapshot is corrupt: '" + fileName + "'");
+
+            const char* pos = data + header.indexOffset;
+
+            for(std::size_t i = 0; i < header.nEntries; ++i){
+                std::string entryKey = ReadString(pos);
+                std::uint64_t offset;
+                std::memcpy(&offset, Take(pos, 8), 8);
+
+                if(offset < sizeof(Header) or offset >= header.indexOffset) throw std::runtime_error("JEC snapshot is corrupt: '" + fileName + "'");
+                index[entryKey] = offset;
+            }
+        }
+
+        static void WriteString(std::ofstream& out, const std::string& s){
+            std::uint32_t length = s.size();
+            out.write(reinterpret_cast<const char*>(&length), 4);
+            out.write(s.data(), length);
+        }
+
+        static void WriteFloats(std::ofstream& out, const std::vector<float>& v){
+            std::uint32_t n = v.size();
+            out.write(reinterpret_cast<const char*>(&n), 4);
+            out.write(reinterpret_cast<const char*>(v.data()), n * 4);
+        }
+
+        //Definitions in the text format of the JEC files (without braces), the level is only set by this constructor
+        static std::string DefinitionLine(const JetCorrectorParameters::Definitions& definitions){
+            std::stringstream line;
+            line << definitions.nBinVar();
+            for(unsigned i = 0; i < definitions.nBinVar(); ++i) line << " " << definitions.binVar(i);
+            line << " " << definitions.nParVar();
+            for(unsigned i = 0; i < definitions.nParVar(); ++i) line << " " << definitions.parVar(i);
+            line << " " << definitions.formula() << " " << (definitions.isResponse() ? "Response" : "Correction") << " " << definitions.level();
+
+            return line.str();
+        }
+
+    public:
+        //Empty directory disables the snapshot, key contains the configuration (e.g. era, run period and requested sources)
+        JECSnapshot(const std::string& dir, const std::string& key, const std::vector<std::string>& sourceFiles){
+            if(dir == "") return;
+            enabled = true;
+
+            std::uint64_t hash = Util::Hash(key.data(), key.size());
+
+            for(const std::string& source : sourceFiles){
+                std::ifstream in(source, std::ios::binary);
+                if(!in) throw std::runtime_error("File not exists" + source);
+
+                std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                hash = Util::Hash(content.data(), content.size(), hash);
+            }
+
+            fileName = dir + "/JEC_" + Util::HashName(hash) + ".snap";
+
+            if(!std::experimental::filesystem::exists(fileName)) return;
+
+            try {
+                Map();
+                std::cout << "Use JEC snapshot: " << fileName << " (" << index.size() << " parameter sets)" << std::endl;
+            }
+
+            catch(const std::runtime_error& e){
+                std::cout << "Warning: " << e.what() << ", JEC text files are parsed instead" << std::endl;
+                Unmap();
+            }
+        }
+
+        JECSnapshot(const JECSnapshot&) = delete;
+        JECSnapshot& operator=(const JECSnapshot&) = delete;
+
+        bool Loaded() const {return data != nullptr;}
+
+        //Parameters from the snapshot, or parsed with the given function and stored in the snapshot to be written
+        template <typename F>
+        JetCorrectorParameters Get(const std::string& key, F parse){
+            if(Loaded() and !index.count(key)){
+                std::cout << "Warning: JEC snapshot '" << fileName << "' has no parameters for '" << key << "', it will be rebuild" << std::endl;
+                Unmap();
+            }
+
+            if(Loaded()){
+                try {
+                    const char* pos = data + index.at(key);
+
+                    JetCorrectorParameters::Definitions definitions(ReadString(pos));
+
+                    //Each record has at least the three float counts
+                    std::uint32_t nRecords = ReadCount(pos);
+                    if(nRecords > std::size_t(data + size - pos)/12) throw std::runtime_error("JEC snapshot is corrupt: '" + fileName + "'");
+
+                    std::vector<JetCorrectorParameters::Record> records;
+                    records.reserve(nRecords);
+
+                    for(std::size_t i = 0; i < nRecords; ++i){
+                        std::vector<float> xMin = ReadFloats(pos), xMax = ReadFloats(pos), parameters = ReadFloats(pos);
+                        records.push_back(JetCorrectorParameters::Record(xMin.size(), xMin, xMax, parameters));
+                    }
+
+                    JetCorrectorParameters p(definitions, records);
+                    p.init();
+                    added.push_back({key, p});
+
+                    return p;
+                }
+
+                //Dropping the mapping makes Write rebuild the snapshot from all parameters returned so far
+                catch(const std::exception& e){
+                    std::cout << "Warning: " << e.what() << ", JEC text files are parsed for '" << key << "' and the snapshot will be rebuild" << std::endl;
+                    Unmap();
+                }
+            }
+
+            JetCorrectorParameters p = parse();
+            if(enabled) added.push_back({key, p});
+
+            return p;
+        }
+
+        //Best effort, the skim does not need the snapshot (e.g. read-only or full snapshot directory)
+        void Write(){
+            if(!enabled or Loaded() or added.empty()) return;
+
+            try {
+                Util::WriteAtomic(fileName, [&](const std::string& tmp){WriteFile(tmp);});
+                std::cout << "Written JEC snapshot: " << fileName << " (" << added.size() << " parameter sets)" << std::endl;
+            }
+
+            catch(const std::exception& e){
+                std::cout << "Warning: Could not write JEC snapshot '" << fileName << "': " << e.what() << std::endl;
+            }
+
+            added.clear();
+        }
+
+    private:
+        void WriteFile(const std::string& tmp){
+            std::ofstream out(tmp, std::ios::binary);
+            if(!out) throw std::runtime_error("Could not create '" + tmp + "'");
+
+            Header header{};
+            std::memcpy(header.magic, magic, sizeof(magic));
+            header.nEntries = added.size();
+            out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+            std::vector<std::uint64_t> offsets;
+
+            for(const std::pair<std::string, JetCorrectorParameters>& a : added){
+                const JetCorrectorParameters& p = a.second;
+                offsets.push_back(out.tellp());
+
+                WriteString(out, DefinitionLine(p.definitions()));
+
+                std::uint32_t nRecords = p.size();
+                out.write(reinterpret_cast<const char*>(&nRecords), 4);
+
+                for(unsigned i = 0; i < p.size(); ++i){
+                    const JetCorrectorParameters::Record& r = p.record(i);
+                    std::vector<float> xMin, xMax;
+
+                    for(unsigned j = 0; j < r.nVar(); ++j){
+                        xMin.push_back(r.xMin(j));
+                        xMax.push_back(r.xMax(j));
+                    }
+
+                    WriteFloats(out, xMin);
+                    WriteFloats(out, xMax);
+                    WriteFloats(out, r.parameters());
+                }
+            }
+
+            header.indexOffset = out.tellp();
+
+            for(std::size_t i = 0; i < added.size(); ++i){
+                WriteString(out, added[i].first);
+                out.write(reinterpret_cast<const char*>(&offsets[i]), 8);
+            }
+
+            out.seekp(0);
+            out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+            out.close();
+            if(!out) throw std::runtime_error("Could not write '" + tmp + "'");
+        }
+};
+
+#endif
@@ -4,6 +4,9 @@
 #include <cmath>
 #include <random>
 #include <limits>
+#include <iterator>
+#include <algorithm>
+#include <map>
 #include <functional>
 #include <experimental/filesystem>
 
@@ -14,6 +17,9 @@
 #include <CondFormats/JetMETObjects/interface/JetCorrectionUncertainty.h>
 
 #include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
+#include <ChargedSkimming/Analyzer/interface/jecsnapshot.h>
+#include <ChargedSkimming/Analyzer/interface/jecfilereader.h>
+#include <ChargedSkimming/Analyzer/interface/correctioncache.h>
 #include <ChargedSkimming/Skimming/interface/btagcsvreader.h>
 #include <ChargedSkimming/Skimming/interface/util.h>
 
@@ -21,19 +27,33 @@ template <typename T>
 class JetAnalyzer : public BaseAnalyzer<T> {
     private:
         //Input information
-        std::string era, run;
+        std::string era;
         bool isData;
 
         //Kinematic cut criteria
         float ptCut, etaCut;
 
-        //JEC corrector
+        //JEC corrector of the run period of the current event
         std::shared_ptr<FactorizedJetCorrector> jetCorrectorAK4, jetCorrectorAK8;
 
+        //JEC correctors of all run periods of the era sorted by first run, for MC a single period covering all runs
+        struct RunPeriod {
+            std::string name;
+            unsigned int first, last;
+            std::shared_ptr<FactorizedJetCorrector> correctorAK4, correctorAK8;
+        };
+
+        std::vector<RunPeriod> runPeriods;
+        std::size_t currentPeriod = 0;
+
         //JEC uncertainty
         std::vector<std::string> JECSysts;
         std::vector<std::shared_ptr<JetCorrectionUncertainty>> jecUncAK4, jecUncAK8;
 
+        //JEC sources booked in any output tree, the others are set to the nominal correction
+        std::vector<char> JECWanted;
+        bool checkedWanted = false;
+
         //Classes for reading jet energy SF 
         JME::JetParameters jetParameter;
         JME::JetResolution resolutionAK4, resolutionAK8;
@@ -54,6 +74,21 @@ class JetAnalyzer : public BaseAnalyzer<T> {
             } 
         }
 
+        void SetRunPeriod(const unsigned int& runNr){
+            //Runs are normally ordered, so the period of the last event is checked first
+            if(runPeriods[currentPeriod].first <= runNr and runNr <= runPeriods[currentPeriod].last) return;
+
+            typename std::vector<RunPeriod>::iterator it = std::upper_bound(runPeriods.begin(), runPeriods.end(), runNr, [](const unsigned int& r, const RunPeriod& p){return r < p.first;});
+
+            if(it == runPeriods.begin() or runNr > std::prev(it)->last){
+                throw std::runtime_error("Run " + std::to_string(runNr) + " is not in any JEC run period of era " + era);
+            }
+
+            currentPeriod = std::prev(it) - runPeriods.begin();
+            jetCorrectorAK4 = runPeriods[currentPeriod].correctorAK4;
+            jetCorrectorAK8 = runPeriods[currentPeriod].correctorAK8;
+        }
+
     public:
         JetAnalyzer(){}
 
@@ -159,63 +194,132 @@ class JetAnalyzer : public BaseAnalyzer<T> {
         void BeginJob(const pt::ptree& skim, const pt::ptree& sf){
             //Read information needed
             era = skim.get<std::string>("era");
-            run = skim.get<std::string>("run");
+            isData = skim.get<bool>("isData");
 
-            if(run != "MC" and era.find("2016") != std::string::npos){
-                if(era == "2016Post") run = "FGH";
-                else{
-                    if(std::string("BCD").find(run) != std::string::npos) run = "BCD";
-                    else run = "EF";
+            ptCut = skim.get<float>("Analyzer.Jet.pt." + era);
+            etaCut = skim.get<float>("Analyzer.Jet.eta." + era);
+
+            //Run ranges of the periods with own JEC data files, data files of several periods can be skimmed in one job
+            if(isData){
+                for(const std::string& period : Util::GetKeys(sf, "Jet.JEC.RunPeriods." + era)){
+                    std::vector<unsigned int> range = Util::GetVector<unsigned int>(sf, "Jet.JEC.RunPeriods." + era + "." + period);
+                    runPeriods.push_back({period, range.at(0), range.at(1)});
                 }
+
+                std::sort(runPeriods.begin(), runPeriods.end(), [](const RunPeriod& p1, const RunPeriod& p2){return p1.first < p2.first;});
             }
 
-            isData = skim.get<bool>("isData");
+            else runPeriods.push_back({"MC", 0, std::numeric_limits<unsigned int>::max()});
 
-            ptCut = skim.get<float>("Analyzer.Jet.pt." + era);
-            etaCut = skim.get<float>("Analyzer.Jet.eta." + era);
+            //JEC text files of both jet types
+            JECSysts = !isData ? Util::GetVector<std::string>(skim, "Analyzer.Jet.JECSyst") : std::vector<std::string>{};
+            std::map<std::string, std::vector<std::string>> jecFiles;
+            std::map<std::string, std::string> jecUncFiles;
+            std::vector<std::string> sourceFiles;
 
-            //Set JEC/JME classes
             for(const std::string type : {"AK4", "AK8"}){
-                //Class for JEC
-                std::vector<JetCorrectorParameters> corrVec;
+                for(const RunPeriod& period : runPeriods){
+                    for(std::string jecFile: Util::GetVector<std::string>(sf, (!isData ? "Jet.JEC.MC." : "Jet.JEC.DATA.") + era)){
+                        if(isData) jecFile.replace(jecFile.find("@"), 1, period.name);
+                        jecFile.replace(jecFile.find("&"), 1, type);
+                        jecFile = this->filePath + jecFile;
+
+                        if(!std::experimental::filesystem::exists(jecFile)){
+                            throw std::runtime_error("File not exists" + jecFile);
+                        }
+
+                        jecFiles[type + "/" + period.name].push_back(jecFile);
+                        sourceFiles.push_back(jecFile);
+                    }
+                }
+
+                std::string jecUncFile = this->filePath + sf.get<std::string>("Jet.JECUNC." + era);
+                jecUncFile.replace(jecUncFile.find("&"), 1, type);
+                jecUncFiles[type] = jecUncFile;
+                if(!JECSysts.empty()) sourceFiles.push_back(jecUncFile);
+            }
+
+            //Parsed JEC parameters of all levels, run periods and requested sources, shared by all jobs with the same configuration
+            std::string jecKey = era + "/" + (isData ? "DATA" : "MC");
+            for(const RunPeriod& period : runPeriods) jecKey += "/" + period.name;
+            for(const std::string& JECSyst : JECSysts) jecKey += "/" + JECSyst;
+
+            std::shared_ptr<const std::map<std::string, JetCorrectorParameters>> jecParameters = CorrectionCache::Get<std::map<std::string, JetCorrectorParameters>>("JEC/" + jecKey, [&](){
+                std::shared_ptr<std::map<std::string, JetCorrectorParameters>> parameters = std::make_shared<std::map<std::string, JetCorrectorParameters>>();
+
+                //Parsed JEC parameters are read from a snapshot if the source files did not change
+                std::string snapshotDir = skim.get<bool>("Analyzer.Jet.Snapshot.Enabled", false) ? this->filePath + skim.get<std::string>("Analyzer.Jet.Snapshot.Dir") : "";
+                JECSnapshot snapshot(snapshotDir, jecKey, sourceFiles);
 
-                for(std::string jecFile: Util::GetVector<std::string>(sf, (!isData ? "Jet.JEC.MC." : "Jet.JEC.DATA.") + era)){
-                    if(run != "MC") jecFile.replace(jecFile.find("@"), 1, run);
-                    jecFile.replace(jecFile.find("&"), 1, type);
-                    jecFile = this->filePath + jecFile;
+                //Each text file is read only once, even if several uncertainty sources are taken from it
+                std::map<std::string, std::shared_ptr<JECFileReader>> readers;
 
-                    if(!std::experimental::filesystem::exists(jecFile)){
-                        throw std::runtime_error("File not exists" + jecFile);
+                std::function<const JECFileReader&(const std::string&)> reader = [&](const std::string& fileName) -> const JECFileReader& {
+                    if(!readers.count(fileName)) readers[fileName] = std::make_shared<JECFileReader>(fileName);
+                    return *readers.at(fileName);
+                };
+
+                for(const std::string type : {"AK4", "AK8"}){
+                    for(const RunPeriod& period : runPeriods){
+                        const std::vector<std::string>& files = jecFiles[type + "/" + period.name];
+
+                        for(std::size_t i = 0; i < files.size(); ++i){
+                            std::string key = type + "/" + period.name + "/Level" + std::to_string(i);
+                            parameters->emplace(key, snapshot.Get(key, [&](){return reader(files[i]).Get();}));
+                        }
                     }
 
-                    corrVec.push_back(JetCorrectorParameters(jecFile));
+                    const std::string& jecUncFile = jecUncFiles[type];
+
+                    for(const std::string& JECSyst: JECSysts){
+                        std::string key = type + "/" + JECSyst;
+                        parameters->emplace(key, snapshot.Get(key, [&](){return reader(jecUncFile).Get(JECSyst);}));
+                    }
                 }
 
-                if(type == "AK4") jetCorrectorAK4 = std::make_shared<FactorizedJetCorrector>(corrVec);
-                else jetCorrectorAK8 = std::make_shared<FactorizedJetCorrector>(corrVec);
+                snapshot.Write();
 
-                //Set object to get JEC uncertainty
-                JECSysts = !isData ? Util::GetVector<std::string>(skim, "Analyzer.Jet.JECSyst") : std::vector<std::string>{};
-                
-                std::string jecUncFile = this->filePath + sf.get<std::string>("Jet.JECUNC." + era);
-                jecUncFile.replace(jecUncFile.find("&"), 1, type);  
+                return parameters;
+            });
+
+            //Set JEC/JME classes
+            for(const std::string type : {"AK4", "AK8"}){
+                //Class for JEC per run period, the corrector keeps the jet of the last call and is therefore not shared
+                for(RunPeriod& period : runPeriods){
+                    std::vector<JetCorrectorParameters> corrVec;
+
+                    for(std::size_t i = 0; i < jecFiles[type + "/" + period.name].size(); ++i){
+                        corrVec.push_back(jecParameters->at(type + "/" + period.name + "/Level" + std::to_string(i)));
+                    }
 
+                    if(type == "AK4") period.correctorAK4 = std::make_shared<FactorizedJetCorrector>(corrVec);
+                    else period.correctorAK8 = std::make_shared<FactorizedJetCorrector>(corrVec);
+                }
+
+                //Set object to get JEC uncertainty
                 for(std::string& JECSyst: JECSysts){
-                    if(type == "AK4") jecUncAK4.push_back(std::make_shared<JetCorrectionUncertainty>(JetCorrectorParameters(jecUncFile, JECSyst)));
-                    else jecUncAK8.push_back(std::make_shared<JetCorrectionUncertainty>(JetCorrectorParameters(jecUncFile, JECSyst)));
+                    const JetCorrectorParameters& uncParameters = jecParameters->at(type + "/" + JECSyst);
+
+                    if(type == "AK4") jecUncAK4.push_back(std::make_shared<JetCorrectionUncertainty>(uncParameters));
+                    else jecUncAK8.push_back(std::make_shared<JetCorrectionUncertainty>(uncParameters));
                 }
 
-                //Class for JME
+                //Class for JME, copies share the parsed resolution object
                 std::string JMEResoFile = this->filePath + sf.get<std::string>("Jet.JMEPtReso." + era);
                 JMEResoFile.replace(JMEResoFile.find("&"), 1, type);
-                if(type == "AK4") resolutionAK4 = JME::JetResolution(JMEResoFile);
-                else resolutionAK8 = JME::JetResolution(JMEResoFile);
+                const JME::JetResolution& resolution = *CorrectionCache::Get<JME::JetResolution>("JER/" + JMEResoFile, [&](){return std::make_shared<JME::JetResolution>(JMEResoFile);});
+                if(type == "AK4") resolutionAK4 = resolution;
+                else resolutionAK8 = resolution;
 
                 std::string JMEFile = this->filePath + sf.get<std::string>("Jet.JME." + era);
                 JMEFile.replace(JMEFile.find("&"), 1, type);
-                if(type == "AK4") resolutionSFAK4 = JME::JetResolutionScaleFactor(JMEFile);
-                else resolutionSFAK8 = JME::JetResolutionScaleFactor(JMEFile);
+                const JME::JetResolutionScaleFactor& resolutionSF = *CorrectionCache::Get<JME::JetResolutionScaleFactor>("JER/" + JMEFile, [&](){return std::make_shared<JME::JetResolutionScaleFactor>(JMEFile);});
+                if(type == "AK4") resolutionSFAK4 = resolutionSF;
+                else resolutionSFAK8 = resolutionSF;
             }
+
+            jetCorrectorAK4 = runPeriods[0].correctorAK4;
+            jetCorrectorAK8 = runPeriods[0].correctorAK8;
             
             //BTag cuts
             float looseDeepCSVThr = skim.get<float>("Analyzer.Jet.btag.DeepCSV." + era + ".loose");
@@ -236,7 +340,18 @@ class JetAnalyzer : public BaseAnalyzer<T> {
         }
 
         void Analyze(T& input, Output& out){
+            if(!checkedWanted){
+                for(const std::string& JECSyst : JECSysts) JECWanted.push_back(out.IsWanted("*_JEC" + JECSyst + "*"));
+                checkedWanted = true;
+            }
+
             out.nJets = 0, out.nSubJets = 0, out.nFatJets = 0;
+
+            if(isData){
+                input.ReadRunEntry();
+                SetRunPeriod(input.runNr);
+            }
+
             input.ReadJetEntry(isData);
             if(!isData) input.ReadGenEntry();
             
@@ -271,6 +386,12 @@ class JetAnalyzer : public BaseAnalyzer<T> {
                 fatJetJEC = CorrectEnergy(input.fatJetPtRaw, input.fatJetEta, input.fatJetPhi, input.fatJetArea, input.rho, false);
 
                 for(int JEC = 0; JEC < JECSysts.size(); ++JEC){
+                    if(!JECWanted[JEC]){
+                        fatJetJECUp.at(JEC) = fatJetJEC;
+                        fatJetJECDown.at(JEC) = fatJetJEC;
+                        continue;
+                    }
+
                     jecUncAK8.at(JEC)->setJetPt(fatJetJEC*input.fatJetPtRaw);
                     jecUncAK8.at(JEC)->setJetEta(input.fatJetEta);
                     jecUncAK8.at(JEC)->setJetPhi(input.fatJetPhi);
@@ -304,6 +425,7 @@ class JetAnalyzer : public BaseAnalyzer<T> {
                     out.fatJetDAK8ID.at(out.nFatJets) =  input.fatJetDAK8ID;
                     out.fatJetJEC.at(out.nFatJets) = fatJetJEC;
                     out.fatJetJME.at(out.nFatJets) = fatJetJME;
+                    out.fatJetInputIdx.at(out.nFatJets) = i;
 
                     for(int JEC = 0; JEC < JECSysts.size(); ++JEC){
                         out.fatJetPtJECUp.at(JEC).at(out.nFatJets) = input.fatJetPtRaw*fatJetJECUp.at(JEC)*fatJetJME;
@@ -325,6 +447,12 @@ class JetAnalyzer : public BaseAnalyzer<T> {
                 jetJEC = CorrectEnergy(input.jetPtRaw, input.jetEta, input.jetPhi, input.jetArea, input.rho, true);
 
                 for(int JEC = 0; JEC < JECSysts.size(); ++JEC){
+                    if(!JECWanted[JEC]){
+                        jetJECUp.at(JEC) = jetJEC;
+                        jetJECDown.at(JEC) = jetJEC;
+                        continue;
+                    }
+
                     jecUncAK4.at(JEC)->setJetPt(jetJEC*input.jetPtRaw);
                     jecUncAK4.at(JEC)->setJetEta(input.jetEta);
                     jecUncAK4.at(JEC)->setJetPhi(input.jetPhi);
@@ -387,6 +515,7 @@ class JetAnalyzer : public BaseAnalyzer<T> {
                         out.jetJME.at(out.nJets) = jetJME;
                         out.jetID.at(out.nJets) = input.jetID;
                         out.jetPUID.at(out.nJets) = input.jetPUID;
+                        out.jetInputIdx.at(out.nJets) = i;
                         
                         for(int JEC = 0; JEC < JECSysts.size(); ++JEC){
                             out.jetPtJECUp.at(JEC).at(out.nJets) = input.jetPtRaw*jetJECUp.at(JEC)*jetJME;
@@ -447,6 +576,7 @@ class JetAnalyzer : public BaseAnalyzer<T> {
                         out.subJetPartFlav.at(out.nSubJets) = input.jetPartFlav;
                         out.subJetJEC.at(out.nSubJets) = jetJEC;
                         out.subJetJME.at(out.nSubJets) = jetJME;
+                        out.subJetInputIdx.at(out.nSubJets) = i;
 
                         for(int JEC = 0; JEC < JECSysts.size(); ++JEC){
                             out.subJetPtJECUp.at(JEC).at(out.nSubJets) = input.jetPtRaw*jetJECUp.at(JEC)*jetJME;
@@ -22,7 +22,10 @@ class MiscAnalyzer : public BaseAnalyzer<T> {
             input.GetMisc();
 
             out.evNr = input.evNr;
+            out.runNr = input.runNr;
+            out.lumiNr = input.lumiNr;
             out.nParton = input.nParton;
+            out.inputEntry = input.inputEntry;
         }
 
         void EndJob(const std::shared_ptr<TFile>& outFile){
@@ -2,6 +2,7 @@
 #define MUONANALYZER_H
 
 #include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
+#include <ChargedSkimming/Analyzer/interface/correctioncache.h>
 #include <RoccoR/RoccoR.cc>
 
 template <typename T>
@@ -14,8 +15,8 @@ class MuonAnalyzer : public BaseAnalyzer<T> {
         //Kinematic cut criteria
         float ptCut, etaCut;
 
-        //Muon scale corrector
-        RoccoR rc; 
+        //Muon scale corrector (shared by all jobs of the process)
+        std::shared_ptr<const RoccoR> rc;
 
 
     public:
@@ -30,7 +31,8 @@ class MuonAnalyzer : public BaseAnalyzer<T> {
             ptCut = skim.get<float>("Analyzer.Muon.pt." + era);
             etaCut = skim.get<float>("Analyzer.Muon.eta." + era);
 
-            rc.init(std::string(std::getenv("CMSSW_BASE")) + "/src/" + sf.get<std::string>("Muon.Scale." + era));
+            std::string rcFile = std::string(std::getenv("CMSSW_BASE")) + "/src/" + sf.get<std::string>("Muon.Scale." + era);
+            rc = CorrectionCache::Get<RoccoR>("Rochester/" + rcFile, [&](){return std::make_shared<RoccoR>(rcFile);});
         };
 
         void Analyze(T& input, Output& out){
@@ -55,17 +57,17 @@ class MuonAnalyzer : public BaseAnalyzer<T> {
                             input.alreadyMatchedIdx.push_back(genIdx);
                             input.GetGenPart(genIdx);
 
-                            mcSF = rc.kSpreadMC(input.muCharge, input.muPt, input.muEta, input.muPhi, input.genPt, 0, 0);
-                            unc = rc.kSpreadMCerror(input.muCharge, input.muPt, input.muEta, input.muPhi, input.genPt); 
+                            mcSF = rc->kSpreadMC(input.muCharge, input.muPt, input.muEta, input.muPhi, input.genPt, 0, 0);
+                            unc = rc->kSpreadMCerror(input.muCharge, input.muPt, input.muEta, input.muPhi, input.genPt); 
                         }
 
                         else{
-                            mcSF = rc.kSmearMC(input.muCharge, input.muPt, input.muEta, input.muPhi, input.muNTrackerLayers, input.muRandomNumber, 0, 0);
-                            unc = rc.kSmearMCerror(input.muCharge, input.muPt, input.muEta, input.muPhi, input.muNTrackerLayers, input.muRandomNumber); 
+                            mcSF = rc->kSmearMC(input.muCharge, input.muPt, input.muEta, input.muPhi, input.muNTrackerLayers, input.muRandomNumber, 0, 0);
+                            unc = rc->kSmearMCerror(input.muCharge, input.muPt, input.muEta, input.muPhi, input.muNTrackerLayers, input.muRandomNumber); 
                         }                       
                     }
 
-                    else dtSF = rc.kScaleDT(input.muCharge, input.muPt, input.muEta, input.muPhi, 0, 0);
+                    else dtSF = rc->kScaleDT(input.muCharge, input.muPt, input.muEta, input.muPhi, 0, 0);
 
                     if(!(mcSF < 2) or !(mcSF > 0)) mcSF = 1;
                     if(!(dtSF < 2) or !(dtSF > 0)) dtSF = 1;
@@ -102,6 +104,7 @@ class MuonAnalyzer : public BaseAnalyzer<T> {
                         out.muCharge[out.nMuons] = input.muCharge;
                         out.muCutID[out.nMuons] = input.muCutID;
                         out.muMVAID[out.nMuons] =  input.muMVAID;
+                        out.muInputIdx[out.nMuons] = i;
 
                         if(genIdx != -1){
                             input.GetGenPart(genIdx);
@@ -2,10 +2,12 @@
 #define SFANALYZER_H
 
 #include <memory>
+#include <functional>
 
 #include <TH2F.h>
 
 #include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
+#include <ChargedSkimming/Analyzer/interface/correctioncache.h>
 #include <ChargedSkimming/Skimming/interface/btagcsvreader.h>
 
 #include <correction.h>
@@ -29,9 +31,31 @@ class SFAnalyzer : public BaseAnalyzer<T> {
                               bTagEffLightLooseDeepCSV, bTagEffLightMediumDeepCSV, bTagEffLightTightDeepCSV,
                               bTotal, cTotal, lightTotal;
                               
-        std::unique_ptr<correction::CorrectionSet> eleSF, muonSF, bTagSF;
+        std::shared_ptr<const correction::CorrectionSet> eleSF, muonSF, bTagSF;
         std::vector<std::string> bTagSyst, bTagSystLight;
 
+        //B-tag SF variations booked in any output tree, others are not computed
+        std::vector<char> jetBTagSystWanted, jetBTagSystLightWanted, subJetBTagSystWanted, subJetBTagSystLightWanted;
+        bool checkedWanted = false;
+
+        void CheckWanted(const Output& out){
+            for(std::string bUnc : bTagSyst){
+                bUnc[0] = std::toupper(bUnc[0]);
+
+                jetBTagSystWanted.push_back(out.IsWanted("Jet_*SF" + bUnc + "Up") or out.IsWanted("Jet_*SF" + bUnc + "Down"));
+                subJetBTagSystWanted.push_back(out.IsWanted("SubJet_*SF" + bUnc + "Up") or out.IsWanted("SubJet_*SF" + bUnc + "Down"));
+            }
+
+            for(std::string bUnc : bTagSystLight){
+                bUnc[0] = std::toupper(bUnc[0]);
+
+                jetBTagSystLightWanted.push_back(out.IsWanted("Jet_*SF" + bUnc + "LightUp") or out.IsWanted("Jet_*SF" + bUnc + "LightDown"));
+                subJetBTagSystLightWanted.push_back(out.IsWanted("SubJet_*SF" + bUnc + "LightUp") or out.IsWanted("SubJet_*SF" + bUnc + "LightDown"));
+            }
+
+            checkedWanted = true;
+        }
+
     public:
         SFAnalyzer(){}
 
@@ -43,9 +67,14 @@ class SFAnalyzer : public BaseAnalyzer<T> {
             era = skim.get<std::string>("era");
             isData = run != "MC";
 
-            eleSF = correction::CorrectionSet::from_file(this->CMSSWPath + sf.get<std::string>("Electron." + era + ".file"));
-            muonSF = correction::CorrectionSet::from_file(this->CMSSWPath + sf.get<std::string>("Muon.SF." + era + ".file"));
-            bTagSF = correction::CorrectionSet::from_file(this->CMSSWPath + sf.get<std::string>("Jet.BTag." + era));
+            //Correction sets are evaluated const, so they are shared by all jobs of the process
+            std::function<std::shared_ptr<const correction::CorrectionSet>(const std::string&)> correctionSet = [&](const std::string& fileName){
+                return CorrectionCache::Get<correction::CorrectionSet>("Correctionlib/" + fileName, [&](){return std::shared_ptr<correction::CorrectionSet>(correction::CorrectionSet::from_file(fileName));});
+            };
+
+            eleSF = correctionSet(this->CMSSWPath + sf.get<std::string>("Electron." + era + ".file"));
+            muonSF = correctionSet(this->CMSSWPath + sf.get<std::string>("Muon.SF." + era + ".file"));
+            bTagSF = correctionSet(this->CMSSWPath + sf.get<std::string>("Jet.BTag." + era));
 
             eleEraAlias = sf.get<std::string>("Electron." + era + ".eraAlias");
             muEraAlias = sf.get<std::string>("Muon.SF." + era + ".eraAlias");
@@ -94,6 +123,7 @@ class SFAnalyzer : public BaseAnalyzer<T> {
 
         void Analyze(T& input, Output& out){
             if(isData) return;
+            if(!checkedWanted) CheckWanted(out);
             
             float elePt, muEta, muPt;
 
@@ -273,6 +303,8 @@ class SFAnalyzer : public BaseAnalyzer<T> {
                 out.jetTightDeepJetSF[i] = bTagSF->at("deepJet" + postFix)->evaluate({"central", "T", flav, std::abs(out.jetEta[i]), out.jetPt[i]});
 
                 for(int bSyst = 0; bSyst < bTagSyst.size(); ++bSyst){
+                    if(!jetBTagSystWanted[bSyst]) continue;
+
                     std::string shiftUp = flav != 0 ? "up_" + bTagSyst[bSyst] : "central",
                                 shiftDown = flav != 0 ? "down_" + bTagSyst[bSyst] : "central";
 
@@ -292,6 +324,8 @@ class SFAnalyzer : public BaseAnalyzer<T> {
                 }
 
                 for(int bSyst = 0; bSyst < bTagSystLight.size(); ++bSyst){
+                    if(!jetBTagSystLightWanted[bSyst]) continue;
+
                     std::string shiftUp = flav == 0 ? "up_" + bTagSyst[bSyst] : "central",
                                 shiftDown = flav == 0 ? "down_" + bTagSyst[bSyst] : "central";
 
@@ -427,6 +461,8 @@ class SFAnalyzer : public BaseAnalyzer<T> {
                 out.subJetTightDeepJetSF[i] = bTagSF->at("deepJet" + postFix)->evaluate({"central", "T", flav, std::abs(out.subJetEta[i]), out.subJetPt[i]});
 
                 for(int bSyst = 0; bSyst < bTagSyst.size(); ++bSyst){
+                    if(!subJetBTagSystWanted[bSyst]) continue;
+
                     std::string shiftUp = flav != 0 ? "up_" + bTagSyst[bSyst] : "central",
                                 shiftDown = flav != 0 ? "down_" + bTagSyst[bSyst] : "central";
 
@@ -446,6 +482,8 @@ class SFAnalyzer : public BaseAnalyzer<T> {
                 }
 
                 for(int bSyst = 0; bSyst < bTagSystLight.size(); ++bSyst){
+                    if(!subJetBTagSystLightWanted[bSyst]) continue;
+
                     std::string shiftUp = flav == 0 ? "up_" + bTagSyst[bSyst] : "central",
                                 shiftDown = flav == 0 ? "down_" + bTagSyst[bSyst] : "central";
 
@@ -14,9 +14,7 @@ class TriggerAnalyzer : public BaseAnalyzer<T> {
             input.ReadTrigger();
             input.GetTrigger();
         
-            for(std::size_t i = 0; i < input.triggers.size(); ++i){
-                out.triggers[i] = input.triggers[i];
-            }
+            std::copy(input.triggerMask.begin(), input.triggerMask.end(), out.triggerMask.begin());
         }
 
         void EndJob(const std::shared_ptr<TFile>& outFile){};
@@ -1,6 +1,7 @@
 #ifndef WEIGHTANALYZER_H
 #define WEIGHTANALYZER_H
 
+#include <TH1D.h>
 #include <TParameter.h>
 
 #include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
@@ -12,6 +13,13 @@ class WeightAnalyzer : public BaseAnalyzer<T> {
         TParameter<float> lumi, lumiUp, lumiDown, xSec, xSecUp, xSecDown;
         float nGen;
 
+        //Sums over all generated events for the normalization of the weight variations
+        double sumGenWeight, sumGenWeightSign, sumPreFire, sumPreFireUp, sumPreFireDown;
+        double sumPdfWeight[102], sumScaleWeight[8];
+
+        //Variations multiplied with the generator weight, for samples with negative weights
+        double sumPdfWeightGen[102], sumScaleWeightGen[8];
+
         std::shared_ptr<TH1F> puMC;
 
     public:
@@ -33,6 +41,15 @@ class WeightAnalyzer : public BaseAnalyzer<T> {
             xSecDown  = TParameter<float>("xSecDown", skim.get<float>("xSec") - skim.get<float>("xSecUnc"));
 
             nGen = 0;
+            sumGenWeight = 0;
+            sumGenWeightSign = 0;
+            sumPreFire = 0;
+            sumPreFireUp = 0;
+            sumPreFireDown = 0;
+            std::fill_n(sumPdfWeight, 102, 0);
+            std::fill_n(sumScaleWeight, 8, 0);
+            std::fill_n(sumPdfWeightGen, 102, 0);
+            std::fill_n(sumScaleWeightGen, 8, 0);
 
             //Histogram for MC PileUp distribution
             puMC = std::make_shared<TH1F>("puMC", "puMC", 100, 0, 100);
@@ -49,6 +66,23 @@ class WeightAnalyzer : public BaseAnalyzer<T> {
                 out.nTrueInt = input.nTrueInt;
                 nGen += 1;
 
+                //Analyzers run before any cut, so every generated event enters the sums
+                sumGenWeight += input.genWeight;
+                sumGenWeightSign += (input.genWeight > 0) - (input.genWeight < 0);
+                sumPreFire += input.preFire;
+                sumPreFireUp += input.preFireUp;
+                sumPreFireDown += input.preFireDown;
+
+                for(int i = 0; i < 102; ++i){
+                    sumPdfWeight[i] += input.pdfWeight[i];
+                    sumPdfWeightGen[i] += double(input.genWeight) * input.pdfWeight[i];
+                }
+
+                for(int i = 0; i < 8; ++i){
+                    sumScaleWeight[i] += input.scaleWeight[i];
+                    sumScaleWeightGen[i] += double(input.genWeight) * input.scaleWeight[i];
+                }
+
                 puMC->Fill(out.nTrueInt);
             }
             
@@ -76,6 +110,30 @@ class WeightAnalyzer : public BaseAnalyzer<T> {
                 }
 
                 TParameter<float>("nGen", nGen).Write();
+                TParameter<double>("sumGenWeight", sumGenWeight).Write();
+                TParameter<double>("sumGenWeightSign", sumGenWeightSign).Write();
+                TParameter<double>("sumPreFire", sumPreFire).Write();
+                TParameter<double>("sumPreFireUp", sumPreFireUp).Write();
+                TParameter<double>("sumPreFireDown", sumPreFireDown).Write();
+
+                //Bin i + 1 is the sum of variation i
+                TH1D sumPdf("sumPdfWeight", "sumPdfWeight", 102, 0, 102), sumScale("sumScaleWeight", "sumScaleWeight", 8, 0, 8);
+                TH1D sumPdfGen("sumPdfWeightGen", "sumPdfWeightGen", 102, 0, 102), sumScaleGen("sumScaleWeightGen", "sumScaleWeightGen", 8, 0, 8);
+
+                for(int i = 0; i < 102; ++i){
+                    sumPdf.SetBinContent(i + 1, sumPdfWeight[i]);
+                    sumPdfGen.SetBinContent(i + 1, sumPdfWeightGen[i]);
+                }
+
+                for(int i = 0; i < 8; ++i){
+                    sumScale.SetBinContent(i + 1, sumScaleWeight[i]);
+                    sumScaleGen.SetBinContent(i + 1, sumScaleWeightGen[i]);
+                }
+
+                sumPdf.Write();
+                sumScale.Write();
+                sumPdfGen.Write();
+                sumScaleGen.Write();
                 xSec.Write();
                 xSecUp.Write();
                 xSecDown.Write();
@@ -0,0 +1,54 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include <TTree.h>
+
+#include <ChargedSkimming/Core/interface/output.h>
+
+/// Fills the output trees on a separate thread. The event loop packs the booked
+/// members of each selected event (variable sized arrays only up to their size)
+/// into a ring of byte buffers, the writer thread unpacks them into the output
+/// bound to the tree branches and fills/compresses the trees. If the ring is
+/// full, Push blocks until the writer has freed a buffer.
+
+class AsyncWriter {
+    private:
+        //Trees and the output class their branches are bound to
+        std::vector<std::shared_ptr<TTree>> trees;
+        std::shared_ptr<Output> treeOutput;
+
+        //Ring of packed events and which trees have to be filled for each of them
+        std::vector<std::vector<char>> snapshots;
+        std::vector<std::vector<char>> passed;
+        std::size_t head = 0, tail = 0, nQueued = 0;
+
+        //Synchronisation between event loop and writer thread
+        std::mutex mutex;
+        std::condition_variable notFull, notEmpty;
+        bool closed = false;
+        std::exception_ptr error;
+
+        //Statistics
+        std::size_t nWritten = 0, nWaits = 0;
+
+        std::thread worker;
+
+        void Run();
+
+    public:
+        AsyncWriter(const std::vector<std::shared_ptr<TTree>>& trees, const std::shared_ptr<Output>& treeOutput, const std::size_t& nSnapshots);
+        ~AsyncWriter();
+
+        void Push(const Output& out, const std::vector<char>& passed);
+        void Drain();
+        void Close();
+};
+
+#endif
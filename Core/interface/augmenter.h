@@ -0,0 +1,117 @@
+#ifndef AUGMENTER_H
+#define AUGMENTER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <experimental/filesystem>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <ChargedSkimming/Core/interface/output.h>
+#include <ChargedSkimming/Core/interface/skiminput.h>
+
+#include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
+#include <ChargedSkimming/Analyzer/interface/sfanalyzer.h>
+
+namespace pt = boost::property_tree;
+
+/// Reruns selected analyzers on existing skims. For each channel the skim tree
+/// is read back into the output, the analyzers are run and only branches which
+/// do not exist in the skim yet are written into a friend tree with the same
+/// name and entry order. The friend is joined by entry without an index, since
+/// event numbers alone repeat across runs.
+
+class Augmenter {
+    private:
+        std::vector<std::string> channels, analyzerNames, branches;
+        std::string era, run;
+
+        std::shared_ptr<BaseAnalyzer<SkimInput>> MakeAnalyzer(const std::string& name){
+            //Only analyzers which work on the output alone can run on skims
+            if(name == "SF") return std::make_shared<SFAnalyzer<SkimInput>>();
+
+            throw std::runtime_error("Analyzer '" + name + "' needs NanoAOD input and can not run on skims (supported: SF)");
+        }
+
+    public:
+        Augmenter(const std::vector<std::string>& channels, const std::string& era, const std::string& run, const std::vector<std::string>& analyzerNames, const std::vector<std::string>& branches) : channels(channels), analyzerNames(analyzerNames), branches(branches), era(era), run(run) {}
+
+        void Run(const std::string& fileName, const std::string& outDir, const std::string& outFile){
+            //Read in json config
+            pt::ptree sf, skim; 
+            pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+            pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/sf.json", sf);
+
+            bool isData = run != "MC";
+
+            skim.put<std::string>("run", run);
+            skim.put<std::string>("era", era);
+            skim.put<bool>("isData", isData);
+
+            for(const std::string& channel : channels){
+                std::string inName = fileName, outD = outDir;
+                if(inName.find("[C]") != std::string::npos) inName.replace(inName.find("[C]"), 3, channel);
+                if(outD.find("[C]") != std::string::npos) outD.replace(outD.find("[C]"), 3, channel);
+                std::experimental::filesystem::create_directories(outD);
+
+                SkimInput input(inName, channel);
+
+                std::shared_ptr<TFile> file = std::make_shared<TFile>((outD + "/" + outFile).c_str(), "RECREATE");
+                std::shared_ptr<TTree> tree = std::make_shared<TTree>(channel.c_str(), channel.c_str());
+                tree->SetDirectory(file.get());
+
+                //Existing branches are not written again, the event number is kept to cross-check the entry alignment
+                std::vector<std::string> keep = branches, drop = input.BranchNames();
+                keep.push_back("Misc_eventNumber");
+                drop.erase(std::remove(drop.begin(), drop.end(), "Misc_eventNumber"), drop.end());
+
+                Output output;
+                output.AddBranchSelection(channel, keep, drop);
+                output.AttachInput(input.GetTree());
+                output.ReadEncoding(skim);
+
+                for(const std::string& name : {"Weight", "Electron", "Muon", "Jet", "Isotrack", "Misc"}){
+                    output.Register(name, {tree}, skim, isData);
+                }
+
+                std::vector<std::shared_ptr<BaseAnalyzer<SkimInput>>> analyzer;
+
+                for(const std::string& name : analyzerNames){
+                    analyzer.push_back(MakeAnalyzer(name));
+                    analyzer.back()->BeginJob(skim, sf);
+                }
+
+                std::cout << "Augment tree: " << channel << " from " << inName << " (" << input.GetEntries() << " events)" << std::endl;
+
+                for(std::size_t entry = 0; entry < input.GetEntries(); ++entry){
+                    input.SetEntry(entry);
+                    input.ReadEntry();
+
+                    for(std::shared_ptr<BaseAnalyzer<SkimInput>>& a : analyzer){
+                        a->Analyze(input, output);
+                    }
+
+                    output.Encode();
+                    tree->Fill();
+                }
+
+                for(std::shared_ptr<BaseAnalyzer<SkimInput>>& a : analyzer){
+                    a->EndJob(file);
+                }
+
+                file->cd();
+                tree->Write();
+
+                std::cout << "Written friend tree: " << channel << " to " << file->GetName() << std::endl;
+            }
+        }
+};
+
+#endif
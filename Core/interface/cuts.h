@@ -3,44 +3,116 @@
 
 #include <vector>
 #include <string>
-#include <functional>
-#include <memory>		
+#include <memory>
+#include <numeric>
+#include <cstdint>
 
 #include <TFile.h>
 #include <TH1F.h>
 
 #include <ChargedSkimming/Core/interface/output.h>
 
+/// Selection of all channels compiled into one table of distinct predicates.
+/// Each predicate is evaluated once per event, each channel is a list of
+/// predicate indices. Cutflow and N-1 counts are integer counters, which are
+/// converted into histograms only when writing the output.
+
 class Cuts{
     private:
-        std::shared_ptr<TH1F> cutFlow;
-        std::vector<std::function<bool()>> cuts;
-        std::vector<std::string> cutNames;
+        enum Operation {Equal, GreaterEqual, LessEqual, TriggerOr, METFilterAnd, Veto};
+
+        struct Predicate {
+            std::string key;
+            Operation op;
+
+            //Object multiplicity cuts
+            const short* value = nullptr;
+            short threshold = 0;
+
+            //Trigger/MET filter cuts
+            const std::vector<std::uint64_t>* word = nullptr;
+            std::vector<std::uint64_t> mask;
+
+            //Veto cuts, passed if the flag is not set
+            const char* flag = nullptr;
+        };
+
+        struct Channel {
+            std::string name;
+            std::shared_ptr<TFile> outFile;
 
-        std::function<bool()> ConstructCut(short& value, const std::string& op, const short& threshold);
+            std::vector<std::size_t> program;
+            std::vector<std::string> cutNames;
+
+            //Index 0 of the cutflow is "No cuts", N-1 index i belongs to the i-th cut
+            std::vector<long long> cutflow, nMinusOne;
+            bool passed = false;
+        };
+
+        std::vector<Predicate> predicates;
+        std::vector<char> results;
+        std::vector<Channel> channels;
+
+        std::size_t AddPredicate(const Predicate& predicate);
+        void Insert(const std::size_t& channel, const std::size_t& predicate, const std::string& cutName, const bool& front);
+
+        //Bit mask with the given bits set, one word per 64 bits
+        static std::vector<std::uint64_t> BitMask(const std::vector<int>& bits, const std::size_t& nWords){
+            std::vector<std::uint64_t> mask(nWords, 0);
+            for(const int& bit : bits) mask[bit/64] |= std::uint64_t(1) << bit%64;
+
+            return mask;
+        }
 
     public:
         Cuts(){}
-        Cuts(const std::shared_ptr<TFile>& outFile, const std::string& channel);
-        void AddCut(const std::string& part, Output& out, const std::string& op, const short& threshold);
+
+        std::size_t AddChannel(const std::shared_ptr<TFile>& outFile, const std::string& channel);
+        void AddCut(const std::size_t& channel, const std::string& part, Output& out, const std::string& op, const short& threshold);
 
         template <typename T>
-        void AddTrigger(const std::vector<int>& triggerIdx, T& input){
+        void AddTrigger(const std::size_t& channel, const std::vector<int>& triggerIdx, T& input){
+            Predicate p;
+
+            //Trigger: any of the channel triggers fired (OR mask)
             if(triggerIdx.size() != 0){
-                cuts.insert(cuts.begin(), [&input, triggerIdx](){for(const int& idx : triggerIdx){if(input.triggers[idx]) return true;} return false;});
-                cutNames.insert(cutNames.begin(), "Trigger");
+                p.op = TriggerOr;
+                p.word = &input.triggerMask;
+                p.mask = BitMask(triggerIdx, input.triggerMask.size());
+                p.key = "Trigger";
+                for(const std::uint64_t& m : p.mask) p.key += ":" + std::to_string(m);
+
+                Insert(channel, AddPredicate(p), "Trigger", true);
             }
 
+            //MET filter: all registered filters passed (AND mask)
             else{
-                cuts.insert(cuts.begin(), [&input](){for(const bool& passed : input.METFilter){if(!passed) return false;} return true;});
-                cutNames.insert(cutNames.begin(), "MET Filter");
+                std::vector<int> filterIdx(input.METFilterNames.size());
+                std::iota(filterIdx.begin(), filterIdx.end(), 0);
+
+                p.op = METFilterAnd;
+                p.word = &input.METFilterMask;
+                p.mask = BitMask(filterIdx, input.METFilterMask.size());
+                p.key = "METFilter";
+
+                Insert(channel, AddPredicate(p), "MET Filter", true);
             }
         }
 
-        bool Passed();
-        void Count(){cutFlow->Fill("No cuts", 1);};
-        void FillCutflow();
-        void WriteOutput(){cutFlow->Write();};
+        //Cut in front of all others, which is passed if the flag (set per event by the caller) is not set
+        void AddVeto(const std::size_t& channel, const std::string& cutName, const char* flag);
+
+        //Evaluate all predicates once and update the counters of all channels
+        void Evaluate();
+        bool Passed(const std::size_t& channel) const {return channels[channel].passed;}
+
+        //Events skipped without evaluation (known to fail all channels) still count as "No cuts"
+        void CountSkipped(const long long& nSkipped){
+            for(Channel& c : channels) c.cutflow[0] += nSkipped;
+        }
+
+        //Write Cutflow_<channel> and NMinusOne_<channel> histograms into the channel output files
+        void WriteOutput();
 };
 
 #endif
@@ -0,0 +1,56 @@
+#ifndef EVENTINDEX_H
+#define EVENTINDEX_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <TTree.h>
+
+/// (run, event) -> entry index of a NanoAOD file, build in one pass over the run,
+/// luminosityBlock and event branches only. If a cache directory is given, the index
+/// is stored as binary sidecar named by a FNV-1a hash of the input file name and
+/// reused by later skims, so single events can be skimmed without a full scan.
+/// The sidecar stores the UUID and size of the input file, so a file replaced under
+/// the same name (with the same number of entries) is not matched with a stale index.
+///
+/// Layout: header | input file name | records sorted by (run, event)
+
+class EventIndex {
+    public:
+        struct Record {
+            std::uint32_t run, lumi;
+            std::uint64_t event, entry;
+
+            bool operator<(const Record& other) const {
+                return run != other.run ? run < other.run : event < other.event;
+            }
+        };
+
+    private:
+        static constexpr char magic[8] = {'E', 'V', 'T', 'I', 'D', 'X', '0', '2'};
+
+        struct Header {
+            char magic[8];
+            std::uint64_t nEntries, nRecords, fileSize, nameLength;
+            char uuid[40];
+        };
+
+        std::string fileName, sideCar, uuid;
+        long long nEntries, fileSize = 0;
+        std::vector<Record> records;
+
+        bool Load();
+        void Write();
+
+    public:
+        EventIndex(const std::string& cacheDir, const std::string& fileName, TTree* tree);
+
+        //Events of a list with one "run:lumi:event" (or "run:event") per line, '#' starts a comment
+        static std::vector<Record> ReadEventList(const std::string& listName);
+
+        //Sorted entries of the given events, events not in the file are reported and skipped
+        std::vector<std::size_t> Find(const std::vector<Record>& events) const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef EVENTSET_H
+#define EVENTSET_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+/// Read-only set of (run, luminosity block, event) used to drop events already
+/// contained in a skim of a primary dataset with higher priority. Events are
+/// partitioned by run and luminosity block, the event numbers of a partition are
+/// stored sorted, so an event costs 8 bytes and a lookup two binary searches.
+/// The file is memory-mapped, so it can be shared by all jobs on a machine.
+///
+/// Layout: header | partitions (run, lumi, first, count) sorted by (run, lumi) | event numbers
+
+class EventSet {
+    public:
+        struct Event {
+            std::uint32_t run, lumi;
+            std::uint64_t event;
+
+            bool operator<(const Event& other) const {
+                if(run != other.run) return run < other.run;
+                if(lumi != other.lumi) return lumi < other.lumi;
+                return event < other.event;
+            }
+
+            bool operator==(const Event& other) const {return run == other.run and lumi == other.lumi and event == other.event;}
+        };
+
+    private:
+        static constexpr char magic[8] = {'E', 'V', 'T', 'S', 'E', 'T', '0', '1'};
+
+        struct Header {
+            char magic[8];
+            std::uint64_t nPartitions, nEvents;
+        };
+
+        struct Partition {
+            std::uint32_t run, lumi;
+            std::uint64_t first, count;
+        };
+
+        Util::MappedFile file;
+        const char* data = nullptr;
+        std::size_t size = 0;
+
+        Header header;
+        const Partition* partitions = nullptr;
+        const std::uint64_t* events = nullptr;
+
+    public:
+        EventSet(const std::string& fileName);
+
+        EventSet(const EventSet&) = delete;
+        EventSet& operator=(const EventSet&) = delete;
+
+        std::size_t Size() const {return header.nEvents;}
+        bool Contains(const std::uint32_t& run, const std::uint32_t& lumi, const std::uint64_t& event) const;
+
+        //Write the (unsorted, possibly duplicated) events into a set file
+        static void Write(std::vector<Event>& events, const std::string& fileName);
+};
+
+#endif
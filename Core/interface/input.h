@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include <ChargedSkimming/Skimming/interface/util.h>
 
@@ -11,12 +12,12 @@
 struct Input{
     public:
         //Weight related
-        float pdfWeight[102], scaleWeight[8];
+        float pdfWeight[102], scaleWeight[8], genWeight;
         short nTrueInt;
 
-        //Trigger related
-        std::vector<short> triggers;
-        std::vector<short> METFilter;
+        //Trigger related, one bit per registered path/filter (64 per word)
+        std::vector<std::string> triggerNames, METFilterNames;
+        std::vector<std::uint64_t> triggerMask, METFilterMask;
 
         //Electron related
         short eleSize, eleCharge, eleCutID, eleMVAID, eleConvVeto;
@@ -47,9 +48,14 @@ struct Input{
 
         //Misc related
         short nParton;
-        long evNr;
+        unsigned long long evNr;
+        unsigned int runNr, lumiNr;
         float preFire, preFireUp, preFireDown;
 
+        //Source of the event, file name and entry in the original NanoAOD tree
+        std::string fileName;
+        unsigned long long inputEntry;
+
         //Gen part related
         short genSize, genPDG, genMotherIdx;
         float genPt, genPhi, genEta, genMass;
@@ -0,0 +1,49 @@
+#ifndef IOPROFILE_H
+#define IOPROFILE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace pt = boost::property_tree;
+
+/// Output I/O profile read from "Output.Profiles.<name>" of the skim config.
+/// Assigns compression settings and basket sizes to groups of branches
+/// (matched by glob patterns, first matching group wins) and distributes a
+/// total auto-flush budget in bytes over the channel trees according to their
+/// selection rate measured during the first events.
+
+class IOProfile {
+    private:
+        struct Group {
+            std::vector<std::string> patterns;
+            int compression;
+            int basketSize;
+        };
+
+        std::string name;
+        std::vector<Group> groups;
+
+        //Auto-flush budget summed over all channels, lower bound per channel and number of events used to measure selection rates
+        long long flushBytes = 0, minFlushBytes = 0;
+        std::size_t warmupEvents = 0;
+
+    public:
+        IOProfile(){}
+        IOProfile(const pt::ptree& skim, const std::string& name);
+
+        static int CompressionSettings(const std::string& algorithm, const int& level);
+
+        void Apply(TTree* tree) const;
+        void SetAutoFlush(const std::vector<std::shared_ptr<TTree>>& trees) const;
+        void AdaptAutoFlush(const std::vector<std::shared_ptr<TTree>>& trees, const std::vector<std::size_t>& nPassed) const;
+
+        const std::string& Name() const {return name;}
+        std::size_t WarmupEvents() const {return warmupEvents;}
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef NANOCACHE_H
+#define NANOCACHE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <TTree.h>
+#include <TLeaf.h>
+
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+/// Local, uncompressed copy of the NanoAOD branches read by NanoInput.
+/// Events are stored in blocks, inside a block each column is contiguous.
+/// Array columns are indexed by the offset table of their counter column,
+/// which holds the prefix sum of the counts of all events in the block.
+/// The file is memory-mapped for reading, values are read in place.
+///
+/// Layout: header | blocks | column table | block table (offset per block and column)
+
+class NanoCache {
+    public:
+        struct Column {
+            std::string name;
+            char type;
+            std::uint32_t elementSize;
+            std::int32_t count;
+        };
+
+        //Type codes of the stored columns, Count marks the offset table of a collection
+        enum Type : char {Float = 'F', Double = 'D', Int = 'I', UInt = 'i', Short = 'S', UShort = 's', Char = 'B', UChar = 'b', Bool = 'O', Long = 'L', ULong = 'l', Count = 'C'};
+
+    private:
+        //Last character is the format version, version 2 caches always contain the run number
+        static constexpr char magic[8] = {'N', 'A', 'N', 'O', 'C', 'C', 'H', '2'};
+
+        struct Header {
+            char magic[8];
+            std::uint64_t nEntries, nSource, blockSize, nColumns, indexOffset;
+        };
+
+        Util::MappedFile file;
+        const char* data = nullptr;
+        std::size_t size = 0;
+
+        Header header;
+        std::vector<Column> columns;
+        std::vector<std::uint64_t> blockOffsets;
+
+    public:
+        NanoCache(const std::string& fileName);
+
+        NanoCache(const NanoCache&) = delete;
+        NanoCache& operator=(const NanoCache&) = delete;
+
+        //Number of cached events and of events in the source file (differs if the trigger pre-filter was used)
+        std::size_t GetEntries() const {return header.nEntries;}
+        std::size_t GetSourceEntries() const {return header.nSource;}
+
+        //Index of column, -1 if not cached
+        int FindColumn(const std::string& name) const;
+        const Column& GetColumn(const int& column) const {return columns[column];}
+
+        //Pointer to the values of an event and their number
+        const char* Values(const int& column, const std::size_t& entry, std::size_t& len) const {
+            std::size_t block = entry / header.blockSize, local = entry % header.blockSize;
+            const Column& c = columns[column];
+            const char* values = data + blockOffsets[block * header.nColumns + column];
+
+            if(c.count < 0){
+                len = 1;
+                return values + local * c.elementSize;
+            }
+
+            const std::uint32_t* offsets = reinterpret_cast<const std::uint32_t*>(data + blockOffsets[block * header.nColumns + c.count]);
+            len = offsets[local + 1] - offsets[local];
+
+            return values + offsets[local] * c.elementSize;
+        }
+
+        static double Value(const char* values, const char& type, const std::size_t& idx){
+            switch(type){
+                case Float: return reinterpret_cast<const float*>(values)[idx];
+                case Double: return reinterpret_cast<const double*>(values)[idx];
+                case Int: return reinterpret_cast<const std::int32_t*>(values)[idx];
+                case UInt: return reinterpret_cast<const std::uint32_t*>(values)[idx];
+                case Short: return reinterpret_cast<const std::int16_t*>(values)[idx];
+                case UShort: return reinterpret_cast<const std::uint16_t*>(values)[idx];
+                case Char: return reinterpret_cast<const std::int8_t*>(values)[idx];
+                case UChar: return reinterpret_cast<const std::uint8_t*>(values)[idx];
+                case Bool: return reinterpret_cast<const bool*>(values)[idx];
+                case Long: return reinterpret_cast<const std::int64_t*>(values)[idx];
+                case ULong: return reinterpret_cast<const std::uint64_t*>(values)[idx];
+                case Count: return reinterpret_cast<const std::uint32_t*>(values)[idx + 1] - reinterpret_cast<const std::uint32_t*>(values)[idx];
+                default: return 0;
+            }
+        }
+
+        //Write the given leaves of the tree into a cache file, if triggers are given only events firing any of them are kept
+        static void Build(TTree* tree, const std::vector<std::string>& leafNames, const std::vector<std::string>& filterTriggers, const std::string& outName, const std::size_t& blockSize);
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef NANOGENERATOR_H
+#define NANOGENERATOR_H
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include <TTree.h>
+#include <TRandom3.h>
+
+/// Writes a synthetic NanoAOD "Events" tree with every branch resolved by
+/// NanoInput, so the skimmer can be run and benchmarked without grid files.
+/// Objects are pt ordered with exponentially falling spectra, for MC the
+/// GenPart collection holds a ttbar decay chain (with intermediate copies)
+/// which the reconstructed leptons and jets are matched to.
+
+class NanoGenerator {
+    public:
+        struct Config {
+            std::size_t nEvents = 10000;
+            unsigned int seed = 42;
+            bool isData = false;
+
+            //Mean object multiplicities (Poisson) and probability of each trigger/MET filter to fire
+            float nElectrons = 1, nMuons = 1, nJets = 5, nFatJets = 1, nIsotracks = 1;
+            float triggerRate = 0.3, filterRate = 0.99;
+
+            std::vector<std::string> triggers, METFilters;
+        };
+
+        //Presets "ttbar" (MC with full gen record) and "data" (lower multiplicities, no gen/LHE branches)
+        static Config Preset(const std::string& name);
+
+    private:
+        static constexpr std::size_t maxSize = 256;
+
+        //Struct of arrays of one collection, booked with the counter branch n<name>
+        struct Collection {
+            std::string name;
+            unsigned int size = 0;
+
+            std::map<std::string, std::vector<float>> floats;
+            std::map<std::string, std::vector<int>> ints;
+            std::map<std::string, std::vector<char>> bools;
+            std::map<std::string, std::vector<unsigned char>> uchars;
+
+            Collection(const std::string& name, const std::vector<std::string>& floatNames, const std::vector<std::string>& intNames = {}, const std::vector<std::string>& boolNames = {}, const std::vector<std::string>& ucharNames = {});
+            void Book(TTree* tree);
+        };
+
+        Config config;
+        TRandom3 random;
+
+        std::map<std::string, Collection> collections;
+
+        //Event level quantities
+        unsigned int run, luminosityBlock;
+        unsigned long long event;
+        unsigned char LHENjets;
+        float nTrueInt, genWeight, preFire, preFireUp, preFireDown, rho, METPt, METPhi, METDeltaX, METDeltaY;
+        std::vector<char> triggers, METFilters;
+
+        float Pt(const float& min, const float& slope){return min + random.Exp(slope);}
+        std::size_t Multiplicity(const float& mean){return std::min(std::size_t(random.Poisson(mean)), maxSize);}
+
+        //Adds a gen particle and returns its index
+        int AddGenPart(const int& pdgId, const int& mother, const float& pt, const float& eta, const float& phi, const float& mass);
+
+        void FillGen();
+        void FillObjects();
+
+    public:
+        NanoGenerator(const Config& config);
+
+        void Write(const std::string& fileName);
+};
+
+#endif
@@ -9,137 +9,166 @@
 #include <TFile.h>
 #include <TLeaf.h>
 #include <TTree.h>
+#include <TTreePerfStats.h>
+#include <TRandom3.h>
 #include <Math/Vector4D.h>
 
 #include <ChargedSkimming/Core/interface/input.h>
+#include <ChargedSkimming/Core/interface/zonemap.h>
+#include <ChargedSkimming/Core/interface/eventindex.h>
+#include <ChargedSkimming/Core/interface/nanocache.h>
+#include <ChargedSkimming/Core/interface/nanoleaf.h>
+#include <ChargedSkimming/Core/interface/tracer.h>
 
 class NanoInput : public Input {
     private:
         std::shared_ptr<TFile> inputFile;
         std::shared_ptr<TTree> inputTree;
 
+        //Memory-mapped cache used instead of the input tree (if configured)
+        std::shared_ptr<NanoCache> cache;
+        std::vector<std::shared_ptr<NanoLeaf>> leaves;
+        NanoLeaf* GetLeaf(const std::string& name);
+
         //Weight related
-        TLeaf* pdfWeightL;
-        TLeaf* scaleWeightL;
-        TLeaf* nTrueIntL;
+        NanoLeaf* pdfWeightL;
+        NanoLeaf* scaleWeightL;
+        NanoLeaf* nTrueIntL;
+        NanoLeaf* genWeightL;
 
         //Trigger related
-        std::vector<TLeaf*> triggerL;
-        std::vector<TLeaf*> METFilterL;
+        std::vector<NanoLeaf*> triggerL;
+        std::vector<NanoLeaf*> METFilterL;
         
         //Electron related
-        TLeaf* elePtL;
-        TLeaf* eleECorrL;
-        TLeaf* eleScaleUpL;
-        TLeaf* eleScaleDownL;
-        TLeaf* eleSigmaUpL;
-        TLeaf* eleSigmaDownL;
-        TLeaf* eleMassL;
-        TLeaf* eleEtaL;
-        TLeaf* elePhiL;
-        TLeaf* eleIso03L;
-        TLeaf* eleIso04L;
-        TLeaf* eleMiniIsoL;
-        TLeaf* eleChargeL;
-        TLeaf* eleCutIDL;
-        TLeaf* eleMVAIDLooseL;
-        TLeaf* eleMVAIDMediumL;
-        TLeaf* eleMVAIDTightL;
-        TLeaf* eleDxyL;
-        TLeaf* eleDzL;
-        TLeaf* eleConvVetoL;
-        TLeaf* eleRelJetIsoL;
+        NanoLeaf* elePtL;
+        NanoLeaf* eleECorrL;
+        NanoLeaf* eleScaleUpL;
+        NanoLeaf* eleScaleDownL;
+        NanoLeaf* eleSigmaUpL;
+        NanoLeaf* eleSigmaDownL;
+        NanoLeaf* eleMassL;
+        NanoLeaf* eleEtaL;
+        NanoLeaf* elePhiL;
+        NanoLeaf* eleIso03L;
+        NanoLeaf* eleIso04L;
+        NanoLeaf* eleMiniIsoL;
+        NanoLeaf* eleChargeL;
+        NanoLeaf* eleCutIDL;
+        NanoLeaf* eleMVAIDLooseL;
+        NanoLeaf* eleMVAIDMediumL;
+        NanoLeaf* eleMVAIDTightL;
+        NanoLeaf* eleDxyL;
+        NanoLeaf* eleDzL;
+        NanoLeaf* eleConvVetoL;
+        NanoLeaf* eleRelJetIsoL;
 
         ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double>> eleP4;
 
         //Muon related
-        TLeaf* muPtL;
-        TLeaf* muEtaL;
-        TLeaf* muPhiL;
-        TLeaf* muChargeL;
-        TLeaf* muMiniIsoL;
-        TLeaf* muIso03L;
-        TLeaf* muIso04L;
-        TLeaf* muCutIDLooseL;
-        TLeaf* muCutIDMediumL;
-        TLeaf* muCutIDTightL;
-        TLeaf* muMVAIDL;
-        TLeaf* muDxyL;
-        TLeaf* muDzL;
-        TLeaf* muRelJetIsoL;
-        TLeaf* muNTrackerLayersL;
+        NanoLeaf* muPtL;
+        NanoLeaf* muEtaL;
+        NanoLeaf* muPhiL;
+        NanoLeaf* muChargeL;
+        NanoLeaf* muMiniIsoL;
+        NanoLeaf* muIso03L;
+        NanoLeaf* muIso04L;
+        NanoLeaf* muCutIDLooseL;
+        NanoLeaf* muCutIDMediumL;
+        NanoLeaf* muCutIDTightL;
+        NanoLeaf* muMVAIDL;
+        NanoLeaf* muDxyL;
+        NanoLeaf* muDzL;
+        NanoLeaf* muRelJetIsoL;
+        NanoLeaf* muNTrackerLayersL;
+
+        //Own generator for the Rochester correction, the global gRandom is shared by the jobs of the server mode
+        TRandom3 random;
 
         //Jet related
-        TLeaf* rhoL;
-
-        TLeaf* metPtL;
-        TLeaf* metPhiL;
-        TLeaf* metDeltaUnClustXL;
-        TLeaf* metDeltaUnClustYL;
-
-        TLeaf* jetPtL;
-        TLeaf* jetEtaL;
-        TLeaf* jetPhiL;
-        TLeaf* jetMassL;
-        TLeaf* jetAreaL;
-        TLeaf* jetDeepJetL;
-        TLeaf* jetDeepCSVL;
-        TLeaf* jetPartFlavL;
-        TLeaf* jetRawFacL;
-        TLeaf* jetIDL;
-        TLeaf* jetPUIDL;
-
-        TLeaf* genJetPtL;
-        TLeaf* genJetEtaL;
-        TLeaf* genJetPhiL;
-
-        TLeaf* fatJetPtL;
-        TLeaf* fatJetEtaL;
-        TLeaf* fatJetPhiL;
-        TLeaf* fatJetMassL;
-        TLeaf* fatJetAreaL;
-        TLeaf* fatJetTau1L;
-        TLeaf* fatJetTau2L;
-        TLeaf* fatJetTau3L;
-        TLeaf* fatJetDAK8HiggsL;
-        TLeaf* fatJetDAK8QCDL;
-        TLeaf* fatJetDAK8TvsQCDL;
-        TLeaf* fatJetDAK8ZvsQCDL;
-        TLeaf* fatJetDAK8WvsQCDL;
-        TLeaf* fatJetRawFacL;
-
-        TLeaf* genFatJetPtL;
-        TLeaf* genFatJetEtaL;
-        TLeaf* genFatJetPhiL;
+        NanoLeaf* rhoL;
+
+        NanoLeaf* metPtL;
+        NanoLeaf* metPhiL;
+        NanoLeaf* metDeltaUnClustXL;
+        NanoLeaf* metDeltaUnClustYL;
+
+        NanoLeaf* jetPtL;
+        NanoLeaf* jetEtaL;
+        NanoLeaf* jetPhiL;
+        NanoLeaf* jetMassL;
+        NanoLeaf* jetAreaL;
+        NanoLeaf* jetDeepJetL;
+        NanoLeaf* jetDeepCSVL;
+        NanoLeaf* jetPartFlavL;
+        NanoLeaf* jetRawFacL;
+        NanoLeaf* jetIDL;
+        NanoLeaf* jetPUIDL;
+
+        NanoLeaf* genJetPtL;
+        NanoLeaf* genJetEtaL;
+        NanoLeaf* genJetPhiL;
+
+        NanoLeaf* fatJetPtL;
+        NanoLeaf* fatJetEtaL;
+        NanoLeaf* fatJetPhiL;
+        NanoLeaf* fatJetMassL;
+        NanoLeaf* fatJetAreaL;
+        NanoLeaf* fatJetTau1L;
+        NanoLeaf* fatJetTau2L;
+        NanoLeaf* fatJetTau3L;
+        NanoLeaf* fatJetDAK8HiggsL;
+        NanoLeaf* fatJetDAK8QCDL;
+        NanoLeaf* fatJetDAK8TvsQCDL;
+        NanoLeaf* fatJetDAK8ZvsQCDL;
+        NanoLeaf* fatJetDAK8WvsQCDL;
+        NanoLeaf* fatJetRawFacL;
+
+        NanoLeaf* genFatJetPtL;
+        NanoLeaf* genFatJetEtaL;
+        NanoLeaf* genFatJetPhiL;
 
         //Iso. track related
-        TLeaf* isotrkPtL;
-        TLeaf* isotrkPhiL;
-        TLeaf* isotrkEtaL;
-        TLeaf* isotrkDxyL;
-        TLeaf* isotrkDzL;
-        TLeaf* isotrkPDGL;
-        TLeaf* isotrkIso03L;
-        TLeaf* isotrkIso04L;
-        TLeaf* isotrkMiniIsoL;
+        NanoLeaf* isotrkPtL;
+        NanoLeaf* isotrkPhiL;
+        NanoLeaf* isotrkEtaL;
+        NanoLeaf* isotrkDxyL;
+        NanoLeaf* isotrkDzL;
+        NanoLeaf* isotrkPDGL;
+        NanoLeaf* isotrkIso03L;
+        NanoLeaf* isotrkIso04L;
+        NanoLeaf* isotrkMiniIsoL;
 
         //Misc related
-        TLeaf* evNrL;
-        TLeaf* nPartonL;
-        TLeaf* preFireL;
-        TLeaf* preFireUpL;
-        TLeaf* preFireDownL;
+        NanoLeaf* evNrL;
+        NanoLeaf* runNrL;
+        NanoLeaf* lumiNrL;
+        NanoLeaf* nPartonL;
+        NanoLeaf* preFireL;
+        NanoLeaf* preFireUpL;
+        NanoLeaf* preFireDownL;
+        NanoLeaf* cacheEntryL;
 
         //Gen part related
-        TLeaf* genPDGL;
-        TLeaf* genMotherIdxL;
-        TLeaf* genPtL;
-        TLeaf* genPhiL; 
-        TLeaf* genEtaL;
-        TLeaf* genMassL;
+        NanoLeaf* genPDGL;
+        NanoLeaf* genMotherIdxL;
+        NanoLeaf* genPtL;
+        NanoLeaf* genPhiL; 
+        NanoLeaf* genEtaL;
+        NanoLeaf* genMassL;
 
         std::size_t entry;
 
+        //Cluster summary used to skip unselectable events (if configured)
+        std::shared_ptr<ZoneMap> zoneMap;
+
+        //Spans of the collection reads (if configured)
+        Tracer* tracer = nullptr;
+
+        //Read statistics of the input tree and of each leaf (if configured)
+        std::shared_ptr<TTreePerfStats> perfStats;
+        bool countReads = false;
+
         //Helper function https://www.wolframalpha.com/input/?i=h%2F%28h%2Bt%29+%3D+s+solve+for+h
         float demangleDK8(const float& AvsB, const float& B){
             if(AvsB != 1. and B != 0){
@@ -152,9 +181,26 @@ class NanoInput : public Input {
         }
 
     public:
-        NanoInput(const std::string& fileName, const std::string& treeName);
+        NanoInput(const std::string& fileName, const std::string& treeName, const std::string& cacheFile = "");
         void SetEntry(const std::size_t& entry){this->entry = entry;}
-        std::size_t GetEntries(){return inputTree->GetEntries();}
+        std::size_t GetEntries(){return cache ? cache->GetEntries() : inputTree->GetEntries();}
+
+        //Names of all leaves resolved so far and number of events dropped by the pre-filter of the cache
+        std::vector<std::string> LeafNames() const;
+        std::size_t PrefilteredEntries() const {return cache ? cache->GetSourceEntries() - cache->GetEntries() : 0;}
+
+        void SetZoneMap(const std::string& cacheDir, const std::vector<ZoneRequirement>& requirements);
+        std::size_t ZoneMapEntry(const std::size_t& entry);
+        void WriteZoneMap();
+
+        //Sorted entries of the events in the event list, looked up with a (persistent) event index (data only)
+        std::vector<std::size_t> EventListEntries(const std::string& eventList, const std::string& indexDir, const bool& isData);
+
+        void SetTracer(Tracer* tracer){this->tracer = tracer;}
+
+        //Ranked report of read cost per leaf and of resolved leaves never used
+        void EnableIOReport();
+        void WriteIOReport(const std::string& fileName);
 
         void SetWeight();
         void GetWeightEntry();
@@ -181,6 +227,7 @@ class NanoInput : public Input {
         void GetIsotrk(const std::size_t& idx);
 
         void ReadMiscEntry(const bool& isData);
+        void ReadRunEntry();
         void GetMisc();
 
         void ReadGenEntry();
@@ -0,0 +1,82 @@
+#ifndef NANOLEAF_H
+#define NANOLEAF_H
+
+#include <string>
+#include <chrono>
+
+#include <TLeaf.h>
+#include <TBranch.h>
+
+#include <ChargedSkimming/Core/interface/nanocache.h>
+
+/// Single NanoAOD leaf read either from the input TTree or from a memory-mapped
+/// NanoCache. Offers the subset of the TLeaf/TBranch interface used by NanoInput.
+
+class NanoLeaf {
+    private:
+        std::string name;
+
+        //TTree backend
+        TLeaf* leaf = nullptr;
+
+        //Cache backend
+        const NanoCache* cache = nullptr;
+        int column = -1;
+        char type = 0;
+        const char* values = nullptr;
+        std::size_t len = 0;
+
+        long long readEntry = -1;
+
+        //Read statistics for the I/O report (if enabled)
+        bool countReads = false;
+        long long nReads = 0, bytesRead = 0, readTime = 0;
+        mutable long long nValues = 0;
+
+    public:
+        NanoLeaf(const std::string& name, TLeaf* leaf) : name(name), leaf(leaf) {}
+        NanoLeaf(const std::string& name, const NanoCache* cache, const int& column) : name(name), cache(cache), column(column), type(cache->GetColumn(column).type) {}
+
+        const std::string& GetName() const {return name;}
+
+        void GetEntry(const std::size_t& entry){
+            if(countReads){
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+                if(leaf != nullptr) bytesRead += leaf->GetBranch()->GetEntry(entry);
+                else{
+                    values = cache->Values(column, entry, len);
+                    bytesRead += len * cache->GetColumn(column).elementSize;
+                }
+
+                readTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                ++nReads;
+            }
+
+            else if(leaf != nullptr) leaf->GetBranch()->GetEntry(entry);
+            else values = cache->Values(column, entry, len);
+
+            readEntry = entry;
+        }
+
+        long long GetReadEntry() const {return readEntry;}
+        int GetLen() const {return leaf != nullptr ? leaf->GetLen() : len;}
+        double GetValue(const int& idx = 0) const {if(countReads) ++nValues; return leaf != nullptr ? leaf->GetValue(idx) : NanoCache::Value(values, type, idx);}
+
+        template <typename T>
+        T GetTypedValue(const int& idx = 0) const {if(countReads) ++nValues; return leaf != nullptr ? leaf->GetTypedValue<T>(idx) : T(NanoCache::Value(values, type, idx));}
+
+        void CountReads(const bool& countReads){this->countReads = countReads;}
+        long long GetReads() const {return nReads;}
+        long long GetBytesRead() const {return bytesRead;}
+        long long GetReadTime() const {return readTime;}
+        long long GetValuesUsed() const {return nValues;}
+
+        //Compression factor of the branch on disk, 1 for the uncompressed cache
+        double GetCompression() const {
+            if(leaf == nullptr or leaf->GetBranch()->GetZipBytes() == 0) return 1.;
+            return double(leaf->GetBranch()->GetTotBytes()) / leaf->GetBranch()->GetZipBytes();
+        }
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <vector>
 #include <memory>
 #include <array>
+#include <cstdint>
+#include <map>
+#include <set>
 
 #include <TTree.h>
 #include <TH1F.h>
@@ -19,14 +22,70 @@ const int jetMax = 20;
 const int fatJetMax = 5;
 const int isotrkMax = 20;
 
+//Keep/drop glob patterns per output tree and names of all booked branches
+struct BranchSelection {
+    std::map<std::string, std::vector<std::string>> keep, drop;
+    std::set<std::string> booked;
+};
+
+//Storage encodings read from "Output.Encoding" (glob patterns, first match wins)
+struct BranchEncoding {
+    struct Float16 {
+        std::vector<std::string> patterns;
+        float min, max;
+        int bits;
+    };
+
+    std::vector<Float16> float16;
+    std::vector<std::string> int8;
+};
+
+//Short array of the output (byte offset in the class) written as 8-bit integers from the packed buffer
+struct PackedShort {
+    std::size_t offset, size, packedOffset;
+};
+
+//Booked member copied to the asynchronous writer, variable sized arrays only up to their counter
+struct OutputSlice {
+    char* address;
+    std::size_t elementSize, maxSize;
+    const short* counter;
+};
+
 class Output {
+    private:
+        //Shared between copies of the output
+        std::shared_ptr<BranchSelection> selection;
+        std::shared_ptr<BranchEncoding> encoding;
+
+        //Buffers for encoded branches, filled by Encode() before the trees are filled
+        std::vector<PackedShort> packedShorts;
+        std::vector<char> packed;
+
+        //Existing skim tree read into the output (augment mode)
+        std::shared_ptr<TTree> inputTree;
+
+        //Booked members in booking order, only recorded without booking branches if slicesOnly
+        std::vector<OutputSlice> slices;
+        bool slicesOnly = false;
+
+        //Counter member and maximum size for each counter branch of variable sized arrays
+        std::map<std::string, std::pair<short*, std::size_t>> Counters();
+        void AddSlice(void* address, const std::string& leafList);
+
+        std::string EncodeLeafList(const std::string& name, void*& address, const std::string& leafList);
+        void ReadBranch(const std::string& name, void* address, const std::string& leafList);
+
+        bool IsKept(const std::string& treeName, const std::string& branchName) const;
+        void Book(const std::shared_ptr<TTree>& tree, const std::string& name, void* address, const std::string& leafList);
+
     public:
         //Weights
         short nTrueInt;
         float pdfWeight[102], scaleWeight[8];
 
-        //Trigger
-        std::vector<short> triggers; 
+        //Trigger decisions, one bit per path (64 per word)
+        std::vector<std::uint64_t> triggerMask;
 
         //Electron related stuff
         std::array<float, eleMax> elePt, elePtEnergyScaleUp, 
@@ -45,6 +104,8 @@ class Output {
         std::array<short, eleMax> eleCutID, eleMVAID, eleCharge, 
                                   eleGenID, eleGenMotherID, eleGenGrandMotherID;
 
+        std::array<short, eleMax> eleInputIdx;
+
         short nElectrons;
 
         //Muon related stuff
@@ -63,6 +124,8 @@ class Output {
         std::array<short, muMax> muCutID, muMVAID, muCharge, 
                                  muGenID, muGenMotherID, muGenGrandMotherID;
 
+        std::array<short, muMax> muInputIdx;
+
         short nMuons;
 
         //Jet related stuff
@@ -136,7 +199,8 @@ class Output {
                                   jetGenID, jetGenMotherID, jetGenGrandMotherID,
                                   subJetGenID, subJetGenMotherID, subJetGenGrandMotherID;
               
-        std::array<short, fatJetMax> fatJetDAK8ID;
+        std::array<short, fatJetMax> fatJetDAK8ID, fatJetInputIdx;
+        std::array<short, jetMax> jetInputIdx, subJetInputIdx;
 
         short nJets, nSubJets, nFatJets;
 
@@ -145,18 +209,46 @@ class Output {
                                      isotrkDxy, isotrkDz, 
                                      isotrkIso03, isotrkMiniIso;
 
-        std::array<short, isotrkMax> isotrkPDG, isotrkCharge;
+        std::array<short, isotrkMax> isotrkPDG, isotrkCharge, isotrkInputIdx;
 
         short isotrkSize;
 
         //Misc related
         short nParton;
 
-        long evNr;
+        unsigned long long evNr, inputEntry;
+        unsigned int runNr, lumiNr;
 
         float preFire, preFireUp, preFireDown;
 
 
+        //Read keep/drop lists from "Channel.<channel>.Branches" for each tree (tree name == channel),
+        //in virtual mode ("Output.Virtual") the keep list of the virtual mode is used for all trees
+        void ReadBranchSelection(const pt::ptree& skim, const std::vector<std::shared_ptr<TTree>>& trees);
+
+        //Set keep/drop lists of a single tree
+        void AddBranchSelection(const std::string& treeName, const std::vector<std::string>& keep, const std::vector<std::string>& drop);
+
+        //Bind the branches of an existing skim tree to the same members while registering, so the output can be read from it
+        void AttachInput(const std::shared_ptr<TTree>& tree){inputTree = tree;}
+
+        //Read storage encodings from "Output.Encoding", has to be called before registering the branches
+        void ReadEncoding(const pt::ptree& skim);
+
+        //Fill the buffers of encoded branches, has to be called before filling the trees
+        void Encode();
+
+        //Register only records the booked members, so the output of the analyzers can be packed for the writer thread
+        void SetSlicesOnly(){slicesOnly = true;}
+        std::size_t NSlices() const {return slices.size();}
+
+        //Copy the booked members into/from a buffer, packing and unpacking output need the same booking
+        void Pack(std::vector<char>& buffer) const;
+        void Unpack(const std::vector<char>& buffer);
+
+        //Check if any booked branch matches the glob pattern, so analyzers can skip unused quantities
+        bool IsWanted(const std::string& pattern) const;
+
         //Function to attach branches to output trees
         void RegisterTrigger(const std::vector<std::string>& triggerNames, const std::vector<std::shared_ptr<TTree>>& trees);
         void Register(const std::string& name, const std::vector<std::shared_ptr<TTree>>& trees, pt::ptree& skim, const bool& isData = false);
@@ -0,0 +1,80 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/// Hardware performance counters (cycles, instructions, cache and branch
+/// misses) per stage of the event loop, read as one perf_event_open group
+/// of the current thread. If the counters can not be opened (no Linux, no
+/// permission by perf_event_paranoid, virtual machine without PMU) the
+/// collector is disabled and all scopes are no-ops.
+
+class PerfCounters {
+    public:
+        static constexpr std::size_t nCounters = 4;
+
+        //Raw (unscaled) counts and the times the group was enabled and running, all cumulative since the counters were enabled
+        struct Values {
+            std::array<std::uint64_t, nCounters> counts = {};
+            std::uint64_t enabled = 0, running = 0;
+        };
+
+        //Adds the counts between construction and destruction to the stage, no-op if the counters are null or unavailable
+        class Scope {
+            private:
+                PerfCounters* counters;
+                std::size_t stage;
+                Values start;
+
+            public:
+                Scope(PerfCounters* counters, const std::size_t& stage) : counters(counters != nullptr and counters->Available() ? counters : nullptr), stage(stage) {
+                    if(this->counters != nullptr) this->counters->Read(start);
+                }
+
+                ~Scope(){
+                    if(counters != nullptr) counters->Add(stage, start);
+                }
+        };
+
+    private:
+        static const std::array<std::string, nCounters> counterNames;
+
+        //File descriptor of the group leader and position of each counter in the group (-1 if not opened)
+        int leader = -1;
+        std::vector<int> fds;
+        std::array<int, nCounters> position;
+        std::size_t nOpened = 0;
+
+        //Set if the PMU time-shared the counters with other events, counts are then scaled estimates
+        bool multiplexed = false;
+
+        struct Stage {
+            std::string name;
+            long long calls = 0;
+            std::array<std::uint64_t, nCounters> counts = {};
+        };
+
+        std::vector<Stage> stages;
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool Available() const {return leader >= 0;}
+
+        std::size_t AddStage(const std::string& name);
+
+        void Read(Values& values) const;
+        void Add(const std::size_t& stage, const Values& start);
+
+        void Print() const;
+        void WriteReport(const std::string& fileName) const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include <TFile.h>
+
+/// Wall time per stage of the event loop (each analyzer, cut evaluation, tree
+/// filling). Every call is counted in a logarithmic latency histogram with four
+/// bins per power of two nanoseconds, so totals and tail percentiles are
+/// available at the end of the job at the cost of two clock reads per call.
+/// Instrumentation is only compiled in for a timing build, which is not the default:
+/// scram b -j 8 USER_CXXFLAGS="-DSKIM_TIMING" (see SKIM_TIME below).
+
+class Profiler {
+    public:
+        //Adds the time between construction and destruction to the stage
+        class Scope {
+            private:
+                Profiler& profiler;
+                std::size_t stage;
+                std::chrono::steady_clock::time_point start;
+
+            public:
+                Scope(Profiler& profiler, const std::size_t& stage) : profiler(profiler), stage(stage), start(std::chrono::steady_clock::now()) {}
+                ~Scope(){profiler.Add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());}
+        };
+
+    private:
+        static constexpr std::size_t nBins = 4 * 48;
+
+        struct Stage {
+            std::string name;
+            long long calls = 0;
+            double total = 0;
+            std::vector<long long> histogram = std::vector<long long>(nBins, 0);
+        };
+
+        std::vector<Stage> stages;
+
+        //Bin i covers [2^(i/4), 2^((i+1)/4)) ns, sub-bins from the two bits below the leading one
+        static std::size_t Bin(const long long& ns){
+            if(ns < 2) return 0;
+
+            int octave = 63 - __builtin_clzll(ns);
+            std::size_t sub = octave >= 2 ? (ns >> (octave - 2)) & 3 : (ns << (2 - octave)) & 3;
+
+            return std::min(4 * std::size_t(octave) + sub, nBins - 1);
+        }
+
+        static double LowEdge(const std::size_t& bin){
+            return std::ldexp(1. + (bin % 4) / 4., bin / 4);
+        }
+
+    public:
+        Profiler(){}
+
+        std::size_t AddStage(const std::string& name);
+
+        void Add(const std::size_t& stage, const long long& ns){
+            Stage& s = stages[stage];
+            ++s.calls;
+            s.total += ns;
+            ++s.histogram[Bin(ns)];
+        }
+
+        //Latency in ns below which the fraction q of all calls lies
+        double Percentile(const std::size_t& stage, const double& q) const;
+
+        void Print() const;
+        void WriteOutput(const std::shared_ptr<TFile>& outFile) const;
+        void WriteReport(const std::string& fileName) const;
+};
+
+#ifdef SKIM_TIMING
+    #define SKIM_TIME(profiler, stage) Profiler::Scope skimTimeScope(profiler, stage)
+#else
+    #define SKIM_TIME(profiler, stage)
+#endif
+
+#endif
@@ -0,0 +1,275 @@
+#ifndef REPLAYINPUT_H
+#define REPLAYINPUT_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+#include <ChargedSkimming/Core/interface/input.h>
+
+/// Input state of captured events held in memory, so single analyzers can be
+/// benchmarked without any TFile/TTree cost. Capture() calls all Read/Get
+/// functions of another input (e.g. NanoInput) for each event and stores the
+/// resulting Input fields per object, ReplayInput offers the same interface
+/// and copies them back.
+///
+/// Records are written as they are in memory, so they are declared without
+/// padding and the file starts with the record sizes, which are checked on read.
+
+class ReplayInput : public Input {
+    public:
+        //Input fields set by one Get call of each collection
+        struct Electron {
+            short charge, cutID, MVAID, convVeto;
+            float pt, ptSigmaUp, ptSigmaDown, ptScaleUp, ptScaleDown, eta, phi, dxy, dz, relJetIso, iso03, iso04, miniIso;
+        };
+
+        struct Muon {
+            short charge, cutID, MVAID, nTrackerLayers;
+            float pt, eta, phi, dxy, dz, relJetIso, iso03, iso04, miniIso;
+        };
+
+        struct Jet {
+            short ID, PUID;
+            float pt, mass, ptRaw, massRaw, eta, phi, area, deepJet, deepCSV, partFlav;
+        };
+
+        struct FatJet {
+            short DAK8ID, reserved;
+            float pt, mass, ptRaw, massRaw, eta, phi, area, tau1, tau2, tau3;
+        };
+
+        struct GenJet {
+            float pt, eta, phi;
+        };
+
+        struct Isotrk {
+            short PDG, reserved;
+            float pt, eta, phi, dxy, dz, iso03, iso04, miniIso;
+        };
+
+        struct GenPart {
+            short PDG, motherIdx;
+            float pt, phi, eta, mass;
+        };
+
+        //Event level fields
+        struct Scalars {
+            std::uint64_t evNr, inputEntry;
+            std::uint32_t runNr, lumiNr;
+            float pdfWeight[102], scaleWeight[8], genWeight;
+            float preFire, preFireUp, preFireDown, rho, metPt, metPhi, metDeltaUnClustX, metDeltaUnClustY, muRandomNumber;
+            short nTrueInt, nParton, reserved[2];
+        };
+
+    private:
+        static constexpr char magic[8] = {'R', 'E', 'P', 'L', 'A', 'Y', '0', '5'};
+
+        //Record sizes stored in the file, a file written with another layout is rejected
+        static constexpr std::uint32_t recordSizes[8] = {sizeof(Scalars), sizeof(Electron), sizeof(Muon), sizeof(Jet), sizeof(FatJet), sizeof(GenJet), sizeof(Isotrk), sizeof(GenPart)};
+
+        //Objects of all events, objects of event i are [offset[i], offset[i+1])
+        template <typename R>
+        struct Collection {
+            std::vector<R> objects;
+            std::vector<std::uint32_t> offset = {0};
+
+            std::size_t Size(const std::size_t& entry) const {return offset[entry + 1] - offset[entry];}
+            const R& Get(const std::size_t& entry, const std::size_t& idx) const {return objects[offset[entry] + idx];}
+        };
+
+        std::vector<Scalars> scalars;
+        std::vector<std::uint64_t> triggerMasks, METFilterMasks;
+        Collection<Electron> electrons;
+        Collection<Muon> muons;
+        Collection<Jet> jets;
+        Collection<FatJet> fatJets;
+        Collection<GenJet> genJets, genFatJets;
+        Collection<Isotrk> isotrks;
+        Collection<GenPart> genParts;
+
+        bool isData;
+        std::size_t entry = 0;
+
+        //Fill/write the in memory record
+        void AddEvent();
+        void Write(const std::string& fileName);
+
+        template <typename R>
+        static void WriteCollection(std::ofstream& out, const Collection<R>& c);
+
+        template <typename R>
+        void ReadCollection(std::ifstream& in, Collection<R>& c);
+
+        ReplayInput() {}
+
+    public:
+        ReplayInput(const std::string& fileName);
+
+        bool IsData() const {return isData;}
+        void SetEntry(const std::size_t& entry){this->entry = entry;}
+        std::size_t GetEntries(){return scalars.size();}
+
+        //Capture the given entries or the first nEvents events of an input with the NanoInput interface
+        template <typename T>
+        static void Capture(T& input, const std::vector<std::size_t>& entries, const bool& isData, const std::string& fileName);
+
+        template <typename T>
+        static void Capture(T& input, const std::size_t& nEvents, const bool& isData, const std::string& fileName){
+            std::vector<std::size_t> entries;
+            for(std::size_t entry = 0; entry < std::min(nEvents, input.GetEntries()); ++entry) entries.push_back(entry);
+
+            Capture(input, entries, isData, fileName);
+        }
+
+        void SetWeight(){}
+        void GetWeightEntry();
+
+        void SetTrigger(const std::vector<std::string>& names, const bool& isMETFilter){}
+        void ReadTrigger(){}
+        void ReadMETFilter(){}
+        void GetTrigger();
+        void GetMETFilter();
+
+        void ReadEleEntry(){eleSize = electrons.Size(entry);}
+        void GetElectron(const std::size_t& idx);
+
+        void ReadMuEntry(){muSize = muons.Size(entry); muRandomNumber = scalars[entry].muRandomNumber;}
+        void GetMuon(const std::size_t& idx);
+
+        void ReadJetEntry(const bool& isData);
+        void GetJet(const std::size_t& idx);
+        void GetFatJet(const std::size_t& idx);
+        void GetGenJet(const std::size_t& idx);
+        void GetGenFatJet(const std::size_t& idx);
+
+        void ReadIsotrkEntry(){isotrkSize = isotrks.Size(entry);}
+        void GetIsotrk(const std::size_t& idx);
+
+        void ReadMiscEntry(const bool& isData){}
+        void ReadRunEntry(){runNr = scalars[entry].runNr;}
+        void GetMisc();
+
+        void ReadGenEntry(){genSize = genParts.Size(entry); alreadyMatchedIdx.clear();}
+        void GetGenPart(const std::size_t& idx);
+};
+
+//No padding bytes, so no uninitialized memory is written to the file
+static_assert(sizeof(ReplayInput::Scalars) == 3*8 + 120*4 + 4*2, "ReplayInput::Scalars has padding");
+static_assert(sizeof(ReplayInput::Electron) == 4*2 + 13*4, "ReplayInput::Electron has padding");
+static_assert(sizeof(ReplayInput::Muon) == 4*2 + 9*4, "ReplayInput::Muon has padding");
+static_assert(sizeof(ReplayInput::Jet) == 2*2 + 10*4, "ReplayInput::Jet has padding");
+static_assert(sizeof(ReplayInput::FatJet) == 2*2 + 10*4, "ReplayInput::FatJet has padding");
+static_assert(sizeof(ReplayInput::GenJet) == 3*4, "ReplayInput::GenJet has padding");
+static_assert(sizeof(ReplayInput::Isotrk) == 2*2 + 8*4, "ReplayInput::Isotrk has padding");
+static_assert(sizeof(ReplayInput::GenPart) == 2*2 + 4*4, "ReplayInput::GenPart has padding");
+
+template <typename T>
+void ReplayInput::Capture(T& input, const std::vector<std::size_t>& entries, const bool& isData, const std::string& fileName){
+    ReplayInput replay;
+    replay.isData = isData;
+    replay.triggerNames = input.triggerNames;
+    replay.METFilterNames = input.METFilterNames;
+
+    for(const std::size_t& entry : entries){
+        input.SetEntry(entry);
+        Scalars s{};
+
+        if(!isData){
+            input.SetWeight();
+            input.GetWeightEntry();
+
+            std::copy(std::begin(input.pdfWeight), std::end(input.pdfWeight), std::begin(s.pdfWeight));
+            std::copy(std::begin(input.scaleWeight), std::end(input.scaleWeight), std::begin(s.scaleWeight));
+            s.nTrueInt = input.nTrueInt;
+            s.genWeight = input.genWeight;
+            s.preFire = input.preFire;
+            s.preFireUp = input.preFireUp;
+            s.preFireDown = input.preFireDown;
+        }
+
+        input.ReadTrigger();
+        input.GetTrigger();
+        replay.triggerMasks.insert(replay.triggerMasks.end(), input.triggerMask.begin(), input.triggerMask.end());
+
+        input.ReadMETFilter();
+        input.GetMETFilter();
+        replay.METFilterMasks.insert(replay.METFilterMasks.end(), input.METFilterMask.begin(), input.METFilterMask.end());
+
+        input.ReadEleEntry();
+        for(int i = 0; i < input.eleSize; ++i){
+            input.GetElectron(i);
+            replay.electrons.objects.push_back({input.eleCharge, input.eleCutID, input.eleMVAID, input.eleConvVeto, input.elePt, input.elePtSigmaUp, input.elePtSigmaDown, input.elePtScaleUp, input.elePtScaleDown,
+                                                input.eleEta, input.elePhi, input.eleDxy, input.eleDz, input.eleRelJetIso, input.eleIso03, input.eleIso04, input.eleMiniIso});
+        }
+
+        input.ReadMuEntry();
+        s.muRandomNumber = input.muRandomNumber;
+
+        for(int i = 0; i < input.muSize; ++i){
+            input.GetMuon(i);
+            replay.muons.objects.push_back({input.muCharge, input.muCutID, input.muMVAID, input.muNTrackerLayers, input.muPt, input.muEta, input.muPhi, input.muDxy, input.muDz, input.muRelJetIso, input.muIso03, input.muIso04, input.muMiniIso});
+        }
+
+        input.ReadJetEntry(isData);
+        s.rho = input.rho;
+        s.metPt = input.metPt;
+        s.metPhi = input.metPhi;
+        s.metDeltaUnClustX = input.metDeltaUnClustX;
+        s.metDeltaUnClustY = input.metDeltaUnClustY;
+
+        for(int i = 0; i < input.jetSize; ++i){
+            input.GetJet(i);
+            replay.jets.objects.push_back({input.jetID, input.jetPUID, input.jetPt, input.jetMass, input.jetPtRaw, input.jetMassRaw, input.jetEta, input.jetPhi, input.jetArea, input.jetDeepJet, input.jetDeepCSV, input.jetPartFlav});
+        }
+
+        for(int i = 0; i < input.fatJetSize; ++i){
+            input.GetFatJet(i);
+            replay.fatJets.objects.push_back({input.fatJetDAK8ID, 0, input.fatJetPt, input.fatJetMass, input.fatJetPtRaw, input.fatJetMassRaw, input.fatJetEta, input.fatJetPhi, input.fatJetArea, input.fatJetTau1, input.fatJetTau2, input.fatJetTau3});
+        }
+
+        input.ReadIsotrkEntry();
+        for(int i = 0; i < input.isotrkSize; ++i){
+            input.GetIsotrk(i);
+            replay.isotrks.objects.push_back({input.isotrkPDG, 0, input.isotrkPt, input.isotrkEta, input.isotrkPhi, input.isotrkDxy, input.isotrkDz, input.isotrkIso03, input.isotrkIso04, input.isotrkMiniIso});
+        }
+
+        input.ReadMiscEntry(isData);
+        input.GetMisc();
+        input.ReadRunEntry();
+        s.nParton = input.nParton;
+        s.evNr = input.evNr;
+        s.runNr = input.runNr;
+        s.lumiNr = input.lumiNr;
+        s.inputEntry = input.inputEntry;
+
+        if(!isData){
+            for(int i = 0; i < input.genJetSize; ++i){
+                input.GetGenJet(i);
+                replay.genJets.objects.push_back({input.genJetPt, input.genJetEta, input.genJetPhi});
+            }
+
+            for(int i = 0; i < input.genFatJetSize; ++i){
+                input.GetGenFatJet(i);
+                replay.genFatJets.objects.push_back({input.genFatJetPt, input.genFatJetEta, input.genFatJetPhi});
+            }
+
+            input.ReadGenEntry();
+            for(int i = 0; i < input.genSize; ++i){
+                input.GetGenPart(i);
+                replay.genParts.objects.push_back({input.genPDG, input.genMotherIdx, input.genPt, input.genPhi, input.genEta, input.genMass});
+            }
+        }
+
+        replay.scalars.push_back(s);
+        replay.AddEvent();
+    }
+
+    replay.Write(fileName);
+}
+
+#endif
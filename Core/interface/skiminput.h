@@ -0,0 +1,38 @@
+#ifndef SKIMINPUT_H
+#define SKIMINPUT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <ChargedSkimming/Core/interface/input.h>
+#include <ChargedSkimming/Core/interface/output.h>
+
+/// Input adapter over the channel tree of an existing skim. The skim branches
+/// are read directly into an output class (see Output::AttachInput), so
+/// analyzers which only work on the output (e.g. SFAnalyzer) can be rerun
+/// on skims without going back to NanoAOD.
+
+class SkimInput : public Input {
+    private:
+        std::shared_ptr<TFile> inputFile;
+        std::shared_ptr<TTree> inputTree;
+
+        std::size_t entry;
+
+    public:
+        SkimInput(const std::string& fileName, const std::string& treeName);
+        void SetEntry(const std::size_t& entry){this->entry = entry;}
+        std::size_t GetEntries(){return inputTree->GetEntries();}
+
+        std::shared_ptr<TTree> GetTree(){return inputTree;}
+        std::vector<std::string> BranchNames();
+
+        //Read all branches bound to the output
+        void ReadEntry();
+};
+
+#endif
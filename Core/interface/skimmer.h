@@ -5,18 +5,32 @@
 #include <string>
 #include <memory>
 #include <iostream>
+#include <functional>
 #include <experimental/filesystem>
 
+#include <TROOT.h>
 #include <TFile.h>
 #include <TTree.h>
+#include <TNamed.h>
+#include <TList.h>
+#include <TEntryList.h>
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 #include <ChargedSkimming/Core/interface/output.h>
 #include <ChargedSkimming/Core/interface/cuts.h>
+#include <ChargedSkimming/Core/interface/asyncwriter.h>
+#include <ChargedSkimming/Core/interface/ioprofile.h>
+#include <ChargedSkimming/Core/interface/zonemap.h>
+#include <ChargedSkimming/Core/interface/profiler.h>
+#include <ChargedSkimming/Core/interface/tracer.h>
+#include <ChargedSkimming/Core/interface/perfcounters.h>
+#include <ChargedSkimming/Core/interface/sloweventrecorder.h>
+#include <ChargedSkimming/Core/interface/eventset.h>
 
 #include <ChargedSkimming/Analyzer/interface/baseanalyzer.h>
+#include <ChargedSkimming/Analyzer/interface/correctioncache.h>
 #include <ChargedSkimming/Analyzer/interface/triggeranalyzer.h>
 #include <ChargedSkimming/Analyzer/interface/metfilteranalyzer.h>
 #include <ChargedSkimming/Analyzer/interface/electronanalyzer.h>
@@ -36,9 +50,44 @@ class Skimmer{
         std::vector<std::shared_ptr<TFile>> outFiles;
         std::vector<std::shared_ptr<TTree>> outTrees;
 
+        //Asynchronous filling of the output trees (if configured)
+        std::shared_ptr<Output> treeOutput;
+        std::shared_ptr<AsyncWriter> writer;
+        std::vector<char> passed;
+
+        //Compression/auto-flush profile of the output trees (if configured)
+        std::shared_ptr<IOProfile> profile;
+        std::vector<std::size_t> nPassed;
+        std::size_t nProcessed = 0;
+
+        //Virtual mode: selected NanoAOD entries per channel, trees only hold computed quantities
+        std::vector<std::shared_ptr<TEntryList>> entryLists;
+
         //Core classes used for skimming
-        std::vector<Cuts> cuts;
+        Cuts cuts;
+        std::vector<ZoneRequirement> zoneRequirements;
         std::vector<std::shared_ptr<BaseAnalyzer<T>>> analyzer;
+        std::vector<std::string> analyzerNames;
+
+        //Wall time per analyzer/cuts/filling (only measured if compiled with SKIM_TIMING)
+        Profiler profiler;
+        std::vector<std::size_t> analyzerStages;
+        std::size_t cutStage, fillStage;
+        std::string timingReport;
+
+        //Timeline of sampled events (if configured)
+        std::shared_ptr<Tracer> tracer;
+
+        //Hardware counters per stage (if configured), stages are the analyzers followed by cuts and fill
+        std::shared_ptr<PerfCounters> counters;
+        std::string counterReport;
+
+        //Entries and stage times of the slowest events (if configured), same stages as the counters
+        std::shared_ptr<SlowEventRecorder> recorder;
+
+        //Events already skimmed from a primary dataset with higher priority
+        std::shared_ptr<const EventSet> dedupSet;
+        char duplicate = false;
 
         //Input information
         std::vector<std::string> channels;
@@ -48,14 +97,41 @@ class Skimmer{
     public:
         Skimmer(const std::vector<std::string>& channels, const std::string& xSec, const std::string& xSecUnc, const std::string& era, const std::string& run) : channels(channels), xSec(xSec), xSecUnc(xSecUnc), era(era), run(run) {}
 
+        //Read in json config, shared by all skims of the process
+        static pt::ptree ReadConfig(const std::string& name){
+            std::string fileName = std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/" + name;
+
+            return *CorrectionCache::Get<pt::ptree>("Config/" + fileName, [&](){
+                std::shared_ptr<pt::ptree> config = std::make_shared<pt::ptree>();
+                pt::read_json(fileName, *config);
+                return config;
+            });
+        }
+
+        //Analyzers in the order they run, later analyzers use the output of earlier ones
+        static std::vector<std::shared_ptr<BaseAnalyzer<T>>> MakeAnalyzers(){
+            return {
+                std::make_shared<TriggerAnalyzer<T>>(),
+                std::make_shared<METFilterAnalyzer<T>>(),
+                std::make_shared<JetAnalyzer<T>>(),
+                std::make_shared<ElectronAnalyzer<T>>(),
+                std::make_shared<MuonAnalyzer<T>>(),
+                std::make_shared<IsotrkAnalyzer<T>>(),
+                std::make_shared<WeightAnalyzer<T>>(),
+                std::make_shared<MiscAnalyzer<T>>(),
+                std::make_shared<SFAnalyzer<T>>(),
+            };
+        }
+
         void Configure(T& input, Output& output, const std::string& outDir, const std::string& outFile){
-            //Read in json config
-            pt::ptree sf, skim; 
-            pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
-            pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/sf.json", sf);
+            pt::ptree sf = ReadConfig("sf.json"), skim = ReadConfig("skim.json");
+
+            //Trees are filled on a writer thread (if configured), so ROOT has to be thread safe before the output files are created
+            std::size_t nSnapshots = skim.get<std::size_t>("Output.AsyncSnapshots", 0);
+            if(nSnapshots != 0) ROOT::EnableThreadSafety();
 
             //Trigger/METFilter names
-            std::vector<std::string> triggerNames;
+            std::vector<std::string> triggerNames = Util::TriggerNames(skim, era, channels);
 
             for(const std::string& channel : channels){
                 //Open output file and create trees
@@ -70,20 +146,33 @@ class Skimmer{
                 outTrees.back()->SetDirectory(outFiles.back().get());
                 outTrees.back()->SetAutoFlush(10000);
 
-                //Read out trigger needed and register in cut class
-                for(const std::string& name : Util::GetVector<std::string>(skim, "Channel." + channel + ".Trigger." + era)){
-                    if(std::find(triggerNames.begin(), triggerNames.end(), name) == triggerNames.end()) triggerNames.push_back(name);
-                }
-
-                //Define cut class
-                cuts.push_back(Cuts(outFiles.back(), channel));
+                //Register channel in cut class
+                std::size_t channelIdx = cuts.AddChannel(outFiles.back(), channel);
 
                 //Register cut requirements
                 std::string path = "Channel." + channel + ".Selection";
+                ZoneRequirement requirement;
+                requirement.triggers = Util::GetVector<std::string>(skim, "Channel." + channel + ".Trigger." + era);
 
                 for(const std::string part : Util::GetKeys(skim, path)){
-                    cuts.back().AddCut(part, output, skim.get<std::string>(path + "." + part + ".operator"), skim.get<short>(path + "." + part + ".threshold"));
+                    std::string op = skim.get<std::string>(path + "." + part + ".operator");
+                    short threshold = skim.get<short>(path + "." + part + ".threshold");
+
+                    cuts.AddCut(channelIdx, part, output, op, threshold);
+
+                    //Lower bound on the number of objects in the input collection
+                    if(op == "<=") continue;
+                    if(part == "Electron") requirement.minElectrons = threshold;
+                    else if(part == "Muon") requirement.minMuons = threshold;
+                    else if(part == "Jet") requirement.minJets = threshold;
+                    else if(part == "FatJet") requirement.minFatJets = threshold;
                 }
+
+                //A selected muon passed the pt cut with its uncorrected pt, so the leading input lepton has to pass it as well.
+                //Selected electrons can pass it with a scale/smearing variation only, so they give no bound on the input pt
+                if(requirement.minMuons > 0) requirement.minLeptonPt = skim.get<float>("Analyzer.Muon.pt." + era);
+
+                zoneRequirements.push_back(requirement);
             }
 
             //Register trigger to input class (Only thing which is needed to register for input class)
@@ -101,8 +190,8 @@ class Skimmer{
                 }
        
                 //Input class instead output class is used to register cut for trigger!
-                cuts[i].AddTrigger<T>({}, input);
-                cuts[i].AddTrigger<T>(triggerIdx, input);
+                cuts.AddTrigger<T>(i, {}, input);
+                cuts.AddTrigger<T>(i, triggerIdx, input);
             }
 
             //Add. information for analyzer
@@ -114,51 +203,188 @@ class Skimmer{
             skim.put<std::string>("era", era);
             skim.put<bool>("isData", isData);
 
-            //Register branches to output trees
-            output.RegisterTrigger(triggerNames, outTrees);
-            output.Register("Weight", outTrees, skim, isData);
-            output.Register("Electron", outTrees, skim, isData);
-            output.Register("Muon", outTrees, skim, isData);
-            output.Register("Jet", outTrees, skim, isData);
-            output.Register("Isotrack", outTrees, skim, isData);
-            output.Register("Misc", outTrees, skim, isData);
+            //Register branches to output trees, branches dropped for a channel are not booked in its tree
+            std::function<void(Output&)> registerBranches = [&](Output& out){
+                out.ReadBranchSelection(skim, outTrees);
+                out.RegisterTrigger(triggerNames, outTrees);
+                out.Register("Weight", outTrees, skim, isData);
+                out.Register("Electron", outTrees, skim, isData);
+                out.Register("Muon", outTrees, skim, isData);
+                out.Register("Jet", outTrees, skim, isData);
+                out.Register("Isotrack", outTrees, skim, isData);
+                out.Register("Misc", outTrees, skim, isData);
+            };
+
+            //With asynchronous writing the branches are bound to a separate output class owned by the writer thread
+            if(nSnapshots != 0) treeOutput = std::make_shared<Output>();
+            Output& branchOutput = nSnapshots != 0 ? *treeOutput : output;
+
+            branchOutput.ReadEncoding(skim);
+            registerBranches(branchOutput);
+
+            //Apply compression/basket settings and byte based auto flush of the output profile
+            std::string profileName = skim.get<std::string>("Output.Profile", "");
+
+            if(profileName != ""){
+                profile = std::make_shared<IOProfile>(skim, profileName);
+                std::cout << "Use output profile: " << profileName << std::endl;
+
+                for(const std::shared_ptr<TTree>& tree : outTrees) profile->Apply(tree.get());
+                profile->SetAutoFlush(outTrees);
+            }
+
+            if(nSnapshots != 0){
+                //Output used by the analyzers records the same booking, so only the booked members are copied to the writer
+                output.SetSlicesOnly();
+                registerBranches(output);
+                if(output.NSlices() != treeOutput->NSlices()) throw std::runtime_error("Booking of the analyzer output does not match the output of the writer");
+
+                writer = std::make_shared<AsyncWriter>(outTrees, treeOutput, nSnapshots);
+            }
+
+            //Trees are friend trees aligned to the entry list of the original NanoAOD file
+            if(skim.get<bool>("Output.Virtual.Enabled", false)){
+                std::cout << "Virtual skim: only entry numbers and computed quantities are written" << std::endl;
+
+                for(std::size_t i = 0; i < outTrees.size(); ++i){
+                    entryLists.push_back(std::make_shared<TEntryList>("EntryList", channels[i].c_str(), "Events", input.fileName.c_str()));
+                    entryLists.back()->SetDirectory(nullptr);
+
+                    outTrees[i]->GetUserInfo()->Add(new TNamed("InputFile", input.fileName.c_str()));
+                    outTrees[i]->GetUserInfo()->Add(new TNamed("InputTree", "Events"));
+                }
+            }
+
+            passed = std::vector<char>(outTrees.size(), false);
+            nPassed = std::vector<std::size_t>(outTrees.size(), 0);
 
             //List of analyzer
-            analyzer = {
-                std::make_shared<TriggerAnalyzer<T>>(),
-                std::make_shared<METFilterAnalyzer<T>>(),
-                std::make_shared<JetAnalyzer<T>>(),
-                std::make_shared<ElectronAnalyzer<T>>(),
-                std::make_shared<MuonAnalyzer<T>>(),
-                std::make_shared<IsotrkAnalyzer<T>>(),
-                std::make_shared<WeightAnalyzer<T>>(),
-                std::make_shared<MiscAnalyzer<T>>(),
-                std::make_shared<SFAnalyzer<T>>(),
-            };
+            analyzer = MakeAnalyzers();
 
             //Initialize analyzers
             for(std::shared_ptr<BaseAnalyzer<T>>& a : analyzer){
                 a->BeginJob(skim, sf);
             }
 
+            //Names are demangled once, they are used for every event by the tracer
+            for(std::shared_ptr<BaseAnalyzer<T>>& a : analyzer){
+                analyzerNames.push_back(a->Name());
+                analyzerStages.push_back(profiler.AddStage(analyzerNames.back()));
+            }
+
+            cutStage = profiler.AddStage("Cuts");
+            fillStage = profiler.AddStage("Fill");
+
             nEvents = input.GetEntries();
         };
 
         void Loop(T& input, Output& output){
-            for(std::shared_ptr<BaseAnalyzer<T>>& a : analyzer){
-                a->Analyze(input, output);
+            Tracer::Span eventSpan(tracer.get(), "Event");
+
+            for(std::size_t i = 0; i < analyzer.size(); ++i){
+                SKIM_TIME(profiler, analyzerStages[i]);
+                Tracer::Span span(tracer.get(), analyzerNames[i], "analyzer");
+                PerfCounters::Scope counterScope(counters.get(), i);
+                SlowEventRecorder::Scope recorderScope(recorder.get(), i);
+                analyzer[i]->Analyze(input, output);
+            }
+
+            bool anyPassed = false;
+
+            {
+                SKIM_TIME(profiler, cutStage);
+                Tracer::Span span(tracer.get(), "Cuts");
+                PerfCounters::Scope counterScope(counters.get(), analyzer.size());
+                SlowEventRecorder::Scope recorderScope(recorder.get(), analyzer.size());
+                if(dedupSet) duplicate = dedupSet->Contains(output.runNr, output.lumiNr, output.evNr);
+                cuts.Evaluate();
             }
 
             for(std::size_t i = 0; i < outTrees.size(); ++i){
-                cuts[i].Count();
-                cuts[i].FillCutflow();
-                if(cuts[i].Passed()){
-                    outTrees[i]->Fill();
+                passed[i] = cuts.Passed(i);
+                anyPassed = anyPassed or passed[i];
+                nPassed[i] += passed[i];
+
+                if(passed[i] and !entryLists.empty()) entryLists[i]->Enter(output.inputEntry);
+            }
+
+            if(anyPassed){
+                SKIM_TIME(profiler, fillStage);
+                Tracer::Span span(tracer.get(), "Fill", "output");
+                PerfCounters::Scope counterScope(counters.get(), analyzer.size() + 1);
+                SlowEventRecorder::Scope recorderScope(recorder.get(), analyzer.size() + 1);
+
+                if(writer) writer->Push(output, passed);
+
+                else{
+                    output.Encode();
+
+                    for(std::size_t i = 0; i < outTrees.size(); ++i){
+                        if(passed[i]) outTrees[i]->Fill();
+                    }
                 }
             }
+
+            //Redistribute auto flush budget according to the selection rate of each channel
+            if(profile and ++nProcessed == profile->WarmupEvents()){
+                if(writer) writer->Drain();
+                profile->AdaptAutoFlush(outTrees, nPassed);
+            }
+
+            if(recorder) recorder->EndEvent({input.eleSize, input.muSize, input.jetSize, input.fatJetSize, short(run == "MC" ? input.genSize : 0)});
+        }
+
+        //Events skipped by the input (e.g. zone map), which would not pass any channel
+        void Skip(const std::size_t& nSkipped){
+            cuts.CountSkipped(nSkipped);
+        }
+
+        const std::vector<ZoneRequirement>& ZoneRequirements() const {return zoneRequirements;}
+
+        //Record spans of sampled events, the input is passed on to trace the reading of the collections
+        void SetTracer(const std::shared_ptr<Tracer>& tracer, T& input){
+            this->tracer = tracer;
+            input.SetTracer(tracer.get());
+        }
+
+        //Count cycles/instructions/misses per stage, report is written as JSON at the end of the job
+        void SetPerfCounters(const std::string& fileName){
+            counters = std::make_shared<PerfCounters>();
+            counterReport = fileName;
+
+            for(const std::string& name : analyzerNames) counters->AddStage(name);
+            counters->AddStage("Cuts");
+            counters->AddStage("Fill");
+        }
+
+        //Drop events contained in the set with a "Not duplicate" cut in front of all channel cuts
+        void SetDedupSet(const std::shared_ptr<const EventSet>& dedupSet){
+            this->dedupSet = dedupSet;
+
+            for(std::size_t i = 0; i < channels.size(); ++i) cuts.AddVeto(i, "Not duplicate", &duplicate);
+        }
+
+        //Record the slowest events, the recorder is started for each event by the caller (BeginEvent)
+        void SetSlowEventRecorder(const std::shared_ptr<SlowEventRecorder>& recorder){
+            this->recorder = recorder;
+
+            for(const std::string& name : analyzerNames) recorder->AddStage(name);
+            recorder->AddStage("Cuts");
+            recorder->AddStage("Fill");
+        }
+
+        //JSON job report with the timing of each stage
+        void SetTimingReport(const std::string& fileName){
+            timingReport = fileName;
         }
 
         void WriteOutput(){
+            //Wait until all queued snapshots are filled into the trees
+            if(writer) writer->Close();
+
+            //Cutflow/N-1 histograms of all channels
+            cuts.WriteOutput();
+
             for(std::size_t i = 0; i < outTrees.size(); ++i){
                 for(std::shared_ptr<BaseAnalyzer<T>>& a : analyzer){
                     a->EndJob(outFiles[i]);
@@ -166,12 +392,28 @@ class Skimmer{
 
                 outFiles[i]->cd();
                 outTrees[i]->Write();
-                cuts[i].WriteOutput();
+                if(!entryLists.empty()) entryLists[i]->Write();
+
+#ifdef SKIM_TIMING
+                profiler.WriteOutput(outFiles[i]);
+#endif
 
                 std::cout << "Close output file: " << outFiles[i]->GetName() << std::endl;
                 std::cout << "Written Tree: " << outTrees[i]->GetName() <<  " with " << outTrees[i]->GetEntries() << " of " << 
                               nEvents << " (" << outTrees[i]->GetEntries()/float(nEvents)*100 << " %) events selected" << std::endl;
             }
+
+            if(counters){
+                counters->Print();
+                counters->WriteReport(counterReport);
+            }
+
+#ifdef SKIM_TIMING
+            profiler.Print();
+            if(timingReport != "") profiler.WriteReport(timingReport);
+#else
+            if(timingReport != "") std::cout << "Timing report not written, compile with -DSKIM_TIMING to measure the event loop" << std::endl;
+#endif
         }
 };
 
@@ -0,0 +1,80 @@
+#ifndef SLOWEVENTRECORDER_H
+#define SLOWEVENTRECORDER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+/// Records the entries and per-stage times of the slowest events of a job:
+/// all events above a latency threshold (up to a maximum number) and the
+/// top-k slowest events. Together with the object multiplicities this shows
+/// which events make up the tail, the entries can be captured into a replay
+/// file for AnalyzerBench.
+
+class SlowEventRecorder {
+    public:
+        struct Multiplicity {
+            short electrons, muons, jets, fatJets, genParts;
+        };
+
+        //Adds the time between construction and destruction to the stage of the current event, no-op if the recorder is null
+        class Scope {
+            private:
+                SlowEventRecorder* recorder;
+                std::size_t stage;
+                std::chrono::steady_clock::time_point start;
+
+            public:
+                Scope(SlowEventRecorder* recorder, const std::size_t& stage) : recorder(recorder), stage(stage) {
+                    if(recorder != nullptr) start = std::chrono::steady_clock::now();
+                }
+
+                ~Scope(){
+                    if(recorder != nullptr) recorder->Add(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+                }
+        };
+
+    private:
+        static constexpr std::size_t maxRecorded = 10000;
+
+        struct Event {
+            std::size_t entry;
+            long long total;
+            std::vector<long long> stageTimes;
+            Multiplicity multiplicity;
+        };
+
+        long long threshold;
+        std::size_t topK;
+
+        std::vector<std::string> stageNames;
+
+        //Current event
+        std::size_t entry;
+        std::vector<long long> stageTimes;
+        std::chrono::steady_clock::time_point start;
+
+        //Events above threshold and min-heap of the k slowest events
+        std::vector<Event> aboveThreshold, top;
+        long long nEvents = 0, nAboveThreshold = 0;
+
+        static bool Faster(const Event& e1, const Event& e2){return e1.total > e2.total;}
+
+    public:
+        //Threshold in ns, zero to only keep the top-k events
+        SlowEventRecorder(const long long& threshold, const std::size_t& topK);
+
+        std::size_t AddStage(const std::string& name);
+
+        void BeginEvent(const std::size_t& entry);
+        void Add(const std::size_t& stage, const long long& ns){stageTimes[stage] += ns;}
+        void EndEvent(const Multiplicity& multiplicity);
+
+        //Entries of all recorded events in ascending order
+        std::vector<std::size_t> Entries() const;
+
+        void Print() const;
+        void WriteReport(const std::string& fileName) const;
+};
+
+#endif
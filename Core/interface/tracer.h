@@ -0,0 +1,76 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+/// Timeline of the event processing in the Chrome trace event format, which
+/// can be opened with chrome://tracing or ui.perfetto.dev. Only one event in
+/// N is recorded, for those each input read, analyzer, cut evaluation and fill
+/// is stored as a complete ("X") span together with the thread it ran on.
+
+class Tracer {
+    public:
+        //Records the time between construction and destruction, no-op if the tracer is null or the event is not sampled
+        class Span {
+            private:
+                Tracer* tracer;
+                std::string name;
+                const char* category;
+                double start;
+
+            public:
+                Span(Tracer* tracer, const std::string& name, const char* category = "skim") : tracer(tracer != nullptr and tracer->Sampled() ? tracer : nullptr), category(category) {
+                    if(this->tracer == nullptr) return;
+
+                    this->name = name;
+                    start = this->tracer->Now();
+                }
+
+                ~Span(){
+                    if(tracer != nullptr) tracer->Record(name, category, start, tracer->Now() - start);
+                }
+        };
+
+    private:
+        struct Event {
+            std::string name;
+            const char* category;
+            double start, duration;
+            std::size_t thread;
+            long long entry;
+        };
+
+        std::size_t sampleRate;
+        bool sampled = false;
+        long long entry = -1;
+
+        std::chrono::steady_clock::time_point begin;
+        std::vector<Event> events;
+        std::vector<std::thread::id> threads;
+        std::mutex mutex;
+
+    public:
+        Tracer(const std::size_t& sampleRate);
+
+        //Called before each event, decides if the event is recorded
+        void BeginEvent(const long long& entry){
+            this->entry = entry;
+            sampled = entry % sampleRate == 0;
+        }
+
+        bool Sampled() const {return sampled;}
+
+        //Microseconds since the tracer was created
+        double Now() const {
+            return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        void Record(const std::string& name, const char* category, const double& start, const double& duration);
+        void Write(const std::string& fileName);
+};
+
+#endif
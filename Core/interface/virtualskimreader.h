@@ -0,0 +1,39 @@
+#ifndef VIRTUALSKIMREADER_H
+#define VIRTUALSKIMREADER_H
+
+#include <string>
+#include <memory>
+
+#include <TFile.h>
+#include <TTree.h>
+
+/// Reader for skims written in virtual mode ("Output.Virtual"). Each entry of
+/// the skim tree holds the computed quantities of one selected event and its
+/// entry in the original NanoAOD tree (Misc_InputEntry), objects are linked by
+/// the *_InputIdx branches. GetEntry reads both trees, so copied NanoAOD
+/// quantities are taken directly from the original file.
+
+class VirtualSkimReader {
+    private:
+        std::shared_ptr<TFile> skimFile, nanoFile;
+        TTree* skimTree;
+        TTree* nanoTree;
+
+        unsigned long long inputEntry;
+
+    public:
+        //Original file and tree are taken from the user info of the skim tree, if no file name is given
+        VirtualSkimReader(const std::string& skimFileName, const std::string& channel, const std::string& nanoFileName = "");
+
+        long long GetEntries() const {return skimTree->GetEntries();}
+        unsigned long long GetInputEntry() const {return inputEntry;}
+
+        //Read entry of the skim tree and the corresponding entry of the NanoAOD tree
+        void GetEntry(const long long& entry);
+
+        //Branch addresses/status are set by the user on both trees
+        TTree* GetSkimTree(){return skimTree;}
+        TTree* GetNanoTree(){return nanoTree;}
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef ZONEMAP_H
+#define ZONEMAP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+//Minimal requirements an event has to fulfill to pass the selection of one channel
+struct ZoneRequirement {
+    short minElectrons = 0, minMuons = 0, minJets = 0, minFatJets = 0;
+
+    //The leading lepton of the input has to be above this pt (exclusive), 0 if there is no such bound
+    float minLeptonPt = 0;
+    std::vector<std::string> triggers;
+};
+
+/// Summary of each TTree cluster of an input file (maximum object multiplicities,
+/// maximum leading lepton pt and the OR of all trigger bits). The index is stored
+/// as JSON sidecar in a cache directory and reused by later skims of the same file
+/// to skip clusters, which can not pass any channel, without reading them.
+
+class ZoneMap {
+    private:
+        struct Zone {
+            long long first, end;
+            short maxElectrons = 0, maxMuons = 0, maxJets = 0, maxFatJets = 0;
+            float maxLeptonPt = 0;
+            std::vector<std::uint64_t> triggerMask;
+        };
+
+        std::string fileName, sideCar;
+        long long nEntries, nFilled = 0;
+        bool complete = false;
+
+        std::vector<std::string> triggerNames;
+        std::vector<Zone> zones;
+        std::vector<char> skippable;
+        std::size_t current = 0;
+
+        std::size_t FindZone(const long long& entry);
+        bool Load();
+
+    public:
+        ZoneMap(const std::string& cacheDir, const std::string& fileName, TTree* tree, const std::vector<std::string>& triggerNames);
+
+        //True if the index was read from the cache, otherwise it is build while reading the file
+        bool Complete() const {return complete;}
+        void Fill(const long long& entry, const short& nElectrons, const short& nMuons, const short& nJets, const short& nFatJets, const float& leadingLeptonPt, const std::vector<std::uint64_t>& triggerMask);
+
+        //Mark zones in which no event can pass any of the channels
+        void SetRequirements(const std::vector<ZoneRequirement>& requirements);
+
+        //First entry >= entry, which is not inside a skippable zone
+        long long NextEntry(const long long& entry);
+
+        //Write sidecar, if every entry of the file was indexed
+        void Write();
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include <ChargedSkimming/Core/interface/asyncwriter.h>
+
+#include <iostream>
+
+AsyncWriter::AsyncWriter(const std::vector<std::shared_ptr<TTree>>& trees, const std::shared_ptr<Output>& treeOutput, const std::size_t& nSnapshots) :
+    trees(trees),
+    treeOutput(treeOutput),
+    snapshots(nSnapshots),
+    passed(nSnapshots, std::vector<char>(trees.size(), false)){
+
+    //ROOT::EnableThreadSafety() has to be called by the owner before any file/tree is created
+    worker = std::thread(&AsyncWriter::Run, this);
+}
+
+AsyncWriter::~AsyncWriter(){
+    if(worker.joinable()){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+
+        notEmpty.notify_one();
+        worker.join();
+    }
+}
+
+void AsyncWriter::Push(const Output& out, const std::vector<char>& passed){
+    std::size_t slot;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(error) std::rethrow_exception(error);
+
+        //Backpressure: wait until the writer has freed a snapshot
+        if(nQueued == snapshots.size()){
+            ++nWaits;
+            notFull.wait(lock, [&](){return nQueued < snapshots.size() or error;});
+            if(error) std::rethrow_exception(error);
+        }
+
+        slot = head;
+    }
+
+    //Slot is owned by the event loop until it is queued, so copy without lock (buffer keeps its capacity)
+    out.Pack(snapshots[slot]);
+    this->passed[slot] = passed;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = (head + 1) % snapshots.size();
+        ++nQueued;
+    }
+
+    notEmpty.notify_one();
+}
+
+void AsyncWriter::Run(){
+    while(true){
+        std::size_t slot;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            notEmpty.wait(lock, [&](){return nQueued != 0 or closed;});
+
+            if(nQueued == 0 and closed) break;
+            slot = tail;
+        }
+
+        try{
+            treeOutput->Unpack(snapshots[slot]);
+            treeOutput->Encode();
+
+            for(std::size_t i = 0; i < trees.size(); ++i){
+                if(passed[slot][i]) trees[i]->Fill();
+            }
+        }
+
+        catch(...){
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+            notFull.notify_one();
+
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tail = (tail + 1) % snapshots.size();
+            --nQueued;
+            ++nWritten;
+        }
+
+        notFull.notify_one();
+    }
+}
+
+void AsyncWriter::Drain(){
+    //Afterwards the writer thread is idle until the next push, so the trees can be modified safely
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [&](){return nQueued == 0 or error;});
+
+    if(error) std::rethrow_exception(error);
+}
+
+void AsyncWriter::Close(){
+    if(!worker.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+
+    notEmpty.notify_one();
+    worker.join();
+
+    if(error) std::rethrow_exception(error);
+
+    std::cout << "Async writer: " << nWritten << " snapshots written with " << snapshots.size() << " slots (" << nWaits << " times waited for free slot)" << std::endl;
+}
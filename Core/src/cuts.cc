@@ -1,64 +1,166 @@
 #include <ChargedSkimming/Core/interface/cuts.h>
 #include <iostream>
 
-Cuts::Cuts(const std::shared_ptr<TFile>& outFile, const std::string& channel){
-    cutFlow = std::make_shared<TH1F>();
-    cutFlow->SetName(("Cutflow_" + channel).c_str());
-    cutFlow->SetTitle(("Cutflow_" + channel).c_str());
-    cutFlow->SetDirectory(outFile.get());
+std::size_t Cuts::AddChannel(const std::shared_ptr<TFile>& outFile, const std::string& channel){
+    Channel c;
+    c.name = channel;
+    c.outFile = outFile;
+    c.cutflow = std::vector<long long>(1, 0);
+
+    channels.push_back(c);
+
+    return channels.size() - 1;
 }
 
-std::function<bool()> Cuts::ConstructCut(short& value, const std::string& op, const short& threshold){
-    if(op == "=="){
-        return [&value, threshold](){return value == threshold;};
+std::size_t Cuts::AddPredicate(const Predicate& predicate){
+    //Same requirement in several channels is only evaluated once
+    for(std::size_t i = 0; i < predicates.size(); ++i){
+        if(predicates[i].key == predicate.key) return i;
     }
 
-    else if(op == ">="){
-        return [&value, threshold](){return value >= threshold;};
-    } 
+    predicates.push_back(predicate);
+    results.push_back(false);
 
-    else if(op == "<="){
-        return [&value, threshold](){return value <= threshold;};
-    } 
+    return predicates.size() - 1;
+}
 
-    else throw std::runtime_error(("Unknow cut operator: '" + op + "'").c_str());
+void Cuts::Insert(const std::size_t& channel, const std::size_t& predicate, const std::string& cutName, const bool& front){
+    Channel& c = channels.at(channel);
+
+    c.program.insert(front ? c.program.begin() : c.program.end(), predicate);
+    c.cutNames.insert(front ? c.cutNames.begin() : c.cutNames.end(), cutName);
+
+    c.cutflow = std::vector<long long>(c.program.size() + 1, 0);
+    c.nMinusOne = std::vector<long long>(c.program.size(), 0);
 }
 
-void Cuts::AddCut(const std::string& part, Output& out, const std::string& op, const short& threshold){
+void Cuts::AddCut(const std::size_t& channel, const std::string& part, Output& out, const std::string& op, const short& threshold){
+    Predicate p;
+    std::string cutName;
+
+    if(op == "==") p.op = Equal;
+    else if(op == ">=") p.op = GreaterEqual;
+    else if(op == "<=") p.op = LessEqual;
+    else throw std::runtime_error(("Unknow cut operator: '" + op + "'").c_str());
+
+    p.threshold = threshold;
+    p.key = part + op + std::to_string(threshold);
+
     if(part == "Electron"){
-        cuts.push_back(ConstructCut(out.nElectrons, op, threshold));
-        cutNames.push_back("N_{e} " + op + std::to_string(threshold) + " (No ID.)");
+        p.value = &out.nElectrons;
+        cutName = "N_{e} " + op + std::to_string(threshold) + " (No ID.)";
     }
 
     else if(part == "Muon"){
-        cuts.push_back(ConstructCut(out.nMuons, op, threshold));
-        cutNames.push_back("N_{#mu} " + op + std::to_string(threshold) + " (No ID.)");
+        p.value = &out.nMuons;
+        cutName = "N_{#mu} " + op + std::to_string(threshold) + " (No ID.)";
     }
 
     else if(part == "Jet"){
-        cuts.push_back(ConstructCut(out.nJets, op, threshold));
-        cutNames.push_back("N_{j} " + op + std::to_string(threshold) + " (Not clean)");
+        p.value = &out.nJets;
+        cutName = "N_{j} " + op + std::to_string(threshold) + " (Not clean)";
     }
 
     else if(part == "FatJet"){
-        cuts.push_back(ConstructCut(out.nFatJets, op, threshold));
-        cutNames.push_back("N_{fj} " + op + std::to_string(threshold));
+        p.value = &out.nFatJets;
+        cutName = "N_{fj} " + op + std::to_string(threshold);
     }
 
     else throw std::runtime_error(("Unknow particle: '" + op + "'").c_str());
+
+    Insert(channel, AddPredicate(p), cutName, false);
+}
+
+void Cuts::AddVeto(const std::size_t& channel, const std::string& cutName, const char* flag){
+    Predicate p;
+    p.op = Veto;
+    p.flag = flag;
+    p.key = "Veto:" + cutName;
+
+    Insert(channel, AddPredicate(p), cutName, true);
 }
 
-bool Cuts::Passed(){
-    for(std::size_t i = 0; i < cuts.size(); ++i){
-        if(!cuts[i]()) return false;
+void Cuts::Evaluate(){
+    for(std::size_t i = 0; i < predicates.size(); ++i){
+        const Predicate& p = predicates[i];
+        bool result = false;
+
+        switch(p.op){
+            case Equal: result = *p.value == p.threshold; break;
+            case GreaterEqual: result = *p.value >= p.threshold; break;
+            case LessEqual: result = *p.value <= p.threshold; break;
+
+            case TriggerOr:
+                for(std::size_t w = 0; w < p.mask.size(); ++w){
+                    if((*p.word)[w] & p.mask[w]){
+                        result = true;
+                        break;
+                    }
+                }
+                break;
+
+            case METFilterAnd:
+                result = true;
+
+                for(std::size_t w = 0; w < p.mask.size(); ++w){
+                    if(((*p.word)[w] & p.mask[w]) != p.mask[w]){
+                        result = false;
+                        break;
+                    }
+                }
+                break;
+
+            case Veto: result = !*p.flag; break;
+        }
+
+        results[i] = result;
     }
 
-    return true;
+    for(Channel& c : channels){
+        std::size_t nFailed = 0, failedIdx = 0;
+        ++c.cutflow[0];
+
+        for(std::size_t i = 0; i < c.program.size(); ++i){
+            if(results[c.program[i]]){
+                if(nFailed == 0) ++c.cutflow[i + 1];
+            }
+
+            else if(++nFailed == 1) failedIdx = i;
+        }
+
+        //N-1: events passing all cuts except (possibly) the i-th one
+        if(nFailed == 0){
+            for(long long& n : c.nMinusOne) ++n;
+        }
+
+        else if(nFailed == 1) ++c.nMinusOne[failedIdx];
+
+        c.passed = nFailed == 0;
+    }
 }
 
-void Cuts::FillCutflow(){
-    for(std::size_t i = 0; i < cuts.size(); ++i){
-        if(!cuts[i]()) return;
-        cutFlow->Fill(cutNames[i].c_str(), 1);
+void Cuts::WriteOutput(){
+    for(Channel& c : channels){
+        c.outFile->cd();
+
+        TH1F cutflow(("Cutflow_" + c.name).c_str(), ("Cutflow_" + c.name).c_str(), c.cutflow.size(), 0, c.cutflow.size());
+        cutflow.GetXaxis()->SetBinLabel(1, "No cuts");
+        cutflow.SetBinContent(1, c.cutflow[0]);
+
+        TH1F nMinusOne(("NMinusOne_" + c.name).c_str(), ("NMinusOne_" + c.name).c_str(), c.nMinusOne.size(), 0, c.nMinusOne.size());
+
+        for(std::size_t i = 0; i < c.program.size(); ++i){
+            cutflow.GetXaxis()->SetBinLabel(i + 2, c.cutNames[i].c_str());
+            cutflow.SetBinContent(i + 2, c.cutflow[i + 1]);
+
+            nMinusOne.GetXaxis()->SetBinLabel(i + 1, c.cutNames[i].c_str());
+            nMinusOne.SetBinContent(i + 1, c.nMinusOne[i]);
+        }
+
+        cutflow.SetEntries(c.cutflow[0]);
+        nMinusOne.SetEntries(c.cutflow[0]);
+
+        cutflow.Write();
+        nMinusOne.Write();
     }
 }
@@ -0,0 +1,181 @@
+#include <ChargedSkimming/Core/interface/eventindex.h>
+
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <experimental/filesystem>
+
+#include <TFile.h>
+#include <TLeaf.h>
+#include <TBranch.h>
+
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+EventIndex::EventIndex(const std::string& cacheDir, const std::string& fileName, TTree* tree) : fileName(fileName), nEntries(tree->GetEntries()) {
+    //Identity of the file content, the UUID is new for every written ROOT file
+    if(TFile* file = tree->GetCurrentFile()){
+        uuid = file->GetUUID().AsString();
+        fileSize = file->GetSize();
+    }
+
+    if(cacheDir != ""){
+        //Sidecar is keyed by a hash of the input file name
+        sideCar = cacheDir + "/" + Util::HashName(Util::Hash(fileName.data(), fileName.size())) + ".idx";
+
+        if(Load()){
+            std::cout << "Use event index: " << sideCar << " (" << records.size() << " events)" << std::endl;
+            return;
+        }
+    }
+
+    TLeaf* run = tree->GetLeaf("run");
+    TLeaf* lumi = tree->GetLeaf("luminosityBlock");
+    TLeaf* event = tree->GetLeaf("event");
+    if(run == nullptr or lumi == nullptr or event == nullptr) throw std::runtime_error("Input file has no run/luminosityBlock/event branch: '" + fileName + "'");
+
+    //Only the three branches are read, so the scan is cheap compared to a skim
+    long long cacheSize = tree->GetCacheSize();
+    tree->SetCacheSize(10000000);
+    tree->AddBranchToCache(run->GetBranch(), true);
+    tree->AddBranchToCache(lumi->GetBranch(), true);
+    tree->AddBranchToCache(event->GetBranch(), true);
+
+    records.reserve(nEntries);
+
+    for(long long entry = 0; entry < nEntries; ++entry){
+        run->GetBranch()->GetEntry(entry);
+        lumi->GetBranch()->GetEntry(entry);
+        event->GetBranch()->GetEntry(entry);
+
+        records.push_back({run->GetTypedValue<std::uint32_t>(), lumi->GetTypedValue<std::uint32_t>(), event->GetTypedValue<std::uint64_t>(), std::uint64_t(entry)});
+    }
+
+    //Drop the cache with the three manually added branches, the new one learns the branches read by the skim
+    tree->SetCacheSize(0);
+    tree->SetCacheSize(cacheSize);
+
+    std::sort(records.begin(), records.end());
+    std::cout << "Build event index: " << (sideCar != "" ? sideCar : fileName) << " (" << records.size() << " events)" << std::endl;
+
+    if(sideCar != "") Write();
+}
+
+bool EventIndex::Load(){
+    if(!std::experimental::filesystem::exists(sideCar)) return false;
+
+    std::ifstream in(sideCar, std::ios::binary);
+    Header header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(Header));
+
+    //Index of an older format, the name length is not read from it
+    if(!in or std::memcmp(header.magic, magic, sizeof(magic)) != 0 or header.nameLength != fileName.size()){
+        std::cout << "Event index '" << sideCar << "' does not match input file, it will be rebuild" << std::endl;
+        return false;
+    }
+
+    std::string name(header.nameLength, ' ');
+    in.read(&name[0], header.nameLength);
+
+    //Different file with same hash or file changed since the index was build
+    bool sameFile = name == fileName and header.nEntries == std::uint64_t(nEntries) and header.fileSize == std::uint64_t(fileSize) and std::string(header.uuid, strnlen(header.uuid, sizeof(header.uuid))) == uuid;
+
+    if(!in or !sameFile){
+        std::cout << "Event index '" << sideCar << "' does not match input file, it will be rebuild" << std::endl;
+        return false;
+    }
+
+    records = std::vector<Record>(header.nRecords);
+    in.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(Record));
+
+    if(!in){
+        std::cout << "Event index '" << sideCar << "' is truncated, it will be rebuild" << std::endl;
+        records.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void EventIndex::Write(){
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.nEntries = nEntries;
+    header.nRecords = records.size();
+    header.fileSize = fileSize;
+    header.nameLength = fileName.size();
+    uuid.copy(header.uuid, sizeof(header.uuid) - 1);
+
+    //Best effort, the skim does not need the sidecar (e.g. read-only or full index directory)
+    try {
+        Util::WriteAtomic(sideCar, [&](const std::string& tmp){
+            std::ofstream out(tmp, std::ios::binary);
+            if(!out) throw std::runtime_error("Could not create '" + tmp + "'");
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+            out.write(fileName.data(), fileName.size());
+            out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+            out.close();
+            if(!out) throw std::runtime_error("Could not write '" + tmp + "'");
+        });
+
+        std::cout << "Written event index: " << sideCar << std::endl;
+    }
+
+    catch(const std::exception& e){
+        std::cout << "Warning: Could not write event index '" << sideCar << "': " << e.what() << std::endl;
+    }
+}
+
+std::vector<EventIndex::Record> EventIndex::ReadEventList(const std::string& listName){
+    std::ifstream in(listName);
+    if(!in) throw std::runtime_error("Could not open event list: '" + listName + "'");
+
+    std::vector<Record> events;
+    std::string line;
+
+    while(std::getline(in, line)){
+        line = line.substr(0, line.find("#"));
+        line.erase(std::remove_if(line.begin(), line.end(), [](const char& c){return std::isspace(static_cast<unsigned char>(c));}), line.end());
+        if(line.empty()) continue;
+
+        std::vector<std::uint64_t> fields;
+        std::stringstream stream(line);
+        std::string field;
+
+        while(std::getline(stream, field, ':')) fields.push_back(std::stoull(field));
+
+        if(fields.size() == 3) events.push_back({std::uint32_t(fields[0]), std::uint32_t(fields[1]), fields[2], 0});
+        else if(fields.size() == 2) events.push_back({std::uint32_t(fields[0]), 0, fields[1], 0});
+        else throw std::runtime_error("Invalid line in event list '" + listName + "': " + line);
+    }
+
+    return events;
+}
+
+std::vector<std::size_t> EventIndex::Find(const std::vector<Record>& events) const {
+    std::vector<std::size_t> entries;
+
+    for(const Record& e : events){
+        std::vector<Record>::const_iterator it = std::lower_bound(records.begin(), records.end(), e);
+
+        if(it == records.end() or it->run != e.run or it->event != e.event){
+            std::cout << "Event " << e.run << ":" << e.lumi << ":" << e.event << " not found in " << fileName << std::endl;
+            continue;
+        }
+
+        if(e.lumi != 0 and it->lumi != e.lumi){
+            std::cout << "Event " << e.run << ":" << e.event << " is in luminosity block " << it->lumi << " instead of " << e.lumi << std::endl;
+        }
+
+        entries.push_back(it->entry);
+    }
+
+    //Entries in file order, so each cluster is read at most once
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    return entries;
+}
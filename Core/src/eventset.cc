@@ -0,0 +1,70 @@
+#include <ChargedSkimming/Core/interface/eventset.h>
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+EventSet::EventSet(const std::string& fileName) : file(fileName, "event set"), data(file.Data()), size(file.Size()) {
+    if(size < sizeof(Header)) throw std::runtime_error("Event set is too small: '" + fileName + "'");
+
+    std::memcpy(&header, data, sizeof(Header));
+    if(std::memcmp(header.magic, magic, sizeof(magic)) != 0) throw std::runtime_error("Not an event set file: '" + fileName + "'");
+
+    //Compare by division, the counts in a corrupt header could overflow the expected size
+    std::size_t payload = size - sizeof(Header);
+    if(header.nPartitions > payload / sizeof(Partition) or header.nEvents != (payload - header.nPartitions * sizeof(Partition)) / 8 or payload % 8 != 0) throw std::runtime_error("Event set is truncated: '" + fileName + "'");
+
+    partitions = reinterpret_cast<const Partition*>(data + sizeof(Header));
+    events = reinterpret_cast<const std::uint64_t*>(data + sizeof(Header) + header.nPartitions * sizeof(Partition));
+
+    for(std::size_t i = 0; i < header.nPartitions; ++i){
+        if(partitions[i].first > header.nEvents or partitions[i].count > header.nEvents - partitions[i].first) throw std::runtime_error("Event set is corrupt: '" + fileName + "'");
+    }
+
+    std::cout << "Use event set: " << fileName << " (" << header.nEvents << " events in " << header.nPartitions << " luminosity blocks)" << std::endl;
+}
+
+bool EventSet::Contains(const std::uint32_t& run, const std::uint32_t& lumi, const std::uint64_t& event) const {
+    const Partition* end = partitions + header.nPartitions;
+    const Partition* p = std::lower_bound(partitions, end, std::make_pair(run, lumi), [](const Partition& p, const std::pair<std::uint32_t, std::uint32_t>& key){
+        return p.run != key.first ? p.run < key.first : p.lumi < key.second;
+    });
+
+    if(p == end or p->run != run or p->lumi != lumi) return false;
+
+    return std::binary_search(events + p->first, events + p->first + p->count, event);
+}
+
+void EventSet::Write(std::vector<Event>& events, const std::string& fileName){
+    std::sort(events.begin(), events.end());
+    events.erase(std::unique(events.begin(), events.end()), events.end());
+
+    std::vector<Partition> partitions;
+
+    for(std::size_t i = 0; i < events.size(); ++i){
+        if(partitions.empty() or partitions.back().run != events[i].run or partitions.back().lumi != events[i].lumi){
+            partitions.push_back({events[i].run, events[i].lumi, i, 0});
+        }
+
+        ++partitions.back().count;
+    }
+
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out) throw std::runtime_error("Could not create event set: '" + fileName + "'");
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.nPartitions = partitions.size();
+    header.nEvents = events.size();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char*>(partitions.data()), partitions.size() * sizeof(Partition));
+
+    for(const Event& e : events) out.write(reinterpret_cast<const char*>(&e.event), 8);
+
+    out.close();
+
+    std::cout << "Written event set: " << fileName << " (" << events.size() << " events in " << partitions.size() << " luminosity blocks)" << std::endl;
+}
@@ -0,0 +1,79 @@
+#include <ChargedSkimming/Core/interface/ioprofile.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <iostream>
+#include <algorithm>
+#include <map>
+
+#include <TBranch.h>
+#include <TObjArray.h>
+
+IOProfile::IOProfile(const pt::ptree& skim, const std::string& name) : name(name) {
+    std::string path = "Output.Profiles." + name;
+    if(!skim.get_child_optional(path)) throw std::runtime_error("Unknown output profile: '" + name + "'");
+
+    flushBytes = skim.get<long long>(path + ".AutoFlushBytes", 30000000);
+    minFlushBytes = skim.get<long long>(path + ".MinAutoFlushBytes", 1000000);
+    warmupEvents = skim.get<std::size_t>(path + ".WarmupEvents", 0);
+
+    if(skim.get_child_optional(path + ".Groups")){
+        for(const std::pair<const std::string, pt::ptree>& g : skim.get_child(path + ".Groups")){
+            Group group;
+
+            for(const std::pair<const std::string, pt::ptree>& p : g.second.get_child("branches")){
+                group.patterns.push_back(p.second.get_value<std::string>());
+            }
+
+            group.compression = CompressionSettings(g.second.get<std::string>("algorithm"), g.second.get<int>("level"));
+            group.basketSize = g.second.get<int>("basketSize", 0);
+
+            groups.push_back(group);
+        }
+    }
+}
+
+int IOProfile::CompressionSettings(const std::string& algorithm, const int& level){
+    //Same encoding as ROOT::CompressionSettings: 100 * algorithm + level
+    static const std::map<std::string, int> algorithms = {{"ZLIB", 1}, {"LZMA", 2}, {"LZ4", 4}, {"ZSTD", 5}};
+
+    if(!algorithms.count(algorithm)) throw std::runtime_error("Unknown compression algorithm: '" + algorithm + "'");
+    if(level < 0 or level > 9) throw std::runtime_error("Compression level has to be between 0 and 9: " + std::to_string(level));
+
+    return 100 * algorithms.at(algorithm) + level;
+}
+
+void IOProfile::Apply(TTree* tree) const {
+    TObjArray* branches = tree->GetListOfBranches();
+
+    for(int i = 0; i < branches->GetEntries(); ++i){
+        TBranch* branch = static_cast<TBranch*>(branches->At(i));
+
+        for(const Group& group : groups){
+            if(std::none_of(group.patterns.begin(), group.patterns.end(), [&](const std::string& p){return Util::MatchGlob(p, branch->GetName());})) continue;
+
+            branch->SetCompressionSettings(group.compression);
+            if(group.basketSize != 0) branch->SetBasketSize(group.basketSize);
+
+            break;
+        }
+    }
+}
+
+void IOProfile::SetAutoFlush(const std::vector<std::shared_ptr<TTree>>& trees) const {
+    //Before selection rates are known, the budget is split equally (negative value means bytes for ROOT)
+    for(const std::shared_ptr<TTree>& tree : trees){
+        tree->SetAutoFlush(-std::max(flushBytes / (long long)trees.size(), minFlushBytes));
+    }
+}
+
+void IOProfile::AdaptAutoFlush(const std::vector<std::shared_ptr<TTree>>& trees, const std::vector<std::size_t>& nPassed) const {
+    std::size_t nTotal = 0;
+    for(const std::size_t& n : nPassed) nTotal += std::max(n, std::size_t(1));
+
+    for(std::size_t i = 0; i < trees.size(); ++i){
+        long long bytes = std::max((long long)(flushBytes * double(std::max(nPassed[i], std::size_t(1))) / nTotal), minFlushBytes);
+        trees[i]->SetAutoFlush(-bytes);
+
+        std::cout << "Output profile '" << name << "': auto flush of tree '" << trees[i]->GetName() << "' set to " << bytes/1e6 << " MB (" << nPassed[i] << " events selected during warmup)" << std::endl;
+    }
+}
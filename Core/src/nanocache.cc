@@ -0,0 +1,287 @@
+#include <ChargedSkimming/Core/interface/nanocache.h>
+
+#include <map>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <TBranch.h>
+
+NanoCache::NanoCache(const std::string& fileName) : file(fileName, "cache file"), data(file.Data()), size(file.Size()) {
+    if(size < sizeof(Header)) throw std::runtime_error("Cache file is too small: '" + fileName + "'");
+
+    madvise(file.Data(), size, MADV_SEQUENTIAL);
+
+    std::memcpy(&header, data, sizeof(Header));
+    if(std::memcmp(header.magic, magic, sizeof(magic) - 1) != 0) throw std::runtime_error("Not a NanoAOD cache file: '" + fileName + "'");
+    if(header.magic[7] != magic[7]) throw std::runtime_error("NanoAOD cache file has an old format, rebuild it with NanoCache: '" + fileName + "'");
+    if(header.blockSize == 0) throw std::runtime_error("NanoAOD cache file has no block size: '" + fileName + "'");
+
+    //All offsets and sizes are checked against the mapped size, a truncated or corrupt cache would be read out of bounds
+    std::function<void(const bool&)> check = [&](const bool& valid){
+        if(!valid) throw std::runtime_error("NanoAOD cache file is truncated or corrupt, rebuild it with NanoCache: '" + fileName + "'");
+    };
+
+    check(header.indexOffset >= sizeof(Header) and header.indexOffset <= size);
+
+    //Column table
+    const char* pos = data + header.indexOffset;
+    const char* end = data + size;
+
+    for(std::size_t i = 0; i < header.nColumns; ++i){
+        Column c;
+        std::uint32_t nameLength;
+
+        check(end - pos >= 4);
+        std::memcpy(&nameLength, pos, 4); pos += 4;
+
+        check(std::size_t(end - pos) >= std::size_t(nameLength) + 9);
+        c.name = std::string(pos, nameLength); pos += nameLength;
+        c.type = *pos; pos += 1;
+        std::memcpy(&c.elementSize, pos, 4); pos += 4;
+        std::memcpy(&c.count, pos, 4); pos += 4;
+
+        check(c.elementSize >= 1 and c.elementSize <= 8);
+        columns.push_back(c);
+    }
+
+    for(const Column& c : columns){
+        check(c.count == -1 or (c.count >= 0 and std::size_t(c.count) < columns.size() and columns[c.count].type == Count));
+    }
+
+    //Block table (8 byte aligned)
+    std::size_t tableOffset = (pos - data + 7) / 8 * 8;
+    std::size_t nBlocks = (header.nEntries + header.blockSize - 1) / header.blockSize;
+
+    check(tableOffset <= size and (header.nColumns == 0 or nBlocks <= (size - tableOffset) / 8 / header.nColumns));
+    blockOffsets = std::vector<std::uint64_t>(nBlocks * header.nColumns);
+    std::memcpy(blockOffsets.data(), data + tableOffset, blockOffsets.size() * 8);
+
+    //Values (and offset tables) of each block have to be in front of the column table
+    std::function<bool(const std::uint64_t&, const std::uint64_t&)> inside = [&](const std::uint64_t& offset, const std::uint64_t& bytes){
+        return offset >= sizeof(Header) and offset <= header.indexOffset and bytes <= header.indexOffset - offset;
+    };
+
+    for(std::size_t block = 0; block < nBlocks; ++block){
+        std::uint64_t nEvents = std::min<std::uint64_t>(header.blockSize, header.nEntries - block * header.blockSize);
+
+        for(std::size_t column = 0; column < columns.size(); ++column){
+            const Column& c = columns[column];
+            std::uint64_t offset = blockOffsets[block * header.nColumns + column];
+
+            if(c.type == Count){
+                check(inside(offset, (nEvents + 1) * 4));
+
+                //Offsets have to be increasing, otherwise the array lengths underflow
+                const std::uint32_t* offsets = reinterpret_cast<const std::uint32_t*>(data + offset);
+                for(std::uint64_t event = 0; event < nEvents; ++event) check(offsets[event] <= offsets[event + 1]);
+            }
+
+            else if(c.count < 0) check(inside(offset, nEvents * c.elementSize));
+
+            else{
+                std::uint64_t countOffset = blockOffsets[block * header.nColumns + c.count];
+                check(inside(countOffset, (nEvents + 1) * 4));
+
+                std::uint32_t nValues;
+                std::memcpy(&nValues, data + countOffset + nEvents * 4, 4);
+                check(inside(offset, std::uint64_t(nValues) * c.elementSize));
+            }
+        }
+    }
+
+    std::cout << "Use NanoAOD cache: " << fileName << " (" << header.nEntries << " of " << header.nSource << " events, " << header.nColumns << " columns)" << std::endl;
+}
+
+int NanoCache::FindColumn(const std::string& name) const {
+    for(std::size_t i = 0; i < columns.size(); ++i){
+        if(columns[i].name == name) return i;
+    }
+
+    return -1;
+}
+
+void NanoCache::Build(TTree* tree, const std::vector<std::string>& leafNames, const std::vector<std::string>& filterTriggers, const std::string& outName, const std::size_t& blockSize){
+    static const std::map<std::string, char> types = {
+        {"Float_t", Float}, {"Double_t", Double}, {"Int_t", Int}, {"UInt_t", UInt}, {"Short_t", Short}, {"UShort_t", UShort},
+        {"Char_t", Char}, {"UChar_t", UChar}, {"Bool_t", Bool}, {"Long64_t", Long}, {"ULong64_t", ULong},
+    };
+
+    if(blockSize == 0) throw std::runtime_error("Block size of the NanoAOD cache has to be at least one event");
+
+    std::vector<Column> columns;
+    std::vector<TLeaf*> leaves;
+
+    std::function<int(TLeaf*, const bool&)> addColumn = [&](TLeaf* leaf, const bool& isCount){
+        for(std::size_t i = 0; i < columns.size(); ++i){
+            if(columns[i].name == leaf->GetName()) return int(i);
+        }
+
+        Column c;
+        c.name = leaf->GetName();
+        c.count = -1;
+
+        if(isCount){
+            c.type = Count;
+            c.elementSize = 4;
+        }
+
+        else{
+            if(!types.count(leaf->GetTypeName())) throw std::runtime_error("Leaf type '" + std::string(leaf->GetTypeName()) + "' of '" + c.name + "' can not be cached");
+
+            c.type = types.at(leaf->GetTypeName());
+            c.elementSize = leaf->GetLenType();
+            if(leaf->GetLeafCount() != nullptr) c.count = addColumn(leaf->GetLeafCount(), true);
+        }
+
+        columns.push_back(c);
+        leaves.push_back(leaf);
+
+        return int(columns.size() - 1);
+    };
+
+    for(const std::string& name : leafNames){
+        TLeaf* leaf = tree->GetLeaf(name.c_str());
+
+        if(leaf == nullptr){
+            std::cout << "Leaf not found: '" + name + "', it will not be cached!" << std::endl;
+            continue;
+        }
+
+        addColumn(leaf, false);
+    }
+
+    //Original entry number of each cached event
+    columns.push_back({"CacheEntry", ULong, 8, -1});
+    leaves.push_back(nullptr);
+
+    std::vector<TLeaf*> filter;
+
+    for(const std::string& name : filterTriggers){
+        TLeaf* trigger = tree->GetLeaf(name.c_str());
+        if(trigger != nullptr) filter.push_back(trigger);
+        else std::cout << "Trigger not found: '" + name + "', not used in pre-filter!" << std::endl;
+    }
+
+    std::ofstream out(outName, std::ios::binary);
+    if(!out) throw std::runtime_error("Could not create cache file: '" + outName + "'");
+
+    Header header{};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.nSource = tree->GetEntries();
+    header.blockSize = blockSize;
+    header.nColumns = columns.size();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+    const char zeros[8] = {};
+    std::function<void()> align = [&](){
+        std::size_t pos = out.tellp();
+        if(pos % 8 != 0) out.write(zeros, 8 - pos % 8);
+    };
+
+    //Offset tables start with zero in each block
+    std::vector<std::vector<char>> buffers(columns.size());
+    std::vector<std::uint64_t> blockTable;
+    std::size_t inBlock = 0;
+    const std::uint32_t zero = 0;
+
+    std::function<void()> resetBuffers = [&](){
+        for(std::size_t c = 0; c < columns.size(); ++c){
+            buffers[c].clear();
+            if(columns[c].type == Count) buffers[c].insert(buffers[c].end(), reinterpret_cast<const char*>(&zero), reinterpret_cast<const char*>(&zero) + 4);
+        }
+    };
+
+    std::function<void()> flush = [&](){
+        for(std::size_t c = 0; c < columns.size(); ++c){
+            align();
+            blockTable.push_back(out.tellp());
+            out.write(buffers[c].data(), buffers[c].size());
+        }
+
+        resetBuffers();
+        inBlock = 0;
+    };
+
+    resetBuffers();
+
+    for(long long entry = 0; entry < tree->GetEntries(); ++entry){
+        if(entry % 100000 == 0 and entry != 0) std::cout << "Events cached: " << header.nEntries << " of " << entry << " read" << std::endl;
+
+        if(!filter.empty()){
+            bool fired = false;
+
+            for(TLeaf* trigger : filter){
+                trigger->GetBranch()->GetEntry(entry);
+
+                if(trigger->GetValue()){
+                    fired = true;
+                    break;
+                }
+            }
+
+            if(!fired) continue;
+        }
+
+        for(std::size_t c = 0; c < columns.size(); ++c){
+            std::vector<char>& buffer = buffers[c];
+
+            if(leaves[c] == nullptr){
+                std::uint64_t e = entry;
+                buffer.insert(buffer.end(), reinterpret_cast<const char*>(&e), reinterpret_cast<const char*>(&e) + 8);
+                continue;
+            }
+
+            leaves[c]->GetBranch()->GetEntry(entry);
+
+            if(columns[c].type == Count){
+                std::uint32_t offset;
+                std::memcpy(&offset, buffer.data() + buffer.size() - 4, 4);
+                offset += std::uint32_t(leaves[c]->GetValue());
+
+                buffer.insert(buffer.end(), reinterpret_cast<const char*>(&offset), reinterpret_cast<const char*>(&offset) + 4);
+            }
+
+            else{
+                const char* values = static_cast<const char*>(leaves[c]->GetValuePointer());
+                buffer.insert(buffer.end(), values, values + leaves[c]->GetLen() * columns[c].elementSize);
+            }
+        }
+
+        ++header.nEntries;
+        if(++inBlock == blockSize) flush();
+    }
+
+    if(inBlock != 0) flush();
+
+    //Column table
+    align();
+    header.indexOffset = out.tellp();
+
+    for(const Column& c : columns){
+        std::uint32_t nameLength = c.name.size();
+
+        out.write(reinterpret_cast<const char*>(&nameLength), 4);
+        out.write(c.name.data(), nameLength);
+        out.write(&c.type, 1);
+        out.write(reinterpret_cast<const char*>(&c.elementSize), 4);
+        out.write(reinterpret_cast<const char*>(&c.count), 4);
+    }
+
+    //Block table
+    align();
+    out.write(reinterpret_cast<const char*>(blockTable.data()), blockTable.size() * 8);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.close();
+
+    std::cout << "Written NanoAOD cache: " << outName << " (" << header.nEntries << " of " << header.nSource << " events, " << columns.size() << " columns)" << std::endl;
+}
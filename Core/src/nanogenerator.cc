@@ -0,0 +1,411 @@
+#include <ChargedSkimming/Core/interface/nanogenerator.h>
+
+#include <cmath>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <TFile.h>
+
+namespace {
+    struct Kinematics {
+        float pt, eta, phi;
+        int charge;
+    };
+
+    void SortPt(std::vector<Kinematics>& objects){
+        std::sort(objects.begin(), objects.end(), [](const Kinematics& k1, const Kinematics& k2){return k1.pt > k2.pt;});
+    }
+}
+
+NanoGenerator::Config NanoGenerator::Preset(const std::string& name){
+    Config config;
+
+    if(name == "ttbar"){
+        config.isData = false;
+        config.nElectrons = 0.7;
+        config.nMuons = 0.7;
+        config.nJets = 6;
+        config.nFatJets = 1;
+        config.nIsotracks = 1;
+        config.triggerRate = 0.4;
+    }
+
+    else if(name == "data"){
+        config.isData = true;
+        config.nElectrons = 0.3;
+        config.nMuons = 0.3;
+        config.nJets = 3;
+        config.nFatJets = 0.3;
+        config.nIsotracks = 0.5;
+        config.triggerRate = 0.1;
+    }
+
+    else throw std::runtime_error("Unknown generator preset: '" + name + "', use 'ttbar' or 'data'");
+
+    return config;
+}
+
+NanoGenerator::Collection::Collection(const std::string& name, const std::vector<std::string>& floatNames, const std::vector<std::string>& intNames, const std::vector<std::string>& boolNames, const std::vector<std::string>& ucharNames) : name(name) {
+    for(const std::string& n : floatNames) floats[n] = std::vector<float>(maxSize, 0);
+    for(const std::string& n : intNames) ints[n] = std::vector<int>(maxSize, 0);
+    for(const std::string& n : boolNames) bools[n] = std::vector<char>(maxSize, 0);
+    for(const std::string& n : ucharNames) uchars[n] = std::vector<unsigned char>(maxSize, 0);
+}
+
+void NanoGenerator::Collection::Book(TTree* tree){
+    std::string counter = "n" + name;
+    tree->Branch(counter.c_str(), &size, (counter + "/i").c_str());
+
+    //Empty column name for collections which are a single array (e.g. LHEPdfWeight)
+    auto book = [&](const std::string& column, void* address, const std::string& type){
+        std::string branch = column == "" ? name : name + "_" + column;
+        tree->Branch(branch.c_str(), address, (branch + "[" + counter + "]/" + type).c_str());
+    };
+
+    for(std::pair<const std::string, std::vector<float>>& c : floats) book(c.first, c.second.data(), "F");
+    for(std::pair<const std::string, std::vector<int>>& c : ints) book(c.first, c.second.data(), "I");
+    for(std::pair<const std::string, std::vector<char>>& c : bools) book(c.first, c.second.data(), "O");
+    for(std::pair<const std::string, std::vector<unsigned char>>& c : uchars) book(c.first, c.second.data(), "b");
+}
+
+NanoGenerator::NanoGenerator(const Config& config) : config(config), random(config.seed) {
+    collections.emplace("Electron", Collection("Electron",
+        {"pt", "eCorr", "dEscaleUp", "dEscaleDown", "dEsigmaUp", "dEsigmaDown", "mass", "eta", "phi", "pfRelIso03_all", "dxy", "dz", "jetRelIso", "miniPFRelIso_all"},
+        {"charge", "cutBased"},
+        {"mvaFall17V2Iso_WPL", "mvaFall17V2Iso_WP90", "mvaFall17V2Iso_WP80", "convVeto"}
+    ));
+
+    collections.emplace("Muon", Collection("Muon",
+        {"pt", "eta", "phi", "pfRelIso03_all", "pfRelIso04_all", "miniPFRelIso_all", "dxy", "dz", "jetRelIso"},
+        {"charge", "nTrackerLayers"},
+        {"looseId", "mediumId", "tightId"},
+        {"mvaId"}
+    ));
+
+    collections.emplace("Jet", Collection("Jet",
+        {"pt", "eta", "phi", "mass", "area", "btagDeepB", "btagDeepFlavB", "rawFactor"},
+        config.isData ? std::vector<std::string>{"jetId", "puId"} : std::vector<std::string>{"jetId", "puId", "partonFlavour"}
+    ));
+
+    collections.emplace("FatJet", Collection("FatJet",
+        {"pt", "eta", "phi", "mass", "area", "tau1", "tau2", "tau3", "deepTag_H", "deepTag_QCD", "deepTag_TvsQCD", "deepTag_ZvsQCD", "deepTag_WvsQCD", "rawFactor"}
+    ));
+
+    collections.emplace("IsoTrack", Collection("IsoTrack",
+        {"pt", "eta", "phi", "dxy", "dz", "pfRelIso03_all", "pfRelIso04_all", "miniPFRelIso_all"},
+        {"pdgId"}
+    ));
+
+    if(!config.isData){
+        collections.emplace("GenJet", Collection("GenJet", {"pt", "eta", "phi"}));
+        collections.emplace("GenJetAK8", Collection("GenJetAK8", {"pt", "eta", "phi"}));
+        collections.emplace("GenPart", Collection("GenPart", {"pt", "eta", "phi", "mass"}, {"pdgId", "genPartIdxMother"}));
+        collections.emplace("LHEPdfWeight", Collection("LHEPdfWeight", {""}));
+        collections.emplace("LHEScaleWeight", Collection("LHEScaleWeight", {""}));
+    }
+
+    triggers = std::vector<char>(config.triggers.size(), 0);
+    METFilters = std::vector<char>(config.METFilters.size(), 0);
+}
+
+int NanoGenerator::AddGenPart(const int& pdgId, const int& mother, const float& pt, const float& eta, const float& phi, const float& mass){
+    Collection& gen = collections.at("GenPart");
+    if(gen.size == maxSize) return mother;
+
+    int idx = gen.size++;
+
+    gen.ints["pdgId"][idx] = pdgId;
+    gen.ints["genPartIdxMother"][idx] = mother;
+    gen.floats["pt"][idx] = pt;
+    gen.floats["eta"][idx] = eta;
+    gen.floats["phi"][idx] = phi;
+    gen.floats["mass"][idx] = mass;
+
+    return idx;
+}
+
+void NanoGenerator::FillGen(){
+    collections.at("GenPart").size = 0;
+
+    //Incoming gluons, ttbar pair with one intermediate copy each (as in the Pythia record)
+    int g = AddGenPart(21, -1, 0, 0, 0, 0);
+    AddGenPart(21, -1, 0, 0, 0, 0);
+
+    for(const int& sign : {1, -1}){
+        float pt = Pt(0, 80), eta = random.Gaus(0, 1.5), phi = random.Uniform(-M_PI, M_PI);
+
+        int top = AddGenPart(6*sign, g, pt, eta, phi, 172.5);
+        top = AddGenPart(6*sign, top, pt, eta, phi, 172.5);
+
+        int W = AddGenPart(24*sign, top, Pt(10, 60), eta + random.Gaus(0, 0.5), phi + random.Gaus(0, 0.5), 80.4);
+        AddGenPart(5*sign, top, Pt(20, 50), eta + random.Gaus(0, 0.5), phi + random.Gaus(0, 0.5), 4.8);
+
+        //Leptonic W decay in one third of the cases, equally to electrons and muons
+        if(random.Rndm() < 1./3){
+            int lepton = random.Rndm() < 0.5 ? 11 : 13;
+
+            AddGenPart(-lepton*sign, W, Pt(20, 40), random.Uniform(-2.4, 2.4), random.Uniform(-M_PI, M_PI), lepton == 11 ? 0.000511 : 0.1057);
+            AddGenPart((lepton + 1)*sign, W, Pt(20, 40), random.Uniform(-2.4, 2.4), random.Uniform(-M_PI, M_PI), 0);
+        }
+
+        else{
+            AddGenPart(2*sign, W, Pt(20, 40), random.Uniform(-2.5, 2.5), random.Uniform(-M_PI, M_PI), 0);
+            AddGenPart(-1*sign, W, Pt(20, 40), random.Uniform(-2.5, 2.5), random.Uniform(-M_PI, M_PI), 0);
+        }
+    }
+
+    //Initial state radiation
+    for(std::size_t i = 0, n = random.Poisson(2); i < n; ++i){
+        AddGenPart(21, g, Pt(5, 30), random.Uniform(-4, 4), random.Uniform(-M_PI, M_PI), 0);
+    }
+
+    //LHE weights, 103 PDF and 9 scale variations close to one
+    Collection& pdf = collections.at("LHEPdfWeight");
+    pdf.size = 103;
+    for(std::size_t i = 0; i < pdf.size; ++i) pdf.floats[""][i] = random.Gaus(1, 0.02);
+
+    Collection& scale = collections.at("LHEScaleWeight");
+    scale.size = 9;
+    for(std::size_t i = 0; i < scale.size; ++i) scale.floats[""][i] = random.Gaus(1, 0.1);
+
+    LHENjets = random.Poisson(1);
+    nTrueInt = random.Gaus(30, 10);
+
+    //NLO like generator weight, negative for a fifth of the events
+    genWeight = random.Rndm() < 0.2 ? -1000.f : 1000.f;
+}
+
+void NanoGenerator::FillObjects(){
+    //Gen leptons of the W decays are the seeds of the reconstructed leptons
+    std::vector<Kinematics> genElectrons, genMuons;
+
+    if(!config.isData){
+        Collection& gen = collections.at("GenPart");
+
+        for(std::size_t i = 0; i < gen.size; ++i){
+            int pdgId = gen.ints["pdgId"][i];
+            if(std::abs(pdgId) != 11 and std::abs(pdgId) != 13) continue;
+
+            Kinematics k{gen.floats["pt"][i], gen.floats["eta"][i], gen.floats["phi"][i], pdgId > 0 ? -1 : 1};
+            (std::abs(pdgId) == 11 ? genElectrons : genMuons).push_back(k);
+        }
+    }
+
+    auto leptons = [&](const std::vector<Kinematics>& genLeptons, const float& mean){
+        std::vector<Kinematics> objects;
+
+        for(std::size_t i = 0, n = Multiplicity(mean); i < std::max(n, genLeptons.size()) and i < maxSize; ++i){
+            if(i < genLeptons.size()) objects.push_back({genLeptons[i].pt * float(random.Gaus(1, 0.02)), genLeptons[i].eta, genLeptons[i].phi, genLeptons[i].charge});
+            else objects.push_back({Pt(5, 20), float(random.Uniform(-2.5, 2.5)), float(random.Uniform(-M_PI, M_PI)), random.Rndm() < 0.5 ? -1 : 1});
+        }
+
+        SortPt(objects);
+        return objects;
+    };
+
+    //Electrons
+    Collection& ele = collections.at("Electron");
+    std::vector<Kinematics> electrons = leptons(genElectrons, config.nElectrons);
+    ele.size = electrons.size();
+
+    for(std::size_t i = 0; i < ele.size; ++i){
+        ele.floats["pt"][i] = electrons[i].pt;
+        ele.floats["eta"][i] = electrons[i].eta;
+        ele.floats["phi"][i] = electrons[i].phi;
+        ele.floats["mass"][i] = 0.000511;
+        ele.floats["eCorr"][i] = random.Gaus(1, 0.01);
+        ele.floats["dEscaleUp"][i] = random.Gaus(0, 0.002);
+        ele.floats["dEscaleDown"][i] = -ele.floats["dEscaleUp"][i];
+        ele.floats["dEsigmaUp"][i] = random.Gaus(0, 0.005);
+        ele.floats["dEsigmaDown"][i] = -ele.floats["dEsigmaUp"][i];
+        ele.floats["pfRelIso03_all"][i] = random.Exp(0.1);
+        ele.floats["miniPFRelIso_all"][i] = random.Exp(0.1);
+        ele.floats["jetRelIso"][i] = random.Exp(0.2);
+        ele.floats["dxy"][i] = random.Gaus(0, 0.01);
+        ele.floats["dz"][i] = random.Gaus(0, 0.02);
+        ele.ints["charge"][i] = electrons[i].charge;
+        ele.ints["cutBased"][i] = random.Integer(5);
+
+        float mva = random.Rndm();
+        ele.bools["mvaFall17V2Iso_WPL"][i] = mva < 0.95;
+        ele.bools["mvaFall17V2Iso_WP90"][i] = mva < 0.9;
+        ele.bools["mvaFall17V2Iso_WP80"][i] = mva < 0.8;
+        ele.bools["convVeto"][i] = random.Rndm() < 0.95;
+    }
+
+    //Muons
+    Collection& mu = collections.at("Muon");
+    std::vector<Kinematics> muons = leptons(genMuons, config.nMuons);
+    mu.size = muons.size();
+
+    for(std::size_t i = 0; i < mu.size; ++i){
+        mu.floats["pt"][i] = muons[i].pt;
+        mu.floats["eta"][i] = muons[i].eta;
+        mu.floats["phi"][i] = muons[i].phi;
+        mu.floats["pfRelIso03_all"][i] = random.Exp(0.1);
+        mu.floats["pfRelIso04_all"][i] = random.Exp(0.1);
+        mu.floats["miniPFRelIso_all"][i] = random.Exp(0.1);
+        mu.floats["jetRelIso"][i] = random.Exp(0.2);
+        mu.floats["dxy"][i] = random.Gaus(0, 0.01);
+        mu.floats["dz"][i] = random.Gaus(0, 0.02);
+        mu.ints["charge"][i] = muons[i].charge;
+        mu.ints["nTrackerLayers"][i] = 8 + random.Integer(10);
+
+        float id = random.Rndm();
+        mu.bools["looseId"][i] = id < 0.98;
+        mu.bools["mediumId"][i] = id < 0.95;
+        mu.bools["tightId"][i] = id < 0.9;
+        mu.uchars["mvaId"][i] = random.Integer(4);
+    }
+
+    //Jets, for MC the gen jets are the jets smeared with the resolution
+    auto jets = [&](const std::string& name, const std::string& genName, const float& mean, const float& minPt, const float& slope){
+        std::vector<Kinematics> objects;
+        for(std::size_t i = 0, n = Multiplicity(mean); i < n; ++i) objects.push_back({Pt(minPt, slope), float(random.Uniform(-2.5, 2.5)), float(random.Uniform(-M_PI, M_PI)), 0});
+        SortPt(objects);
+
+        Collection& jet = collections.at(name);
+        jet.size = objects.size();
+
+        for(std::size_t i = 0; i < jet.size; ++i){
+            jet.floats["pt"][i] = objects[i].pt;
+            jet.floats["eta"][i] = objects[i].eta;
+            jet.floats["phi"][i] = objects[i].phi;
+            jet.floats["rawFactor"][i] = random.Uniform(0, 0.3);
+        }
+
+        if(config.isData) return;
+
+        Collection& genJet = collections.at(genName);
+        genJet.size = objects.size();
+
+        for(std::size_t i = 0; i < genJet.size; ++i){
+            genJet.floats["pt"][i] = objects[i].pt * random.Gaus(1, 0.1);
+            genJet.floats["eta"][i] = objects[i].eta;
+            genJet.floats["phi"][i] = objects[i].phi;
+        }
+    };
+
+    jets("Jet", "GenJet", config.nJets, 15, 40);
+    jets("FatJet", "GenJetAK8", config.nFatJets, 170, 100);
+
+    Collection& jet = collections.at("Jet");
+
+    for(std::size_t i = 0; i < jet.size; ++i){
+        jet.floats["mass"][i] = jet.floats["pt"][i] * random.Uniform(0.05, 0.2);
+        jet.floats["area"][i] = random.Gaus(0.5, 0.02);
+        jet.floats["btagDeepB"][i] = random.Rndm();
+        jet.floats["btagDeepFlavB"][i] = random.Rndm();
+        jet.ints["jetId"][i] = random.Rndm() < 0.95 ? 6 : 2;
+        jet.ints["puId"][i] = random.Rndm() < 0.9 ? 7 : 0;
+
+        if(!config.isData){
+            static const int flavours[] = {0, 1, 2, 3, 4, 5, 21};
+            jet.ints["partonFlavour"][i] = i < 2 ? 5 : flavours[random.Integer(7)];
+        }
+    }
+
+    Collection& fatJet = collections.at("FatJet");
+
+    for(std::size_t i = 0; i < fatJet.size; ++i){
+        fatJet.floats["mass"][i] = random.Uniform(20, 200);
+        fatJet.floats["area"][i] = random.Gaus(2, 0.05);
+
+        float tau1 = random.Uniform(0.1, 0.5);
+        fatJet.floats["tau1"][i] = tau1;
+        fatJet.floats["tau2"][i] = tau1 * random.Uniform(0.3, 1);
+        fatJet.floats["tau3"][i] = fatJet.floats["tau2"][i] * random.Uniform(0.3, 1);
+
+        for(const std::string& tag : {"deepTag_H", "deepTag_QCD", "deepTag_TvsQCD", "deepTag_ZvsQCD", "deepTag_WvsQCD"}){
+            fatJet.floats[tag][i] = random.Rndm();
+        }
+    }
+
+    //Isolated tracks
+    Collection& isotrk = collections.at("IsoTrack");
+    std::vector<Kinematics> tracks;
+    for(std::size_t i = 0, n = Multiplicity(config.nIsotracks); i < n; ++i) tracks.push_back({Pt(5, 10), float(random.Uniform(-2.5, 2.5)), float(random.Uniform(-M_PI, M_PI)), 0});
+    SortPt(tracks);
+    isotrk.size = tracks.size();
+
+    for(std::size_t i = 0; i < isotrk.size; ++i){
+        static const int pdgIds[] = {11, -11, 13, -13, 211, -211};
+
+        isotrk.floats["pt"][i] = tracks[i].pt;
+        isotrk.floats["eta"][i] = tracks[i].eta;
+        isotrk.floats["phi"][i] = tracks[i].phi;
+        isotrk.floats["dxy"][i] = random.Gaus(0, 0.01);
+        isotrk.floats["dz"][i] = random.Gaus(0, 0.02);
+        isotrk.floats["pfRelIso03_all"][i] = random.Exp(0.1);
+        isotrk.floats["pfRelIso04_all"][i] = random.Exp(0.1);
+        isotrk.floats["miniPFRelIso_all"][i] = random.Exp(0.1);
+        isotrk.ints["pdgId"][i] = pdgIds[random.Integer(6)];
+    }
+
+    //Event level quantities
+    rho = random.Gaus(20, 5);
+    METPt = Pt(0, 40);
+    METPhi = random.Uniform(-M_PI, M_PI);
+    METDeltaX = random.Gaus(0, 2);
+    METDeltaY = random.Gaus(0, 2);
+    preFire = random.Uniform(0.95, 1);
+    preFireUp = std::min(preFire + 0.01f, 1.f);
+    preFireDown = preFire - 0.01f;
+
+    for(char& fired : triggers) fired = random.Rndm() < config.triggerRate;
+    for(char& passed : METFilters) passed = random.Rndm() < config.filterRate;
+}
+
+void NanoGenerator::Write(const std::string& fileName){
+    std::shared_ptr<TFile> outFile = std::make_shared<TFile>(fileName.c_str(), "RECREATE");
+    if(!outFile or outFile->IsZombie()) throw std::runtime_error("Could not create file: '" + fileName + "'");
+
+    std::shared_ptr<TTree> tree = std::make_shared<TTree>("Events", "Events");
+    tree->SetDirectory(outFile.get());
+
+    tree->Branch("run", &run, "run/i");
+    tree->Branch("luminosityBlock", &luminosityBlock, "luminosityBlock/i");
+    tree->Branch("event", &event, "event/l");
+    tree->Branch("fixedGridRhoFastjetAll", &rho, "fixedGridRhoFastjetAll/F");
+    tree->Branch("MET_pt", &METPt, "MET_pt/F");
+    tree->Branch("MET_phi", &METPhi, "MET_phi/F");
+    tree->Branch("MET_MetUnclustEnUpDeltaX", &METDeltaX, "MET_MetUnclustEnUpDeltaX/F");
+    tree->Branch("MET_MetUnclustEnUpDeltaY", &METDeltaY, "MET_MetUnclustEnUpDeltaY/F");
+    tree->Branch("L1PreFiringWeight_Nom", &preFire, "L1PreFiringWeight_Nom/F");
+    tree->Branch("L1PreFiringWeight_Up", &preFireUp, "L1PreFiringWeight_Up/F");
+    tree->Branch("L1PreFiringWeight_Dn", &preFireDown, "L1PreFiringWeight_Dn/F");
+
+    if(!config.isData){
+        tree->Branch("Pileup_nTrueInt", &nTrueInt, "Pileup_nTrueInt/F");
+        tree->Branch("genWeight", &genWeight, "genWeight/F");
+        tree->Branch("LHE_Njets", &LHENjets, "LHE_Njets/b");
+    }
+
+    for(std::size_t i = 0; i < triggers.size(); ++i) tree->Branch(config.triggers[i].c_str(), &triggers[i], (config.triggers[i] + "/O").c_str());
+    for(std::size_t i = 0; i < METFilters.size(); ++i) tree->Branch(config.METFilters[i].c_str(), &METFilters[i], (config.METFilters[i] + "/O").c_str());
+
+    for(std::pair<const std::string, Collection>& c : collections) c.second.Book(tree.get());
+
+    for(std::size_t entry = 0; entry < config.nEvents; ++entry){
+        if(entry % 100000 == 0 and entry != 0) std::cout << "Events generated: " << entry << " of " << config.nEvents << std::endl;
+
+        //Data like run/lumi numbering, 1000 events per lumi section
+        run = config.isData ? 316000 + entry / 100000 : 1;
+        luminosityBlock = 1 + entry / 1000;
+        event = entry + 1;
+
+        if(!config.isData) FillGen();
+        FillObjects();
+
+        tree->Fill();
+    }
+
+    outFile->cd();
+    tree->Write();
+    std::cout << "Written synthetic NanoAOD: " << fileName << " (" << tree->GetEntries() << " events, " << (config.isData ? "data" : "MC") << ")" << std::endl;
+
+    tree.reset();
+    outFile->Close();
+}
@@ -1,135 +1,243 @@
 #include <ChargedSkimming/Core/interface/nanoinput.h>
 
-NanoInput::NanoInput(const std::string& fileName, const std::string& treeName){
-    inputFile = std::shared_ptr<TFile>(TFile::Open(fileName.c_str(), "READ"));
-    inputTree.reset(static_cast<TTree*>(inputFile->Get(treeName.c_str())));
+#include <iostream>
+
+NanoInput::NanoInput(const std::string& fileName, const std::string& treeName, const std::string& cacheFile){
+    this->fileName = fileName;
+    if(cacheFile != "") cache = std::make_shared<NanoCache>(cacheFile);
+
+    else{
+        inputFile = std::shared_ptr<TFile>(TFile::Open(fileName.c_str(), "READ"));
+        inputTree.reset(static_cast<TTree*>(inputFile->Get(treeName.c_str())));
+    }
 
     //Weight related
-    pdfWeightL = inputTree->GetLeaf("LHEPdfWeight");
-    scaleWeightL = inputTree->GetLeaf("LHEScaleWeight");
-    nTrueIntL = inputTree->GetLeaf("Pileup_nTrueInt");
-    preFireL = inputTree->GetLeaf("L1PreFiringWeight_Nom");
-    preFireUpL = inputTree->GetLeaf("L1PreFiringWeight_Up");
-    preFireDownL = inputTree->GetLeaf("L1PreFiringWeight_Dn");
+    pdfWeightL = GetLeaf("LHEPdfWeight");
+    scaleWeightL = GetLeaf("LHEScaleWeight");
+    nTrueIntL = GetLeaf("Pileup_nTrueInt");
+    genWeightL = GetLeaf("genWeight");
+    preFireL = GetLeaf("L1PreFiringWeight_Nom");
+    preFireUpL = GetLeaf("L1PreFiringWeight_Up");
+    preFireDownL = GetLeaf("L1PreFiringWeight_Dn");
 
     //Electron related stuff
-    elePtL = inputTree->GetLeaf("Electron_pt");
-    eleECorrL = inputTree->GetLeaf("Electron_eCorr");
-    eleScaleUpL = inputTree->GetLeaf("Electron_dEscaleUp");
-    eleScaleDownL = inputTree->GetLeaf("Electron_dEscaleDown");
-    eleSigmaUpL = inputTree->GetLeaf("Electron_dEsigmaUp");
-    eleSigmaDownL = inputTree->GetLeaf("Electron_dEsigmaDown");
-    eleMassL = inputTree->GetLeaf("Electron_mass");
-    eleEtaL = inputTree->GetLeaf("Electron_eta");
-    elePhiL = inputTree->GetLeaf("Electron_phi");
-    eleIso03L = inputTree->GetLeaf("Electron_pfRelIso03_all");
-    eleDxyL = inputTree->GetLeaf("Electron_dxy");
-    eleDzL = inputTree->GetLeaf("Electron_dz");
-    eleRelJetIsoL = inputTree->GetLeaf("Electron_jetRelIso");
-    eleMiniIsoL = inputTree->GetLeaf("Electron_miniPFRelIso_all");
-    eleChargeL = inputTree->GetLeaf("Electron_charge");
-    eleCutIDL = inputTree->GetLeaf("Electron_cutBased");
-    eleMVAIDLooseL = inputTree->GetLeaf("Electron_mvaFall17V2Iso_WPL");
-    eleMVAIDMediumL = inputTree->GetLeaf("Electron_mvaFall17V2Iso_WP90");
-    eleMVAIDTightL = inputTree->GetLeaf("Electron_mvaFall17V2Iso_WP80");
-    eleConvVetoL = inputTree->GetLeaf("Electron_convVeto");
+    elePtL = GetLeaf("Electron_pt");
+    eleECorrL = GetLeaf("Electron_eCorr");
+    eleScaleUpL = GetLeaf("Electron_dEscaleUp");
+    eleScaleDownL = GetLeaf("Electron_dEscaleDown");
+    eleSigmaUpL = GetLeaf("Electron_dEsigmaUp");
+    eleSigmaDownL = GetLeaf("Electron_dEsigmaDown");
+    eleMassL = GetLeaf("Electron_mass");
+    eleEtaL = GetLeaf("Electron_eta");
+    elePhiL = GetLeaf("Electron_phi");
+    eleIso03L = GetLeaf("Electron_pfRelIso03_all");
+    eleDxyL = GetLeaf("Electron_dxy");
+    eleDzL = GetLeaf("Electron_dz");
+    eleRelJetIsoL = GetLeaf("Electron_jetRelIso");
+    eleMiniIsoL = GetLeaf("Electron_miniPFRelIso_all");
+    eleChargeL = GetLeaf("Electron_charge");
+    eleCutIDL = GetLeaf("Electron_cutBased");
+    eleMVAIDLooseL = GetLeaf("Electron_mvaFall17V2Iso_WPL");
+    eleMVAIDMediumL = GetLeaf("Electron_mvaFall17V2Iso_WP90");
+    eleMVAIDTightL = GetLeaf("Electron_mvaFall17V2Iso_WP80");
+    eleConvVetoL = GetLeaf("Electron_convVeto");
 
     //Muon related stuff
-    muPtL = inputTree->GetLeaf("Muon_pt");
-    muEtaL = inputTree->GetLeaf("Muon_eta");
-    muPhiL = inputTree->GetLeaf("Muon_phi");
-    muIso03L = inputTree->GetLeaf("Muon_pfRelIso03_all");
-    muIso04L = inputTree->GetLeaf("Muon_pfRelIso04_all");
-    muMiniIsoL = inputTree->GetLeaf("Muon_miniPFRelIso_all");
-    muChargeL = inputTree->GetLeaf("Muon_charge");
-    muCutIDLooseL = inputTree->GetLeaf("Muon_looseId");
-    muCutIDMediumL = inputTree->GetLeaf("Muon_mediumId");
-    muCutIDTightL = inputTree->GetLeaf("Muon_tightId");
-    muMVAIDL = inputTree->GetLeaf("Muon_mvaId");
-    muDxyL = inputTree->GetLeaf("Muon_dxy");
-    muDzL = inputTree->GetLeaf("Muon_dz");
-    muRelJetIsoL = inputTree->GetLeaf("Muon_jetRelIso");
-    muNTrackerLayersL = inputTree->GetLeaf("Muon_nTrackerLayers");
+    muPtL = GetLeaf("Muon_pt");
+    muEtaL = GetLeaf("Muon_eta");
+    muPhiL = GetLeaf("Muon_phi");
+    muIso03L = GetLeaf("Muon_pfRelIso03_all");
+    muIso04L = GetLeaf("Muon_pfRelIso04_all");
+    muMiniIsoL = GetLeaf("Muon_miniPFRelIso_all");
+    muChargeL = GetLeaf("Muon_charge");
+    muCutIDLooseL = GetLeaf("Muon_looseId");
+    muCutIDMediumL = GetLeaf("Muon_mediumId");
+    muCutIDTightL = GetLeaf("Muon_tightId");
+    muMVAIDL = GetLeaf("Muon_mvaId");
+    muDxyL = GetLeaf("Muon_dxy");
+    muDzL = GetLeaf("Muon_dz");
+    muRelJetIsoL = GetLeaf("Muon_jetRelIso");
+    muNTrackerLayersL = GetLeaf("Muon_nTrackerLayers");
 
     //Jet related stuff
-    rhoL = inputTree->GetLeaf("fixedGridRhoFastjetAll");
-
-    metPtL = inputTree->GetLeaf("MET_pt");
-    metPhiL = inputTree->GetLeaf("MET_phi");
-    metDeltaUnClustXL = inputTree->GetLeaf("MET_MetUnclustEnUpDeltaX");
-    metDeltaUnClustYL = inputTree->GetLeaf("MET_MetUnclustEnUpDeltaY");
-
-    jetPtL = inputTree->GetLeaf("Jet_pt");
-    jetEtaL = inputTree->GetLeaf("Jet_eta");
-    jetPhiL = inputTree->GetLeaf("Jet_phi");
-    jetMassL = inputTree->GetLeaf("Jet_mass");
-    jetAreaL = inputTree->GetLeaf("Jet_area");
-    jetDeepCSVL = inputTree->GetLeaf("Jet_btagDeepB");
-    jetDeepJetL = inputTree->GetLeaf("Jet_btagDeepFlavB");
-    jetPartFlavL = inputTree->GetLeaf("Jet_partonFlavour");
-    jetRawFacL = inputTree->GetLeaf("Jet_rawFactor");
-    jetIDL = inputTree->GetLeaf("Jet_jetId");
-    jetPUIDL = inputTree->GetLeaf("Jet_puId");
-
-    genJetPtL = inputTree->GetLeaf("GenJet_pt");
-    genJetEtaL = inputTree->GetLeaf("GenJet_eta");
-    genJetPhiL = inputTree->GetLeaf("GenJet_phi");
-
-    fatJetPtL = inputTree->GetLeaf("FatJet_pt");
-    fatJetEtaL = inputTree->GetLeaf("FatJet_eta");
-    fatJetPhiL = inputTree->GetLeaf("FatJet_phi");
-    fatJetMassL = inputTree->GetLeaf("FatJet_mass");
-    fatJetAreaL = inputTree->GetLeaf("FatJet_area");
-    fatJetTau1L = inputTree->GetLeaf("FatJet_tau1");
-    fatJetTau2L = inputTree->GetLeaf("FatJet_tau2");
-    fatJetTau3L = inputTree->GetLeaf("FatJet_tau3");
-    fatJetDAK8HiggsL = inputTree->GetLeaf("FatJet_deepTag_H");
-    fatJetDAK8QCDL = inputTree->GetLeaf("FatJet_deepTag_QCD");
-    fatJetDAK8TvsQCDL = inputTree->GetLeaf("FatJet_deepTag_TvsQCD");
-    fatJetDAK8ZvsQCDL = inputTree->GetLeaf("FatJet_deepTag_ZvsQCD");
-    fatJetDAK8WvsQCDL = inputTree->GetLeaf("FatJet_deepTag_WvsQCD");
-    fatJetRawFacL = inputTree->GetLeaf("FatJet_rawFactor");
-
-    genFatJetPtL = inputTree->GetLeaf("GenJetAK8_pt");
-    genFatJetEtaL = inputTree->GetLeaf("GenJetAK8_eta");
-    genFatJetPhiL = inputTree->GetLeaf("GenJetAK8_phi");
+    rhoL = GetLeaf("fixedGridRhoFastjetAll");
+
+    metPtL = GetLeaf("MET_pt");
+    metPhiL = GetLeaf("MET_phi");
+    metDeltaUnClustXL = GetLeaf("MET_MetUnclustEnUpDeltaX");
+    metDeltaUnClustYL = GetLeaf("MET_MetUnclustEnUpDeltaY");
+
+    jetPtL = GetLeaf("Jet_pt");
+    jetEtaL = GetLeaf("Jet_eta");
+    jetPhiL = GetLeaf("Jet_phi");
+    jetMassL = GetLeaf("Jet_mass");
+    jetAreaL = GetLeaf("Jet_area");
+    jetDeepCSVL = GetLeaf("Jet_btagDeepB");
+    jetDeepJetL = GetLeaf("Jet_btagDeepFlavB");
+    jetPartFlavL = GetLeaf("Jet_partonFlavour");
+    jetRawFacL = GetLeaf("Jet_rawFactor");
+    jetIDL = GetLeaf("Jet_jetId");
+    jetPUIDL = GetLeaf("Jet_puId");
+
+    genJetPtL = GetLeaf("GenJet_pt");
+    genJetEtaL = GetLeaf("GenJet_eta");
+    genJetPhiL = GetLeaf("GenJet_phi");
+
+    fatJetPtL = GetLeaf("FatJet_pt");
+    fatJetEtaL = GetLeaf("FatJet_eta");
+    fatJetPhiL = GetLeaf("FatJet_phi");
+    fatJetMassL = GetLeaf("FatJet_mass");
+    fatJetAreaL = GetLeaf("FatJet_area");
+    fatJetTau1L = GetLeaf("FatJet_tau1");
+    fatJetTau2L = GetLeaf("FatJet_tau2");
+    fatJetTau3L = GetLeaf("FatJet_tau3");
+    fatJetDAK8HiggsL = GetLeaf("FatJet_deepTag_H");
+    fatJetDAK8QCDL = GetLeaf("FatJet_deepTag_QCD");
+    fatJetDAK8TvsQCDL = GetLeaf("FatJet_deepTag_TvsQCD");
+    fatJetDAK8ZvsQCDL = GetLeaf("FatJet_deepTag_ZvsQCD");
+    fatJetDAK8WvsQCDL = GetLeaf("FatJet_deepTag_WvsQCD");
+    fatJetRawFacL = GetLeaf("FatJet_rawFactor");
+
+    genFatJetPtL = GetLeaf("GenJetAK8_pt");
+    genFatJetEtaL = GetLeaf("GenJetAK8_eta");
+    genFatJetPhiL = GetLeaf("GenJetAK8_phi");
 
     //Iso. track related
-    isotrkPtL = inputTree->GetLeaf("IsoTrack_pt");
-    isotrkEtaL = inputTree->GetLeaf("IsoTrack_eta");
-    isotrkPhiL = inputTree->GetLeaf("IsoTrack_phi"); 
-    isotrkDxyL = inputTree->GetLeaf("IsoTrack_dxy"); 
-    isotrkDzL = inputTree->GetLeaf("IsoTrack_dz"); 
-    isotrkPDGL = inputTree->GetLeaf("IsoTrack_pdgId"); 
-    isotrkIso03L = inputTree->GetLeaf("IsoTrack_pfRelIso03_all");
-    isotrkIso04L = inputTree->GetLeaf("IsoTrack_pfRelIso04_all");
-    isotrkMiniIsoL = inputTree->GetLeaf("IsoTrack_miniPFRelIso_all");
+    isotrkPtL = GetLeaf("IsoTrack_pt");
+    isotrkEtaL = GetLeaf("IsoTrack_eta");
+    isotrkPhiL = GetLeaf("IsoTrack_phi"); 
+    isotrkDxyL = GetLeaf("IsoTrack_dxy"); 
+    isotrkDzL = GetLeaf("IsoTrack_dz"); 
+    isotrkPDGL = GetLeaf("IsoTrack_pdgId"); 
+    isotrkIso03L = GetLeaf("IsoTrack_pfRelIso03_all");
+    isotrkIso04L = GetLeaf("IsoTrack_pfRelIso04_all");
+    isotrkMiniIsoL = GetLeaf("IsoTrack_miniPFRelIso_all");
 
     //Misc related
-    evNrL = inputTree->GetLeaf("event");
-    nPartonL = inputTree->GetLeaf("LHE_Njets");
+    evNrL = GetLeaf("event");
+    runNrL = GetLeaf("run");
+    lumiNrL = GetLeaf("luminosityBlock");
+    nPartonL = GetLeaf("LHE_Njets");
+    cacheEntryL = cache ? GetLeaf("CacheEntry") : nullptr;
+
+    //Run number selects e.g. the JEC run period, there is no sensible default
+    if(runNrL == nullptr) throw std::runtime_error(cache ? "NanoAOD cache has no run column, rebuild it with NanoCache: '" + cacheFile + "'" : "Input file has no run branch: '" + fileName + "'");
 
     //Gen part related
-    genPDGL = inputTree->GetLeaf("GenPart_pdgId");
-    genMotherIdxL = inputTree->GetLeaf("GenPart_genPartIdxMother");
-    genPtL = inputTree->GetLeaf("GenPart_pt");
-    genPhiL = inputTree->GetLeaf("GenPart_phi");
-    genEtaL = inputTree->GetLeaf("GenPart_eta");
-    genMassL = inputTree->GetLeaf("GenPart_mass");
+    genPDGL = GetLeaf("GenPart_pdgId");
+    genMotherIdxL = GetLeaf("GenPart_genPartIdxMother");
+    genPtL = GetLeaf("GenPart_pt");
+    genPhiL = GetLeaf("GenPart_phi");
+    genEtaL = GetLeaf("GenPart_eta");
+    genMassL = GetLeaf("GenPart_mass");
+}
+
+NanoLeaf* NanoInput::GetLeaf(const std::string& name){
+    if(cache){
+        int column = cache->FindColumn(name);
+        if(column < 0) return nullptr;
+
+        leaves.push_back(std::make_shared<NanoLeaf>(name, cache.get(), column));
+    }
+
+    else{
+        TLeaf* leaf = inputTree->GetLeaf(name.c_str());
+        if(leaf == nullptr) return nullptr;
+
+        leaves.push_back(std::make_shared<NanoLeaf>(name, leaf));
+    }
+
+    leaves.back()->CountReads(countReads);
+
+    return leaves.back().get();
+}
+
+std::vector<std::string> NanoInput::LeafNames() const {
+    std::vector<std::string> names;
+    for(const std::shared_ptr<NanoLeaf>& leaf : leaves) names.push_back(leaf->GetName());
+
+    return names;
+}
+
+void NanoInput::EnableIOReport(){
+    countReads = true;
+    for(std::shared_ptr<NanoLeaf>& leaf : leaves) leaf->CountReads(true);
+
+    //Disk/decompression time of the whole tree, per leaf only the total read time is known
+    if(inputTree) perfStats = std::make_shared<TTreePerfStats>("IOPerfStats", inputTree.get());
+}
+
+void NanoInput::WriteIOReport(const std::string& fileName){
+    if(!countReads) return;
+
+    pt::ptree report, summary, leafList, unused;
+
+    if(perfStats){
+        perfStats->Finish();
+        inputTree->SetPerfStats(nullptr);
+
+        summary.put("BytesRead", perfStats->GetBytesRead());
+        summary.put("ReadCalls", perfStats->GetReadCalls());
+        summary.put("DiskTime", perfStats->GetDiskTime());
+        summary.put("UnzipTime", perfStats->GetUnzipTime());
+        summary.put("RealTime", perfStats->GetRealTime());
+        summary.put("CpuTime", perfStats->GetCpuTime());
+    }
+
+    std::vector<std::shared_ptr<NanoLeaf>> ranked = leaves;
+    std::sort(ranked.begin(), ranked.end(), [](const std::shared_ptr<NanoLeaf>& l1, const std::shared_ptr<NanoLeaf>& l2){return l1->GetReadTime() > l2->GetReadTime();});
+
+    long long totalTime = 0, totalBytes = 0;
+
+    for(const std::shared_ptr<NanoLeaf>& leaf : ranked){
+        totalTime += leaf->GetReadTime();
+        totalBytes += leaf->GetBytesRead();
+
+        pt::ptree l;
+        l.put("Name", leaf->GetName());
+        l.put("Reads", leaf->GetReads());
+        l.put("Bytes", leaf->GetBytesRead());
+        l.put("CompressedBytes", (long long)(leaf->GetBytesRead() / leaf->GetCompression()));
+        l.put("ReadTime", leaf->GetReadTime()/1e9);
+        l.put("ValuesUsed", leaf->GetValuesUsed());
+
+        leafList.push_back(std::make_pair("", l));
+
+        //Resolved for this era/data type, but the analyzers never looked at a value
+        if(leaf->GetValuesUsed() == 0){
+            pt::ptree u;
+            u.put("", leaf->GetName());
+            unused.push_back(std::make_pair("", u));
+        }
+    }
+
+    summary.put("LeafReadTime", totalTime/1e9);
+    summary.put("LeafBytes", totalBytes);
+
+    report.put("File", this->fileName);
+    report.add_child("Summary", summary);
+    report.add_child("Leaves", leafList);
+    report.add_child("Unused", unused);
+
+    pt::write_json(fileName, report);
+    std::cout << "Written I/O report: " << fileName << " (" << leaves.size() << " leaves, " << unused.size() << " never used)" << std::endl;
 }
 
 void NanoInput::SetWeight(){
+    Tracer::Span span(tracer, "ReadWeight", "input");
+
     if(pdfWeightL != nullptr){
-        pdfWeightL->GetBranch()->GetEntry(entry);
-        scaleWeightL->GetBranch()->GetEntry(entry);
+        pdfWeightL->GetEntry(entry);
+        scaleWeightL->GetEntry(entry);
     }
 
-    nTrueIntL->GetBranch()->GetEntry(entry);
+    nTrueIntL->GetEntry(entry);
+    if(genWeightL != nullptr) genWeightL->GetEntry(entry);
     
     if(preFireL != nullptr){
-        preFireL->GetBranch()->GetEntry(entry);
-        preFireUpL->GetBranch()->GetEntry(entry);
-        preFireDownL->GetBranch()->GetEntry(entry);
+        preFireL->GetEntry(entry);
+        preFireUpL->GetEntry(entry);
+        preFireDownL->GetEntry(entry);
     }
 }
 
@@ -148,6 +256,8 @@ void NanoInput::GetWeightEntry(){
         std::fill_n(pdfWeight, 102, 1);
         std::fill_n(scaleWeight, 8, 1);
     }
+
+    genWeight = genWeightL != nullptr ? genWeightL->GetValue() : 1.;
     
     if(preFireL != nullptr){
         preFire = preFireL->GetValue();
@@ -167,72 +277,131 @@ void NanoInput::GetWeightEntry(){
 void NanoInput::SetTrigger(const std::vector<std::string>& names, const bool& isMETFilter){
     if(!isMETFilter){
         for(const std::string& name : names){
-            triggerL.push_back(inputTree->GetLeaf(name.c_str()));
-            triggers.push_back(true);
+            triggerL.push_back(GetLeaf(name));
+            triggerNames.push_back(name);
         }
+
+        triggerMask = std::vector<std::uint64_t>((triggerNames.size() + 63)/64, 0);
     }
 
     else{
         for(const std::string& name : names){
-            TLeaf* filter = inputTree->GetLeaf(name.c_str());
+            NanoLeaf* filter = GetLeaf(name);
             if(filter == nullptr){
                 std::cout << "MET filter not found: '" + name + "', continue without it!" << std::endl;
                 continue;
             }
         
             METFilterL.push_back(filter);
-            METFilter.push_back(true);
+            METFilterNames.push_back(name);
         }
+
+        METFilterMask = std::vector<std::uint64_t>((METFilterNames.size() + 63)/64, 0);
+    }
+}
+
+void NanoInput::SetZoneMap(const std::string& cacheDir, const std::vector<ZoneRequirement>& requirements){
+    if(cache){
+        std::cout << "Zone map is not used together with a NanoAOD cache" << std::endl;
+        return;
     }
+
+    zoneMap = std::make_shared<ZoneMap>(cacheDir, inputFile->GetName(), inputTree.get(), triggerNames);
+    zoneMap->SetRequirements(requirements);
+}
+
+std::vector<std::size_t> NanoInput::EventListEntries(const std::string& eventList, const std::string& indexDir, const bool& isData){
+    if(!isData) throw std::runtime_error("Event list is only possible for data, for MC the weight sums of the skim would only contain the listed events");
+    if(cache) throw std::runtime_error("Event list can not be used together with a NanoAOD cache, entries of the cache are not the entries of the input file");
+
+    EventIndex index(indexDir, inputFile->GetName(), inputTree.get());
+    std::vector<EventIndex::Record> events = EventIndex::ReadEventList(eventList);
+    std::vector<std::size_t> entries = index.Find(events);
+
+    std::cout << "Found " << entries.size() << " of " << events.size() << " listed events in " << inputFile->GetName() << std::endl;
+
+    return entries;
+}
+
+std::size_t NanoInput::ZoneMapEntry(const std::size_t& entry){
+    if(!zoneMap) return entry;
+    if(zoneMap->Complete()) return zoneMap->NextEntry(entry);
+
+    //Index is build on the first pass, the branches read here are needed by the analyzers anyway (data only)
+    SetEntry(entry);
+    ReadEleEntry();
+    ReadMuEntry();
+    ReadJetEntry(true);
+    ReadTrigger();
+    GetTrigger();
+
+    float leadingLeptonPt = std::max(eleSize != 0 ? elePtL->GetValue(0) : 0., muSize != 0 ? muPtL->GetValue(0) : 0.);
+    zoneMap->Fill(entry, eleSize, muSize, jetSize, fatJetSize, leadingLeptonPt, triggerMask);
+
+    return entry;
+}
+
+void NanoInput::WriteZoneMap(){
+    if(zoneMap) zoneMap->Write();
 }
 
 void NanoInput::ReadTrigger(){
-    for(TLeaf* trigger : triggerL) trigger->GetBranch()->GetEntry(entry);
+    Tracer::Span span(tracer, "ReadTrigger", "input");
+
+    for(NanoLeaf* trigger : triggerL) trigger->GetEntry(entry);
 }
 
 void NanoInput::ReadMETFilter(){
-    for(TLeaf* trigger : METFilterL) trigger->GetBranch()->GetEntry(entry);
+    Tracer::Span span(tracer, "ReadMETFilter", "input");
+
+    for(NanoLeaf* trigger : METFilterL) trigger->GetEntry(entry);
 }
 
 void NanoInput::GetTrigger(){
+    std::fill(triggerMask.begin(), triggerMask.end(), 0);
+
     for(std::size_t i = 0; i < triggerL.size(); ++i){
-        triggers[i] = triggerL[i]->GetValue();
+        if(triggerL[i]->GetValue()) triggerMask[i/64] |= std::uint64_t(1) << i%64;
     }
 }
 
 void NanoInput::GetMETFilter(){
+    std::fill(METFilterMask.begin(), METFilterMask.end(), 0);
+
     for(std::size_t i = 0; i < METFilterL.size(); ++i){
-        METFilter[i] = METFilterL[i]->GetValue();
+        if(METFilterL[i]->GetValue()) METFilterMask[i/64] |= std::uint64_t(1) << i%64;
     }
 }
 
 void NanoInput::ReadEleEntry(){
-    if(elePtL->GetBranch()->GetReadEntry() == entry) return;
-
-    elePtL->GetBranch()->GetEntry(entry);
-    eleMassL->GetBranch()->GetEntry(entry);
-    elePhiL->GetBranch()->GetEntry(entry);
-    eleEtaL->GetBranch()->GetEntry(entry);
-    eleIso03L->GetBranch()->GetEntry(entry);
-    eleMiniIsoL->GetBranch()->GetEntry(entry);
-    eleChargeL->GetBranch()->GetEntry(entry);
-    eleDxyL->GetBranch()->GetEntry(entry);
-    eleDzL->GetBranch()->GetEntry(entry);
-    eleRelJetIsoL->GetBranch()->GetEntry(entry);
-    eleCutIDL->GetBranch()->GetEntry(entry);
-    eleMVAIDLooseL->GetBranch()->GetEntry(entry);
-    eleMVAIDMediumL->GetBranch()->GetEntry(entry);
-    eleMVAIDTightL->GetBranch()->GetEntry(entry);
-    eleConvVetoL->GetBranch()->GetEntry(entry);
+    if(elePtL->GetReadEntry() == entry) return;
+
+    Tracer::Span span(tracer, "ReadElectron", "input");
+
+    elePtL->GetEntry(entry);
+    eleMassL->GetEntry(entry);
+    elePhiL->GetEntry(entry);
+    eleEtaL->GetEntry(entry);
+    eleIso03L->GetEntry(entry);
+    eleMiniIsoL->GetEntry(entry);
+    eleChargeL->GetEntry(entry);
+    eleDxyL->GetEntry(entry);
+    eleDzL->GetEntry(entry);
+    eleRelJetIsoL->GetEntry(entry);
+    eleCutIDL->GetEntry(entry);
+    eleMVAIDLooseL->GetEntry(entry);
+    eleMVAIDMediumL->GetEntry(entry);
+    eleMVAIDTightL->GetEntry(entry);
+    eleConvVetoL->GetEntry(entry);
 
     if(eleScaleUpL){
-        eleScaleUpL->GetBranch()->GetEntry(entry);
-        eleScaleDownL->GetBranch()->GetEntry(entry);
-        eleSigmaUpL->GetBranch()->GetEntry(entry);
-        eleSigmaDownL->GetBranch()->GetEntry(entry);
+        eleScaleUpL->GetEntry(entry);
+        eleScaleDownL->GetEntry(entry);
+        eleSigmaUpL->GetEntry(entry);
+        eleSigmaDownL->GetEntry(entry);
     }
 
-    if(eleECorrL) eleECorrL->GetBranch()->GetEntry(entry);
+    if(eleECorrL) eleECorrL->GetEntry(entry);
 
     eleSize = elePtL->GetLen();
 }
@@ -269,25 +438,27 @@ void NanoInput::GetElectron(const std::size_t& idx){
 }
 
 void NanoInput::ReadMuEntry(){
-    if(muPtL->GetBranch()->GetReadEntry() == entry) return;
-
-    muRandomNumber = gRandom->Rndm();
-
-    muPtL->GetBranch()->GetEntry(entry);
-    muEtaL->GetBranch()->GetEntry(entry);
-    muPhiL->GetBranch()->GetEntry(entry);
-    muIso03L->GetBranch()->GetEntry(entry);
-    muIso04L->GetBranch()->GetEntry(entry);
-    muMiniIsoL->GetBranch()->GetEntry(entry);
-    muChargeL->GetBranch()->GetEntry(entry);
-    muDxyL->GetBranch()->GetEntry(entry);
-    muDzL->GetBranch()->GetEntry(entry);
-    muRelJetIsoL->GetBranch()->GetEntry(entry);
-    muCutIDLooseL->GetBranch()->GetEntry(entry);
-    muCutIDMediumL->GetBranch()->GetEntry(entry);
-    muCutIDTightL->GetBranch()->GetEntry(entry);
-    muMVAIDL->GetBranch()->GetEntry(entry);
-    muNTrackerLayersL->GetBranch()->GetEntry(entry);
+    if(muPtL->GetReadEntry() == entry) return;
+
+    Tracer::Span span(tracer, "ReadMuon", "input");
+
+    muRandomNumber = random.Rndm();
+
+    muPtL->GetEntry(entry);
+    muEtaL->GetEntry(entry);
+    muPhiL->GetEntry(entry);
+    muIso03L->GetEntry(entry);
+    muIso04L->GetEntry(entry);
+    muMiniIsoL->GetEntry(entry);
+    muChargeL->GetEntry(entry);
+    muDxyL->GetEntry(entry);
+    muDzL->GetEntry(entry);
+    muRelJetIsoL->GetEntry(entry);
+    muCutIDLooseL->GetEntry(entry);
+    muCutIDMediumL->GetEntry(entry);
+    muCutIDTightL->GetEntry(entry);
+    muMVAIDL->GetEntry(entry);
+    muNTrackerLayersL->GetEntry(entry);
 
     muSize = muPtL->GetLen();
 }
@@ -314,60 +485,62 @@ void NanoInput::GetMuon(const std::size_t& idx){
 }
 
 void NanoInput::ReadJetEntry(const bool& isData){
-    if(jetPtL->GetBranch()->GetReadEntry() == entry) return;
+    if(jetPtL->GetReadEntry() == entry) return;
 
-    rhoL->GetBranch()->GetEntry(entry);
+    Tracer::Span span(tracer, "ReadJet", "input");
+
+    rhoL->GetEntry(entry);
     rho = rhoL->GetValue();
 
-    metPhiL->GetBranch()->GetEntry(entry);
-    metPtL->GetBranch()->GetEntry(entry);
-    metDeltaUnClustXL->GetBranch()->GetEntry(entry);
-    metDeltaUnClustYL->GetBranch()->GetEntry(entry);
+    metPhiL->GetEntry(entry);
+    metPtL->GetEntry(entry);
+    metDeltaUnClustXL->GetEntry(entry);
+    metDeltaUnClustYL->GetEntry(entry);
     
     metPt = metPtL->GetValue();
     metPhi = metPhiL->GetValue();
     metDeltaUnClustX = metDeltaUnClustXL->GetValue();
     metDeltaUnClustY = metDeltaUnClustYL->GetValue();
 
-    jetPtL->GetBranch()->GetEntry(entry);
-    jetEtaL->GetBranch()->GetEntry(entry);
-    jetPhiL->GetBranch()->GetEntry(entry);
-    jetMassL->GetBranch()->GetEntry(entry);
-    jetAreaL->GetBranch()->GetEntry(entry);
-    jetDeepJetL->GetBranch()->GetEntry(entry);
-    jetDeepCSVL->GetBranch()->GetEntry(entry);
-    jetRawFacL->GetBranch()->GetEntry(entry);
-    jetIDL->GetBranch()->GetEntry(entry);
-    jetPUIDL->GetBranch()->GetEntry(entry);
-
-    fatJetPtL->GetBranch()->GetEntry(entry);
-    fatJetEtaL->GetBranch()->GetEntry(entry);
-    fatJetPhiL->GetBranch()->GetEntry(entry);
-    fatJetMassL->GetBranch()->GetEntry(entry);
-    fatJetAreaL->GetBranch()->GetEntry(entry);
-    fatJetTau1L->GetBranch()->GetEntry(entry);
-    fatJetTau2L->GetBranch()->GetEntry(entry);
-    fatJetTau3L->GetBranch()->GetEntry(entry);
-    fatJetDAK8HiggsL->GetBranch()->GetEntry(entry);
-    fatJetDAK8QCDL->GetBranch()->GetEntry(entry);
-    fatJetDAK8TvsQCDL->GetBranch()->GetEntry(entry);
-    fatJetDAK8ZvsQCDL->GetBranch()->GetEntry(entry);
-    fatJetDAK8WvsQCDL->GetBranch()->GetEntry(entry);
-    fatJetRawFacL->GetBranch()->GetEntry(entry);
+    jetPtL->GetEntry(entry);
+    jetEtaL->GetEntry(entry);
+    jetPhiL->GetEntry(entry);
+    jetMassL->GetEntry(entry);
+    jetAreaL->GetEntry(entry);
+    jetDeepJetL->GetEntry(entry);
+    jetDeepCSVL->GetEntry(entry);
+    jetRawFacL->GetEntry(entry);
+    jetIDL->GetEntry(entry);
+    jetPUIDL->GetEntry(entry);
+
+    fatJetPtL->GetEntry(entry);
+    fatJetEtaL->GetEntry(entry);
+    fatJetPhiL->GetEntry(entry);
+    fatJetMassL->GetEntry(entry);
+    fatJetAreaL->GetEntry(entry);
+    fatJetTau1L->GetEntry(entry);
+    fatJetTau2L->GetEntry(entry);
+    fatJetTau3L->GetEntry(entry);
+    fatJetDAK8HiggsL->GetEntry(entry);
+    fatJetDAK8QCDL->GetEntry(entry);
+    fatJetDAK8TvsQCDL->GetEntry(entry);
+    fatJetDAK8ZvsQCDL->GetEntry(entry);
+    fatJetDAK8WvsQCDL->GetEntry(entry);
+    fatJetRawFacL->GetEntry(entry);
 
     jetSize = jetPtL->GetLen();
     fatJetSize = fatJetPtL->GetLen();
 
     if(!isData){
-        jetPartFlavL->GetBranch()->GetEntry(entry);
+        jetPartFlavL->GetEntry(entry);
 
-        genJetPtL->GetBranch()->GetEntry(entry);
-        genJetEtaL->GetBranch()->GetEntry(entry);
-        genJetPhiL->GetBranch()->GetEntry(entry);
+        genJetPtL->GetEntry(entry);
+        genJetEtaL->GetEntry(entry);
+        genJetPhiL->GetEntry(entry);
 
-        genFatJetPtL->GetBranch()->GetEntry(entry);
-        genFatJetEtaL->GetBranch()->GetEntry(entry);
-        genFatJetPhiL->GetBranch()->GetEntry(entry);
+        genFatJetPtL->GetEntry(entry);
+        genFatJetEtaL->GetEntry(entry);
+        genFatJetPhiL->GetEntry(entry);
 
         genJetSize = genJetPtL->GetLen();
         genFatJetSize = genFatJetPtL->GetLen();
@@ -419,7 +592,7 @@ void NanoInput::GetFatJet(const std::size_t& idx){
 }
 
 void NanoInput::GetGenJet(const std::size_t& idx){
-    if(genJetPtL->GetBranch()->GetReadEntry() == entry) return;
+    if(genJetPtL->GetReadEntry() == entry) return;
 
     genJetPt = genJetPtL->GetValue(idx);
     genJetEta = genJetEtaL->GetValue(idx);
@@ -433,16 +606,18 @@ void NanoInput::GetGenFatJet(const std::size_t& idx){
 }
 
 void NanoInput::ReadIsotrkEntry(){
-    if(isotrkPtL->GetBranch()->GetReadEntry() == entry) return;
+    if(isotrkPtL->GetReadEntry() == entry) return;
+
+    Tracer::Span span(tracer, "ReadIsotrack", "input");
 
-    isotrkPtL->GetBranch()->GetEntry(entry);
-    isotrkEtaL->GetBranch()->GetEntry(entry);
-    isotrkPhiL->GetBranch()->GetEntry(entry);
-    isotrkIso03L->GetBranch()->GetEntry(entry);
-    isotrkDxyL->GetBranch()->GetEntry(entry);
-    isotrkDzL->GetBranch()->GetEntry(entry);
-    isotrkPDGL->GetBranch()->GetEntry(entry);
-    isotrkMiniIsoL->GetBranch()->GetEntry(entry);
+    isotrkPtL->GetEntry(entry);
+    isotrkEtaL->GetEntry(entry);
+    isotrkPhiL->GetEntry(entry);
+    isotrkIso03L->GetEntry(entry);
+    isotrkDxyL->GetEntry(entry);
+    isotrkDzL->GetEntry(entry);
+    isotrkPDGL->GetEntry(entry);
+    isotrkMiniIsoL->GetEntry(entry);
 
     isotrkSize = isotrkPtL->GetLen();
 }
@@ -459,26 +634,45 @@ void NanoInput::GetIsotrk(const std::size_t& idx){
 }
 
 void NanoInput::ReadMiscEntry(const bool& isData){
-    evNrL->GetBranch()->GetEntry(entry);
-    if(nPartonL != nullptr) nPartonL->GetBranch()->GetEntry(entry);
+    Tracer::Span span(tracer, "ReadMisc", "input");
+
+    evNrL->GetEntry(entry);
+    ReadRunEntry();
+    if(lumiNrL != nullptr) lumiNrL->GetEntry(entry);
+    if(nPartonL != nullptr) nPartonL->GetEntry(entry);
+    if(cacheEntryL != nullptr) cacheEntryL->GetEntry(entry);
+}
+
+//Run number is needed before the misc information (e.g. for the JEC run period)
+void NanoInput::ReadRunEntry(){
+    if(runNrL->GetReadEntry() == entry) return;
+
+    runNrL->GetEntry(entry);
+    runNr = runNrL->GetTypedValue<unsigned int>();
 }
 
 void NanoInput::GetMisc(){
-    evNr = evNrL->GetValue();
+    evNr = evNrL->GetTypedValue<unsigned long long>();
+    lumiNr = lumiNrL != nullptr ? lumiNrL->GetTypedValue<unsigned int>() : 0;
     if(nPartonL != nullptr) nParton = nPartonL->GetTypedValue<short>();
+
+    //Entries of the cache are a subset of the original entries if the pre-filter was used
+    inputEntry = cacheEntryL != nullptr ? cacheEntryL->GetTypedValue<unsigned long long>() : entry;
 }
 
 void NanoInput::ReadGenEntry(){
-    if(genPDGL->GetBranch()->GetReadEntry() == entry) return;
+    if(genPDGL->GetReadEntry() == entry) return;
+
+    Tracer::Span span(tracer, "ReadGenPart", "input");
 
     alreadyMatchedIdx.clear();
 
-    genPDGL->GetBranch()->GetEntry(entry);
-    genMotherIdxL->GetBranch()->GetEntry(entry);
-    genPtL->GetBranch()->GetEntry(entry);
-    genPhiL->GetBranch()->GetEntry(entry);
-    genEtaL->GetBranch()->GetEntry(entry);
-    genMassL->GetBranch()->GetEntry(entry);
+    genPDGL->GetEntry(entry);
+    genMotherIdxL->GetEntry(entry);
+    genPtL->GetEntry(entry);
+    genPhiL->GetEntry(entry);
+    genEtaL->GetEntry(entry);
+    genMassL->GetEntry(entry);
 
     genSize = genPtL->GetLen();
 }
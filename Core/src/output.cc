@@ -1,130 +1,376 @@
 #include <ChargedSkimming/Core/interface/output.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <TLeaf.h>
+#include <TList.h>
+#include <TObjString.h>
+
+void Output::ReadBranchSelection(const pt::ptree& skim, const std::vector<std::shared_ptr<TTree>>& trees){
+    selection = std::make_shared<BranchSelection>();
+
+    bool isVirtual = skim.get<bool>("Output.Virtual.Enabled", false);
+
+    for(const std::shared_ptr<TTree>& tree: trees){
+        std::string path = std::string("Channel.") + tree->GetName() + ".Branches";
+
+        //Only computed quantities, everything else is read from the original NanoAOD
+        if(isVirtual) selection->keep[tree->GetName()] = Util::GetVector<std::string>(skim, "Output.Virtual.keep");
+        else if(skim.get_child_optional(path + ".keep")) selection->keep[tree->GetName()] = Util::GetVector<std::string>(skim, path + ".keep");
+        if(skim.get_child_optional(path + ".drop")) selection->drop[tree->GetName()] = Util::GetVector<std::string>(skim, path + ".drop");
+    }
+}
+
+void Output::AddBranchSelection(const std::string& treeName, const std::vector<std::string>& keep, const std::vector<std::string>& drop){
+    if(!selection) selection = std::make_shared<BranchSelection>();
+
+    selection->keep[treeName] = keep;
+    selection->drop[treeName] = drop;
+}
+
+bool Output::IsKept(const std::string& treeName, const std::string& branchName) const {
+    if(!selection) return true;
+
+    //Counter branches of variable sized arrays are always needed
+    if(Util::MatchGlob("*_Size", branchName)) return true;
+
+    auto matches = [&](const std::map<std::string, std::vector<std::string>>& patterns){
+        if(!patterns.count(treeName)) return false;
+        const std::vector<std::string>& p = patterns.at(treeName);
+
+        return std::any_of(p.begin(), p.end(), [&](const std::string& pattern){return Util::MatchGlob(pattern, branchName);});
+    };
+
+    bool keep = !selection->keep.count(treeName) or matches(selection->keep);
+
+    return keep and !matches(selection->drop);
+}
+
+bool Output::IsWanted(const std::string& pattern) const {
+    if(!selection) return true;
+
+    return std::any_of(selection->booked.begin(), selection->booked.end(), [&](const std::string& name){return Util::MatchGlob(pattern, name);});
+}
+
+void Output::ReadEncoding(const pt::ptree& skim){
+    //Lossy encodings are opt-in, without configuration all branches are written with their full precision
+    if(!skim.get_child_optional("Output.Encoding") or skim.get_child("Output.Encoding").empty()) return;
+
+    encoding = std::make_shared<BranchEncoding>();
+
+    if(skim.get_child_optional("Output.Encoding.Float16")){
+        for(const std::pair<const std::string, pt::ptree>& f : skim.get_child("Output.Encoding.Float16")){
+            encoding->float16.push_back({Util::GetVector<std::string>(f.second, "branches"), f.second.get<float>("min", 0), f.second.get<float>("max", 0), f.second.get<int>("bits")});
+        }
+    }
+
+    if(skim.get_child_optional("Output.Encoding.Int8")) encoding->int8 = Util::GetVector<std::string>(skim, "Output.Encoding.Int8");
+
+    //Branch addresses point into the packed buffer, so it must never reallocate. Packed values are distinct short members
+    //of this class, one byte each, so the buffer can not need more bytes than the class has shorts
+    packed.reserve(sizeof(Output)/sizeof(short));
+}
+
+std::string Output::EncodeLeafList(const std::string& name, void*& address, const std::string& leafList){
+    std::string type = leafList.substr(leafList.rfind("/") + 1);
+
+    auto matches = [&](const std::vector<std::string>& patterns){
+        return std::any_of(patterns.begin(), patterns.end(), [&](const std::string& pattern){return Util::MatchGlob(pattern, name);});
+    };
+
+    //Float16_t, with range [min,max] or truncated mantissa if min == max == 0
+    if(type == "F"){
+        for(const BranchEncoding::Float16& f : encoding->float16){
+            if(!matches(f.patterns)) continue;
+
+            return leafList.substr(0, leafList.size() - 1) + "f[" + std::to_string(f.min) + "," + std::to_string(f.max) + "," + std::to_string(f.bits) + "]";
+        }
+    }
+
+    //8-bit integer, counters of variable sized arrays are kept as they are
+    if(type == "S" and matches(encoding->int8) and !Util::MatchGlob("*_Size", name)){
+        std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(this), pos = reinterpret_cast<std::uintptr_t>(address);
+        if(pos < begin or pos >= begin + sizeof(Output)) throw std::runtime_error("Int8 encoding only possible for fixed size members of the output: '" + name + "'");
+
+        //Maximum number of values from the leaf list, e.g. "Jet_ID[Jet_Size]/S"
+        std::map<std::string, std::pair<short*, std::size_t>> counters = Counters();
+        std::size_t size = 1;
+
+        if(leafList.find("[") != std::string::npos){
+            std::string dim = leafList.substr(leafList.find("[") + 1, leafList.find("]") - leafList.find("[") - 1);
+            size = counters.count(dim) ? counters.at(dim).second : std::stoul(dim);
+        }
+
+        std::vector<PackedShort>::iterator p = std::find_if(packedShorts.begin(), packedShorts.end(), [&](const PackedShort& p){return p.offset == pos - begin;});
+
+        //Same member booked for another tree shares the packed buffer
+        if(p == packedShorts.end()){
+            if(pos + size * sizeof(short) > begin + sizeof(Output) or packed.size() + size > packed.capacity()) throw std::runtime_error("Int8 encoded branch exceeds the output member: '" + name + "'");
+
+            packedShorts.push_back({pos - begin, size, packed.size()});
+            packed.resize(packed.size() + size);
+            p = packedShorts.end() - 1;
+        }
+
+        address = packed.data() + p->packedOffset;
+
+        return leafList.substr(0, leafList.size() - 1) + "B";
+    }
+
+    return leafList;
+}
+
+void Output::Encode(){
+    for(const PackedShort& p : packedShorts){
+        const short* values = reinterpret_cast<const short*>(reinterpret_cast<const char*>(this) + p.offset);
+
+        for(std::size_t i = 0; i < p.size; ++i){
+            packed[p.packedOffset + i] = std::clamp<short>(values[i], -128, 127);
+        }
+    }
+}
+
+std::map<std::string, std::pair<short*, std::size_t>> Output::Counters(){
+    return {
+        {"Electron_Size", {&nElectrons, eleMax}}, {"Muon_Size", {&nMuons, muMax}}, {"Jet_Size", {&nJets, jetMax}},
+        {"SubJet_Size", {&nSubJets, jetMax}}, {"FatJet_Size", {&nFatJets, fatJetMax}}, {"IsoTrack_Size", {&isotrkSize, isotrkMax}},
+    };
+}
+
+void Output::AddSlice(void* address, const std::string& leafList){
+    //Same member booked for another tree
+    if(std::any_of(slices.begin(), slices.end(), [&](const OutputSlice& s){return s.address == address;})) return;
+
+    static const std::map<char, std::size_t> sizes = {
+        {'F', 4}, {'f', 4}, {'I', 4}, {'i', 4}, {'S', 2}, {'s', 2}, {'l', 8}, {'L', 8}, {'D', 8}, {'B', 1}, {'b', 1}, {'O', 1},
+    };
+
+    char type = leafList.at(leafList.rfind("/") + 1);
+    if(!sizes.count(type)) throw std::runtime_error("Unknown type of output branch: '" + leafList + "'");
+
+    OutputSlice slice{static_cast<char*>(address), sizes.at(type), 1, nullptr};
+
+    if(leafList.find("[") != std::string::npos){
+        std::map<std::string, std::pair<short*, std::size_t>> counters = Counters();
+        std::string dim = leafList.substr(leafList.find("[") + 1, leafList.find("]") - leafList.find("[") - 1);
+
+        if(counters.count(dim)){
+            slice.counter = counters.at(dim).first;
+            slice.maxSize = counters.at(dim).second;
+        }
+
+        else slice.maxSize = std::stoul(dim);
+    }
+
+    slices.push_back(slice);
+}
+
+void Output::Pack(std::vector<char>& buffer) const {
+    buffer.clear();
+
+    //Fixed size members first, so the counters are known when the variable sized arrays are unpacked
+    for(const bool& variable : {false, true}){
+        for(const OutputSlice& s : slices){
+            if((s.counter != nullptr) != variable) continue;
+
+            std::size_t n = variable ? std::min<std::size_t>(std::max<short>(*s.counter, 0), s.maxSize) : s.maxSize;
+            buffer.insert(buffer.end(), s.address, s.address + n*s.elementSize);
+        }
+    }
+}
+
+void Output::Unpack(const std::vector<char>& buffer){
+    std::size_t pos = 0;
+
+    for(const bool& variable : {false, true}){
+        for(const OutputSlice& s : slices){
+            if((s.counter != nullptr) != variable) continue;
+
+            std::size_t n = variable ? std::min<std::size_t>(std::max<short>(*s.counter, 0), s.maxSize) : s.maxSize;
+            if(pos + n*s.elementSize > buffer.size()) throw std::runtime_error("Packed output does not match the booked branches");
+
+            std::memcpy(s.address, buffer.data() + pos, n*s.elementSize);
+            pos += n*s.elementSize;
+        }
+    }
+}
+
+void Output::ReadBranch(const std::string& name, void* address, const std::string& leafList){
+    TLeaf* leaf = inputTree->GetLeaf(name.c_str());
+    if(leaf == nullptr) return;
+
+    //Float16 is decoded by ROOT, Int8 encoded branches can not be read into the short members
+    static const std::map<std::string, std::vector<std::string>> types = {
+        {"F", {"Float_t", "Float16_t"}}, {"S", {"Short_t"}}, {"I", {"Int_t"}}, {"l", {"ULong64_t"}},
+    };
+
+    std::string type = leafList.substr(leafList.rfind("/") + 1, 1);
+
+    if(types.count(type) and std::find(types.at(type).begin(), types.at(type).end(), leaf->GetTypeName()) == types.at(type).end()){
+        std::cout << "Branch '" << name << "' is stored as '" << leaf->GetTypeName() << "' and can not be read back, it is not used!" << std::endl;
+        return;
+    }
+
+    inputTree->SetBranchAddress(name.c_str(), address);
+}
+
+void Output::Book(const std::shared_ptr<TTree>& tree, const std::string& name, void* address, const std::string& leafList){
+    if(!slicesOnly and inputTree and tree != inputTree) ReadBranch(name, address, leafList);
+    if(!IsKept(tree->GetName(), name)) return;
+
+    AddSlice(address, leafList);
+    if(selection) selection->booked.insert(name);
+    if(slicesOnly) return;
+
+    std::string leaf = encoding ? EncodeLeafList(name, address, leafList) : leafList;
+
+    tree->Branch(name.c_str(), address, leaf.c_str());
+}
 
 void Output::RegisterTrigger(const std::vector<std::string>& triggerNames, const std::vector<std::shared_ptr<TTree>>& trees){
-    triggers = std::vector<short>(triggerNames.size(), 1);
+    std::size_t nWords = std::max((triggerNames.size() + 63)/64, std::size_t(1));
+    triggerMask = std::vector<std::uint64_t>(nWords, 0);
 
-    for(std::size_t i = 0; i < triggerNames.size(); ++i){
-        for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch(triggerNames[i].c_str(), &triggers[i], (triggerNames[i] + "/S").c_str());
+    for(const std::shared_ptr<TTree>& tree: trees){
+        Book(tree, "Trigger_Mask", triggerMask.data(), "Trigger_Mask[" + std::to_string(nWords) + "]/l");
+        if(slicesOnly or !tree->GetBranch("Trigger_Mask")) continue;
+
+        //Name table (bit i = i-th entry) and an alias per path, e.g. HLT_IsoMu24 -> (Trigger_Mask[0]>>1)&1
+        TList* names = new TList();
+        names->SetName("Trigger_Mask");
+
+        for(std::size_t i = 0; i < triggerNames.size(); ++i){
+            names->Add(new TObjString(triggerNames[i].c_str()));
+            tree->SetAlias(triggerNames[i].c_str(), ("(Trigger_Mask[" + std::to_string(i/64) + "]>>" + std::to_string(i%64) + ")&1").c_str());
         }
+
+        tree->GetUserInfo()->Add(names);
     }
 }
 
 void Output::Register(const std::string& name, const std::vector<std::shared_ptr<TTree>>& trees, pt::ptree& skim, const bool& isData){
+    //Links to the original NanoAOD entry/objects are only needed by virtual skims
+    bool isVirtual = skim.get<bool>("Output.Virtual.Enabled", false);
+
     if(name == "Weight"){
         for(const std::shared_ptr<TTree>& tree: trees){
             if(!isData){
-                tree->Branch("Weight_nTrueInt", &nTrueInt, "Weight_nTrueInt/S");
-
-                tree->Branch("Weight_pdf", pdfWeight, "Weight_pdf[102]/F");
-                tree->Branch("Weight_scale", scaleWeight, "Weight_scale[8]/F");
+                Book(tree, "Weight_nTrueInt", &nTrueInt, "Weight_nTrueInt/S");
+                Book(tree, "Weight_pdf", pdfWeight, "Weight_pdf[102]/F");
+                Book(tree, "Weight_scale", scaleWeight, "Weight_scale[8]/F");
                 
-                tree->Branch("Weight_L1PreFire", &preFire, "Weight_L1PreFire/F");
-                tree->Branch("Weight_L1PreFireUp", &preFireUp, "Weight_L1PreFireUp/F");
-                tree->Branch("Weight_L1PreFireDown", &preFireDown, "Weight_L1PreFireDown/F");
+                Book(tree, "Weight_L1PreFire", &preFire, "Weight_L1PreFire/F");
+                Book(tree, "Weight_L1PreFireUp", &preFireUp, "Weight_L1PreFireUp/F");
+                Book(tree, "Weight_L1PreFireDown", &preFireDown, "Weight_L1PreFireDown/F");
             }
         }
     }
 
     if(name == "Electron"){
         for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch("Electron_Size", &nElectrons, "Electron_Size/S");
-
-            tree->Branch("Electron_Pt", elePt.data(), "Electron_Pt[Electron_Size]/F");
-            tree->Branch("Electron_Pt_eleEnergyScaleUp", elePtEnergyScaleUp.data(), "Electron_Pt_eleEnergyScaleUp[Electron_Size]/F");
-            tree->Branch("Electron_Pt_eleEnergyScaleDown", elePtEnergyScaleDown.data(), "Electron_Pt_eleEnergyScaleDown[Electron_Size]/F");
-            tree->Branch("Electron_Pt_eleEnergySigmaUp", elePtEnergySigmaUp.data(), "Electron_Pt_eleEnergySigmaUp[Electron_Size]/F");
-            tree->Branch("Electron_Pt_eleEnergySigmaDown", elePtEnergySigmaDown.data(), "Electron_Pt_eleEnergySigmaDown[Electron_Size]/F");
-            tree->Branch("Electron_Eta", eleEta.data(), "Electron_Eta[Electron_Size]/F");
-            tree->Branch("Electron_Phi", elePhi.data(), "Electron_Phi[Electron_Size]/F");
-            tree->Branch("Electron_Isolation03", eleIso03.data(), "Electron_Isolation03[Electron_Size]/F");
-            tree->Branch("Electron_MiniIsolation", eleMiniIso.data(), "Electron_MiniIsolation[Electron_Size]/F");
-            tree->Branch("Electron_Dxy", eleDxy.data(), "Electron_Dxy[Electron_Size]/F");
-            tree->Branch("Electron_Dz", eleDz.data(), "Electron_Dz[Electron_Size]/F");
-            tree->Branch("Electron_JetRelIsolation", eleRelJetIso.data(), "Electron_JetRelIsolation[Electron_Size]/F");
-
-            tree->Branch("Electron_Charge", eleCharge.data(), "Electron_Charge[Electron_Size]/S");
-            tree->Branch("Electron_CutID", eleCutID.data(), "Electron_CutID[Electron_Size]/S");
-            tree->Branch("Electron_MVAID", eleMVAID.data(), "Electron_MVAID[Electron_Size]/S");
+            Book(tree, "Electron_Size", &nElectrons, "Electron_Size/S");
+
+            Book(tree, "Electron_Pt", elePt.data(), "Electron_Pt[Electron_Size]/F");
+            Book(tree, "Electron_Pt_eleEnergyScaleUp", elePtEnergyScaleUp.data(), "Electron_Pt_eleEnergyScaleUp[Electron_Size]/F");
+            Book(tree, "Electron_Pt_eleEnergyScaleDown", elePtEnergyScaleDown.data(), "Electron_Pt_eleEnergyScaleDown[Electron_Size]/F");
+            Book(tree, "Electron_Pt_eleEnergySigmaUp", elePtEnergySigmaUp.data(), "Electron_Pt_eleEnergySigmaUp[Electron_Size]/F");
+            Book(tree, "Electron_Pt_eleEnergySigmaDown", elePtEnergySigmaDown.data(), "Electron_Pt_eleEnergySigmaDown[Electron_Size]/F");
+            Book(tree, "Electron_Eta", eleEta.data(), "Electron_Eta[Electron_Size]/F");
+            Book(tree, "Electron_Phi", elePhi.data(), "Electron_Phi[Electron_Size]/F");
+            Book(tree, "Electron_Isolation03", eleIso03.data(), "Electron_Isolation03[Electron_Size]/F");
+            Book(tree, "Electron_MiniIsolation", eleMiniIso.data(), "Electron_MiniIsolation[Electron_Size]/F");
+            Book(tree, "Electron_Dxy", eleDxy.data(), "Electron_Dxy[Electron_Size]/F");
+            Book(tree, "Electron_Dz", eleDz.data(), "Electron_Dz[Electron_Size]/F");
+            Book(tree, "Electron_JetRelIsolation", eleRelJetIso.data(), "Electron_JetRelIsolation[Electron_Size]/F");
+
+            Book(tree, "Electron_Charge", eleCharge.data(), "Electron_Charge[Electron_Size]/S");
+            Book(tree, "Electron_CutID", eleCutID.data(), "Electron_CutID[Electron_Size]/S");
+            Book(tree, "Electron_MVAID", eleMVAID.data(), "Electron_MVAID[Electron_Size]/S");
+            if(isVirtual) Book(tree, "Electron_InputIdx", eleInputIdx.data(), "Electron_InputIdx[Electron_Size]/S");
 
             if(!isData){
-                tree->Branch("Electron_GenPt", eleGenPt.data(), "Electron_GenPt[Electron_Size]/F");
-                tree->Branch("Electron_GenEta", eleGenEta.data(), "Electron_GenEta[Electron_Size]/F");
-                tree->Branch("Electron_GenPhi", eleGenPhi.data(), "Electron_GenPhi[Electron_Size]/F");
-                tree->Branch("Electron_GenID", eleGenID.data(), "Electron_GenID[Electron_Size]/S");
-                tree->Branch("Electron_GenMotherID", eleGenMotherID.data(), "Electron_GenMotherID[Electron_Size]/S");
-                tree->Branch("Electron_GenGrandMotherID", eleGenGrandMotherID.data(), "Electron_GenGrandMotherID[Electron_Size]/S");
-
-                tree->Branch("Electron_RecoSF", eleRecoSF.data(), "Electron_RecoSF[Electron_Size]/F");
-                tree->Branch("Electron_looseSF", eleLooseSF.data(), "Electron_looseSF[Electron_Size]/F");
-                tree->Branch("Electron_mediumSF", eleMediumSF.data(), "Electron_mediumSF[Electron_Size]/F");
-                tree->Branch("Electron_tightSF", eleTightSF.data(), "Electron_tightSF[Electron_Size]/F");
-                tree->Branch("Electron_mediumMVASF", eleMediumMVASF.data(), "Electron_mediumMVASF[Electron_Size]/F");
-                tree->Branch("Electron_tightMVASF", eleTightMVASF.data(), "Electron_tightMVASF[Electron_Size]/F");
-
-                tree->Branch("Electron_RecoSFUp", eleRecoSFUp.data(), "Electron_RecoSFUp[Electron_Size]/F");
-                tree->Branch("Electron_looseSFUp", eleLooseSFUp.data(), "Electron_looseSFUp[Electron_Size]/F");
-                tree->Branch("Electron_mediumSFUp", eleMediumSFUp.data(), "Electron_mediumSFUp[Electron_Size]/F");
-                tree->Branch("Electron_tightSFUp", eleTightSFUp.data(), "Electron_tightSFUp[Electron_Size]/F");
-                tree->Branch("Electron_mediumMVASFUp", eleMediumMVASFUp.data(), "Electron_mediumMVASFUp[Electron_Size]/F");
-                tree->Branch("Electron_tightMVASFUp", eleTightMVASFUp.data(), "Electron_tightMVASFUp[Electron_Size]/F");
-                tree->Branch("Electron_RecoSFDown", eleRecoSFDown.data(), "Electron_RecoSFDown[Electron_Size]/F");
-                tree->Branch("Electron_looseSFDown", eleLooseSFDown.data(), "Electron_looseSFDown[Electron_Size]/F");
-                tree->Branch("Electron_mediumSFDown", eleMediumSFDown.data(), "Electron_mediumSFDown[Electron_Size]/F");
-                tree->Branch("Electron_tightSFDown", eleTightSFDown.data(), "Electron_tightSFDown[Electron_Size]/F");
-                tree->Branch("Electron_mediumMVASFDown", eleMediumMVASFDown.data(), "Electron_mediumMVASFDown[Electron_Size]/F");
-                tree->Branch("Electron_tightMVASFDown", eleTightMVASFDown.data(), "Electron_tightMVASFDown[Electron_Size]/F");
+                Book(tree, "Electron_GenPt", eleGenPt.data(), "Electron_GenPt[Electron_Size]/F");
+                Book(tree, "Electron_GenEta", eleGenEta.data(), "Electron_GenEta[Electron_Size]/F");
+                Book(tree, "Electron_GenPhi", eleGenPhi.data(), "Electron_GenPhi[Electron_Size]/F");
+                Book(tree, "Electron_GenID", eleGenID.data(), "Electron_GenID[Electron_Size]/S");
+                Book(tree, "Electron_GenMotherID", eleGenMotherID.data(), "Electron_GenMotherID[Electron_Size]/S");
+                Book(tree, "Electron_GenGrandMotherID", eleGenGrandMotherID.data(), "Electron_GenGrandMotherID[Electron_Size]/S");
+
+                Book(tree, "Electron_RecoSF", eleRecoSF.data(), "Electron_RecoSF[Electron_Size]/F");
+                Book(tree, "Electron_looseSF", eleLooseSF.data(), "Electron_looseSF[Electron_Size]/F");
+                Book(tree, "Electron_mediumSF", eleMediumSF.data(), "Electron_mediumSF[Electron_Size]/F");
+                Book(tree, "Electron_tightSF", eleTightSF.data(), "Electron_tightSF[Electron_Size]/F");
+                Book(tree, "Electron_mediumMVASF", eleMediumMVASF.data(), "Electron_mediumMVASF[Electron_Size]/F");
+                Book(tree, "Electron_tightMVASF", eleTightMVASF.data(), "Electron_tightMVASF[Electron_Size]/F");
+
+                Book(tree, "Electron_RecoSFUp", eleRecoSFUp.data(), "Electron_RecoSFUp[Electron_Size]/F");
+                Book(tree, "Electron_looseSFUp", eleLooseSFUp.data(), "Electron_looseSFUp[Electron_Size]/F");
+                Book(tree, "Electron_mediumSFUp", eleMediumSFUp.data(), "Electron_mediumSFUp[Electron_Size]/F");
+                Book(tree, "Electron_tightSFUp", eleTightSFUp.data(), "Electron_tightSFUp[Electron_Size]/F");
+                Book(tree, "Electron_mediumMVASFUp", eleMediumMVASFUp.data(), "Electron_mediumMVASFUp[Electron_Size]/F");
+                Book(tree, "Electron_tightMVASFUp", eleTightMVASFUp.data(), "Electron_tightMVASFUp[Electron_Size]/F");
+                Book(tree, "Electron_RecoSFDown", eleRecoSFDown.data(), "Electron_RecoSFDown[Electron_Size]/F");
+                Book(tree, "Electron_looseSFDown", eleLooseSFDown.data(), "Electron_looseSFDown[Electron_Size]/F");
+                Book(tree, "Electron_mediumSFDown", eleMediumSFDown.data(), "Electron_mediumSFDown[Electron_Size]/F");
+                Book(tree, "Electron_tightSFDown", eleTightSFDown.data(), "Electron_tightSFDown[Electron_Size]/F");
+                Book(tree, "Electron_mediumMVASFDown", eleMediumMVASFDown.data(), "Electron_mediumMVASFDown[Electron_Size]/F");
+                Book(tree, "Electron_tightMVASFDown", eleTightMVASFDown.data(), "Electron_tightMVASFDown[Electron_Size]/F");
             }
         }
     }
 
     if(name == "Muon"){
         for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch("Muon_Size", &nMuons, "Muon_Size/S");
-
-            tree->Branch("Muon_Pt", muPt.data(), "Muon_Pt[Muon_Size]/F");
-            tree->Branch("Muon_Pt_muMomentumScaleUp", muPtUp.data(), "Muon_Pt_muMomentumScaleUp[Muon_Size]/F");
-            tree->Branch("Muon_Pt_muMomentumScaleDown", muPtDown.data(), "Muon_Pt_muMomentumScaleDown[Muon_Size]/F");
-            tree->Branch("Muon_Eta", muEta.data(), "Muon_Eta[Muon_Size]/F");
-            tree->Branch("Muon_Phi", muPhi.data(), "Muon_Phi[Muon_Size]/F");
-            tree->Branch("Muon_Isolation03", muIso03.data(), "Muon_Isolation03[Muon_Size]/F");
-            tree->Branch("Muon_Isolation04", muIso04.data(), "Muon_Isolation04[Muon_Size]/F");
-            tree->Branch("Muon_MiniIsolation", muMiniIso.data(), "Muon_MiniIsolation[Muon_Size]/F");
-            tree->Branch("Muon_Dxy", muDxy.data(), "Muon_Dxy[Muon_Size]/F");
-            tree->Branch("Muon_Dz", muDz.data(), "Muon_Dz[Muon_Size]/F");
-            tree->Branch("Muon_JetRelIsolation", muRelJetIso.data(), "Muon_JetRelIsolation[Muon_Size]/F");
-
-            tree->Branch("Muon_Charge", muCharge.data(), "Muon_Charge[Muon_Size]/S");
-            tree->Branch("Muon_CutID", muCutID.data(), "Muon_CutID[Muon_Size]/S");
-            tree->Branch("Muon_MVAID", muMVAID.data(), "Muon_MVAID[Muon_Size]/S");
+            Book(tree, "Muon_Size", &nMuons, "Muon_Size/S");
+
+            Book(tree, "Muon_Pt", muPt.data(), "Muon_Pt[Muon_Size]/F");
+            Book(tree, "Muon_Pt_muMomentumScaleUp", muPtUp.data(), "Muon_Pt_muMomentumScaleUp[Muon_Size]/F");
+            Book(tree, "Muon_Pt_muMomentumScaleDown", muPtDown.data(), "Muon_Pt_muMomentumScaleDown[Muon_Size]/F");
+            Book(tree, "Muon_Eta", muEta.data(), "Muon_Eta[Muon_Size]/F");
+            Book(tree, "Muon_Phi", muPhi.data(), "Muon_Phi[Muon_Size]/F");
+            Book(tree, "Muon_Isolation03", muIso03.data(), "Muon_Isolation03[Muon_Size]/F");
+            Book(tree, "Muon_Isolation04", muIso04.data(), "Muon_Isolation04[Muon_Size]/F");
+            Book(tree, "Muon_MiniIsolation", muMiniIso.data(), "Muon_MiniIsolation[Muon_Size]/F");
+            Book(tree, "Muon_Dxy", muDxy.data(), "Muon_Dxy[Muon_Size]/F");
+            Book(tree, "Muon_Dz", muDz.data(), "Muon_Dz[Muon_Size]/F");
+            Book(tree, "Muon_JetRelIsolation", muRelJetIso.data(), "Muon_JetRelIsolation[Muon_Size]/F");
+
+            Book(tree, "Muon_Charge", muCharge.data(), "Muon_Charge[Muon_Size]/S");
+            Book(tree, "Muon_CutID", muCutID.data(), "Muon_CutID[Muon_Size]/S");
+            Book(tree, "Muon_MVAID", muMVAID.data(), "Muon_MVAID[Muon_Size]/S");
+            if(isVirtual) Book(tree, "Muon_InputIdx", muInputIdx.data(), "Muon_InputIdx[Muon_Size]/S");
 
             if(!isData){
-                tree->Branch("Muon_GenPt", muGenPt.data(), "Muon_GenPt[Muon_Size]/F");
-                tree->Branch("Muon_GenEta", muGenEta.data(), "Muon_GenEta[Muon_Size]/F");
-                tree->Branch("Muon_GenPhi", muGenPhi.data(), "Muon_GenPhi[Muon_Size]/F");
-                tree->Branch("Muon_GenID", muGenID.data(), "Muon_GenID[Muon_Size]/S");
-                tree->Branch("Muon_GenMotherID", muGenMotherID.data(), "Muon_GenMotherID[Muon_Size]/S");
-                tree->Branch("Muon_GenGrandMotherID", muGenGrandMotherID.data(), "Muon_GenGrandMotherID[Muon_Size]/S");
-
-                tree->Branch("Muon_TriggerSF", muTriggerSF.data(), "Muon_TriggerSF[Muon_Size]/F");
-                tree->Branch("Muon_looseIsoSF", muLooseIsoSF.data(), "Muon_looseIsoSF[Muon_Size]/F");
-                tree->Branch("Muon_tightIsoSF", muTightIsoSF.data(), "Muon_tightIsoSF[Muon_Size]/F");
-                tree->Branch("Muon_looseSF", muLooseSF.data(), "Muon_looseSF[Muon_Size]/F");
-                tree->Branch("Muon_mediumSF", muMediumSF.data(), "Muon_mediumSF[Muon_Size]/F");
-                tree->Branch("Muon_tightSF", muTightSF.data(), "Muon_tightSF[Muon_Size]/F");
-
-                tree->Branch("Muon_TriggerSFUp", muTriggerSFUp.data(), "Muon_TriggerSFUp[Muon_Size]/F");
-                tree->Branch("Muon_looseIsoSFUp", muLooseIsoSFUp.data(), "Muon_looseIsoSFUp[Muon_Size]/F");
-                tree->Branch("Muon_tightIsoSFUp", muTightIsoSFUp.data(), "Muon_tightIsoSFUp[Muon_Size]/F");
-                tree->Branch("Muon_looseSFUp", muLooseSFUp.data(), "Muon_looseSFUp[Muon_Size]/F");
-                tree->Branch("Muon_mediumSFUp", muMediumSFUp.data(), "Muon_mediumSFUp[Muon_Size]/F");
-                tree->Branch("Muon_tightSFUp", muTightSFUp.data(), "Muon_tightSFUp[Muon_Size]/F");
-                tree->Branch("Muon_TriggerSFDown", muTriggerSFDown.data(), "Muon_TriggerSFDown[Muon_Size]/F");
-                tree->Branch("Muon_looseIsoSFDown", muLooseIsoSFDown.data(), "Muon_looseIsoSFDown[Muon_Size]/F");
-                tree->Branch("Muon_tightIsoSFDown", muTightIsoSFDown.data(), "Muon_tightIsoSFDown[Muon_Size]/F");
-                tree->Branch("Muon_looseSFDown", muLooseSFDown.data(), "Muon_looseSFDown[Muon_Size]/F");
-                tree->Branch("Muon_mediumSFDown", muMediumSFDown.data(), "Muon_mediumSFDown[Muon_Size]/F");
-                tree->Branch("Muon_tightSFDown", muTightSFDown.data(), "Muon_tightSFDown[Muon_Size]/F");
+                Book(tree, "Muon_GenPt", muGenPt.data(), "Muon_GenPt[Muon_Size]/F");
+                Book(tree, "Muon_GenEta", muGenEta.data(), "Muon_GenEta[Muon_Size]/F");
+                Book(tree, "Muon_GenPhi", muGenPhi.data(), "Muon_GenPhi[Muon_Size]/F");
+                Book(tree, "Muon_GenID", muGenID.data(), "Muon_GenID[Muon_Size]/S");
+                Book(tree, "Muon_GenMotherID", muGenMotherID.data(), "Muon_GenMotherID[Muon_Size]/S");
+                Book(tree, "Muon_GenGrandMotherID", muGenGrandMotherID.data(), "Muon_GenGrandMotherID[Muon_Size]/S");
+
+                Book(tree, "Muon_TriggerSF", muTriggerSF.data(), "Muon_TriggerSF[Muon_Size]/F");
+                Book(tree, "Muon_looseIsoSF", muLooseIsoSF.data(), "Muon_looseIsoSF[Muon_Size]/F");
+                Book(tree, "Muon_tightIsoSF", muTightIsoSF.data(), "Muon_tightIsoSF[Muon_Size]/F");
+                Book(tree, "Muon_looseSF", muLooseSF.data(), "Muon_looseSF[Muon_Size]/F");
+                Book(tree, "Muon_mediumSF", muMediumSF.data(), "Muon_mediumSF[Muon_Size]/F");
+                Book(tree, "Muon_tightSF", muTightSF.data(), "Muon_tightSF[Muon_Size]/F");
+
+                Book(tree, "Muon_TriggerSFUp", muTriggerSFUp.data(), "Muon_TriggerSFUp[Muon_Size]/F");
+                Book(tree, "Muon_looseIsoSFUp", muLooseIsoSFUp.data(), "Muon_looseIsoSFUp[Muon_Size]/F");
+                Book(tree, "Muon_tightIsoSFUp", muTightIsoSFUp.data(), "Muon_tightIsoSFUp[Muon_Size]/F");
+                Book(tree, "Muon_looseSFUp", muLooseSFUp.data(), "Muon_looseSFUp[Muon_Size]/F");
+                Book(tree, "Muon_mediumSFUp", muMediumSFUp.data(), "Muon_mediumSFUp[Muon_Size]/F");
+                Book(tree, "Muon_tightSFUp", muTightSFUp.data(), "Muon_tightSFUp[Muon_Size]/F");
+                Book(tree, "Muon_TriggerSFDown", muTriggerSFDown.data(), "Muon_TriggerSFDown[Muon_Size]/F");
+                Book(tree, "Muon_looseIsoSFDown", muLooseIsoSFDown.data(), "Muon_looseIsoSFDown[Muon_Size]/F");
+                Book(tree, "Muon_tightIsoSFDown", muTightIsoSFDown.data(), "Muon_tightIsoSFDown[Muon_Size]/F");
+                Book(tree, "Muon_looseSFDown", muLooseSFDown.data(), "Muon_looseSFDown[Muon_Size]/F");
+                Book(tree, "Muon_mediumSFDown", muMediumSFDown.data(), "Muon_mediumSFDown[Muon_Size]/F");
+                Book(tree, "Muon_tightSFDown", muTightSFDown.data(), "Muon_tightSFDown[Muon_Size]/F");
             }
         }
     }
@@ -211,69 +457,72 @@ void Output::Register(const std::string& name, const std::vector<std::shared_ptr
         }
 
         for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch("Jet_Size", &nJets, "Jet_Size/S");
-            tree->Branch("SubJet_Size", &nSubJets, "SubJet_Size/S");
-            tree->Branch("FatJet_Size", &nFatJets, "FatJet_Size/S");
-
-            tree->Branch("MET_Pt", &metPt, "MET_Pt/F");
-            tree->Branch("MET_Pt_JMEUp", &metPtJMEUp,"MET_Pt_JMEUp/F");
-            tree->Branch("MET_Pt_JMEDown", &metPtJMEDown, "MET_Pt_JMEDown/F");
-            tree->Branch("MET_Pt_UnclusteredUp", &metPtUnclusteredUp, "MET_Pt_UnclusteredUp/F");
-            tree->Branch("MET_Pt_UnclusteredDown", &metPtUnclusteredDown, "MET_Pt_UnclusteredDown/F");
-            tree->Branch("MET_Phi", &metPhi, "MET_Phi/F");
-            tree->Branch("MET_Phi_JMEUp", &metPhiJMEUp, "MET_Phi_JMEUp/F");
-            tree->Branch("MET_Phi_JMEDown", &metPhiJMEDown, "MET_Phi_JMEDown/F");
-            tree->Branch("MET_Phi_UnclusteredUp", &metPhiUnclusteredUp, "MET_Phi_UnclusteredUp/F");
-            tree->Branch("MET_Phi_UnclusteredDown", &metPhiUnclusteredDown, "MET_Phi_UnclusteredDown/F");
-
-            tree->Branch("Jet_Pt", jetPt.data(), "Jet_Pt[Jet_Size]/F");
-            tree->Branch("Jet_Pt_JMEUp", jetPtJMEUp.data(), "Jet_Pt_JMEUp[Jet_Size]/F");
-            tree->Branch("Jet_Pt_JMEDown", jetPtJMEDown.data(), "Jet_Pt_JMEDown[Jet_Size]/F");
-            tree->Branch("Jet_Eta", jetEta.data(), "Jet_Eta[Jet_Size]/F");
-            tree->Branch("Jet_Phi", jetPhi.data(), "Jet_Phi[Jet_Size]/F");
-            tree->Branch("Jet_Mass", jetMass.data(), "Jet_Mass[Jet_Size]/F");
-            tree->Branch("Jet_Mass_JMEUp", jetMassJMEUp.data(), "Jet_Mass_JMEUp[Jet_Size]/F");
-            tree->Branch("Jet_Mass_JMEDown", jetMassJMEDown.data(), "Jet_Mass_JMEDown[Jet_Size]/F");
-            tree->Branch("Jet_DeepJet", jetDeepJet.data(), "Jet_DeepJet[Jet_Size]/F");
-            tree->Branch("Jet_DeepCSV", jetDeepCSV.data(), "Jet_DeepCSV[Jet_Size]/F");
-            tree->Branch("Jet_DeepJetID", jetDeepJetID.data(), "Jet_DeepJetID[Jet_Size]/S");
-            tree->Branch("Jet_DeepCSVID", jetDeepCSVID.data(), "Jet_DeepCSVID[Jet_Size]/S");
-            tree->Branch("Jet_JECFac", jetJEC.data(), "Jet_JECFac[Jet_Size]/F");
-            tree->Branch("Jet_JMEFac", jetJME.data(), "Jet_JMEFac[Jet_Size]/F");
-            tree->Branch("Jet_ID", jetID.data(), "Jet_ID[Jet_Size]/S");
-            tree->Branch("Jet_PUID", jetPUID.data(), "Jet_PUID[Jet_Size]/S");
-
-            tree->Branch("SubJet_Pt", subJetPt.data(), "SubJet_Pt[SubJet_Size]/F");
-            tree->Branch("SubJet_Pt_JMEUp", subJetPtJMEUp.data(), "SubJet_Pt_JMEUp[SubJet_Size]/F");
-            tree->Branch("SubJet_Pt_JMEDown", subJetPtJMEDown.data(), "SubJet_Pt_JMEDown[SubJet_Size]/F");
-            tree->Branch("SubJet_Eta", subJetEta.data(), "SubJet_Eta[SubJet_Size]/F");
-            tree->Branch("SubJet_Phi", subJetPhi.data(), "SubJet_Phi[SubJet_Size]/F");
-            tree->Branch("SubJet_Mass", subJetMass.data(), "SubJet_Mass[SubJet_Size]/F");
-            tree->Branch("SubJet_Mass_JMEUp", subJetMassJMEUp.data(), "SubJet_Mass_JMEUp[SubJet_Size]/F");
-            tree->Branch("SubJet_Mass_JMEDown", subJetMassJMEDown.data(), "SubJet_Mass_JMEDown[SubJet_Size]/F");
-            tree->Branch("SubJet_DeepJet", subJetDeepJet.data(), "SubJet_DeepJet[SubJet_Size]/F");
-            tree->Branch("SubJet_DeepCSV", subJetDeepCSV.data(), "SubJet_DeepCSV[SubJet_Size]/F");
-            tree->Branch("SubJet_DeepJetID", subJetDeepJetID.data(), "SubJet_DeepJetID[SubJet_Size]/S");
-            tree->Branch("SubJet_DeepCSVID", subJetDeepCSVID.data(), "SubJet_DeepCSVID[SubJet_Size]/S");
-            tree->Branch("SubJet_PartonFlavour", subJetPartFlav.data(), "SubJet_PartonFlavour[SubJet_Size]/S");
-            tree->Branch("SubJet_JECFac", subJetJEC.data(), "SubJet_JECFac[SubJet_Size]/F");
-            tree->Branch("SubJet_JMEFac", subJetJME.data(), "SubJet_JMEFac[SubJet_Size]/F");
-            tree->Branch("SubJet_FatJetIdx", fatJetIdx.data(), "SubJet_FatJetIdx[SubJet_Size]/S");
-
-            tree->Branch("FatJet_Pt", fatJetPt.data(), "FatJet_Pt[FatJet_Size]/F");
-            tree->Branch("FatJet_Pt_JMEUp", fatJetPtJMEUp.data(), "FatJet_Pt_JMEUp[FatJet_Size]/F");
-            tree->Branch("FatJet_Pt_JMEDown", fatJetPtJMEDown.data(), "FatJet_Pt_JMEDown[FatJet_Size]/F");
-            tree->Branch("FatJet_Eta", fatJetEta.data(), "FatJet_Eta[FatJet_Size]/F");
-            tree->Branch("FatJet_Phi", fatJetPhi.data(), "FatJet_Phi[FatJet_Size]/F");
-            tree->Branch("FatJet_Mass", fatJetMass.data(), "FatJet_Mass[FatJet_Size]/F");
-            tree->Branch("FatJet_Mass_JMEUp", fatJetMassJMEUp.data(), "FatJet_Mass_JMEUp[FatJet_Size]/F");
-            tree->Branch("FatJet_Mass_JMEDown", fatJetMassJMEDown.data(), "FatJet_Mass_JMEDown[FatJet_Size]/F");
-            tree->Branch("FatJet_Tau1", fatJetTau1.data(), "FatJet_Tau1[FatJet_Size]/F");
-            tree->Branch("FatJet_Tau2", fatJetTau2.data(), "FatJet_Tau2[FatJet_Size]/F");
-            tree->Branch("FatJet_Tau3", fatJetTau3.data(), "FatJet_Tau3[FatJet_Size]/F");
-            tree->Branch("FatJet_DeepAK8ID",fatJetDAK8ID.data(), "FatJet_DeepAK8ID[FatJet_Size]/S");
-            tree->Branch("FatJet_JECFac", fatJetJEC.data(), "FatJet_JECFac[FatJet_Size]/F");
-            tree->Branch("FatJet_JMEFac", fatJetJME.data(), "FatJet_JMEFac[FatJet_Size]/F");
+            Book(tree, "Jet_Size", &nJets, "Jet_Size/S");
+            Book(tree, "SubJet_Size", &nSubJets, "SubJet_Size/S");
+            Book(tree, "FatJet_Size", &nFatJets, "FatJet_Size/S");
+
+            Book(tree, "MET_Pt", &metPt, "MET_Pt/F");
+            Book(tree, "MET_Pt_JMEUp", &metPtJMEUp,"MET_Pt_JMEUp/F");
+            Book(tree, "MET_Pt_JMEDown", &metPtJMEDown, "MET_Pt_JMEDown/F");
+            Book(tree, "MET_Pt_UnclusteredUp", &metPtUnclusteredUp, "MET_Pt_UnclusteredUp/F");
+            Book(tree, "MET_Pt_UnclusteredDown", &metPtUnclusteredDown, "MET_Pt_UnclusteredDown/F");
+            Book(tree, "MET_Phi", &metPhi, "MET_Phi/F");
+            Book(tree, "MET_Phi_JMEUp", &metPhiJMEUp, "MET_Phi_JMEUp/F");
+            Book(tree, "MET_Phi_JMEDown", &metPhiJMEDown, "MET_Phi_JMEDown/F");
+            Book(tree, "MET_Phi_UnclusteredUp", &metPhiUnclusteredUp, "MET_Phi_UnclusteredUp/F");
+            Book(tree, "MET_Phi_UnclusteredDown", &metPhiUnclusteredDown, "MET_Phi_UnclusteredDown/F");
+
+            Book(tree, "Jet_Pt", jetPt.data(), "Jet_Pt[Jet_Size]/F");
+            Book(tree, "Jet_Pt_JMEUp", jetPtJMEUp.data(), "Jet_Pt_JMEUp[Jet_Size]/F");
+            Book(tree, "Jet_Pt_JMEDown", jetPtJMEDown.data(), "Jet_Pt_JMEDown[Jet_Size]/F");
+            Book(tree, "Jet_Eta", jetEta.data(), "Jet_Eta[Jet_Size]/F");
+            Book(tree, "Jet_Phi", jetPhi.data(), "Jet_Phi[Jet_Size]/F");
+            Book(tree, "Jet_Mass", jetMass.data(), "Jet_Mass[Jet_Size]/F");
+            Book(tree, "Jet_Mass_JMEUp", jetMassJMEUp.data(), "Jet_Mass_JMEUp[Jet_Size]/F");
+            Book(tree, "Jet_Mass_JMEDown", jetMassJMEDown.data(), "Jet_Mass_JMEDown[Jet_Size]/F");
+            Book(tree, "Jet_DeepJet", jetDeepJet.data(), "Jet_DeepJet[Jet_Size]/F");
+            Book(tree, "Jet_DeepCSV", jetDeepCSV.data(), "Jet_DeepCSV[Jet_Size]/F");
+            Book(tree, "Jet_DeepJetID", jetDeepJetID.data(), "Jet_DeepJetID[Jet_Size]/S");
+            Book(tree, "Jet_DeepCSVID", jetDeepCSVID.data(), "Jet_DeepCSVID[Jet_Size]/S");
+            Book(tree, "Jet_JECFac", jetJEC.data(), "Jet_JECFac[Jet_Size]/F");
+            Book(tree, "Jet_JMEFac", jetJME.data(), "Jet_JMEFac[Jet_Size]/F");
+            Book(tree, "Jet_ID", jetID.data(), "Jet_ID[Jet_Size]/S");
+            Book(tree, "Jet_PUID", jetPUID.data(), "Jet_PUID[Jet_Size]/S");
+            if(isVirtual) Book(tree, "Jet_InputIdx", jetInputIdx.data(), "Jet_InputIdx[Jet_Size]/S");
+
+            Book(tree, "SubJet_Pt", subJetPt.data(), "SubJet_Pt[SubJet_Size]/F");
+            Book(tree, "SubJet_Pt_JMEUp", subJetPtJMEUp.data(), "SubJet_Pt_JMEUp[SubJet_Size]/F");
+            Book(tree, "SubJet_Pt_JMEDown", subJetPtJMEDown.data(), "SubJet_Pt_JMEDown[SubJet_Size]/F");
+            Book(tree, "SubJet_Eta", subJetEta.data(), "SubJet_Eta[SubJet_Size]/F");
+            Book(tree, "SubJet_Phi", subJetPhi.data(), "SubJet_Phi[SubJet_Size]/F");
+            Book(tree, "SubJet_Mass", subJetMass.data(), "SubJet_Mass[SubJet_Size]/F");
+            Book(tree, "SubJet_Mass_JMEUp", subJetMassJMEUp.data(), "SubJet_Mass_JMEUp[SubJet_Size]/F");
+            Book(tree, "SubJet_Mass_JMEDown", subJetMassJMEDown.data(), "SubJet_Mass_JMEDown[SubJet_Size]/F");
+            Book(tree, "SubJet_DeepJet", subJetDeepJet.data(), "SubJet_DeepJet[SubJet_Size]/F");
+            Book(tree, "SubJet_DeepCSV", subJetDeepCSV.data(), "SubJet_DeepCSV[SubJet_Size]/F");
+            Book(tree, "SubJet_DeepJetID", subJetDeepJetID.data(), "SubJet_DeepJetID[SubJet_Size]/S");
+            Book(tree, "SubJet_DeepCSVID", subJetDeepCSVID.data(), "SubJet_DeepCSVID[SubJet_Size]/S");
+            Book(tree, "SubJet_PartonFlavour", subJetPartFlav.data(), "SubJet_PartonFlavour[SubJet_Size]/S");
+            Book(tree, "SubJet_JECFac", subJetJEC.data(), "SubJet_JECFac[SubJet_Size]/F");
+            Book(tree, "SubJet_JMEFac", subJetJME.data(), "SubJet_JMEFac[SubJet_Size]/F");
+            Book(tree, "SubJet_FatJetIdx", fatJetIdx.data(), "SubJet_FatJetIdx[SubJet_Size]/S");
+            if(isVirtual) Book(tree, "SubJet_InputIdx", subJetInputIdx.data(), "SubJet_InputIdx[SubJet_Size]/S");
+
+            Book(tree, "FatJet_Pt", fatJetPt.data(), "FatJet_Pt[FatJet_Size]/F");
+            Book(tree, "FatJet_Pt_JMEUp", fatJetPtJMEUp.data(), "FatJet_Pt_JMEUp[FatJet_Size]/F");
+            Book(tree, "FatJet_Pt_JMEDown", fatJetPtJMEDown.data(), "FatJet_Pt_JMEDown[FatJet_Size]/F");
+            Book(tree, "FatJet_Eta", fatJetEta.data(), "FatJet_Eta[FatJet_Size]/F");
+            Book(tree, "FatJet_Phi", fatJetPhi.data(), "FatJet_Phi[FatJet_Size]/F");
+            Book(tree, "FatJet_Mass", fatJetMass.data(), "FatJet_Mass[FatJet_Size]/F");
+            Book(tree, "FatJet_Mass_JMEUp", fatJetMassJMEUp.data(), "FatJet_Mass_JMEUp[FatJet_Size]/F");
+            Book(tree, "FatJet_Mass_JMEDown", fatJetMassJMEDown.data(), "FatJet_Mass_JMEDown[FatJet_Size]/F");
+            Book(tree, "FatJet_Tau1", fatJetTau1.data(), "FatJet_Tau1[FatJet_Size]/F");
+            Book(tree, "FatJet_Tau2", fatJetTau2.data(), "FatJet_Tau2[FatJet_Size]/F");
+            Book(tree, "FatJet_Tau3", fatJetTau3.data(), "FatJet_Tau3[FatJet_Size]/F");
+            Book(tree, "FatJet_DeepAK8ID",fatJetDAK8ID.data(), "FatJet_DeepAK8ID[FatJet_Size]/S");
+            Book(tree, "FatJet_JECFac", fatJetJEC.data(), "FatJet_JECFac[FatJet_Size]/F");
+            Book(tree, "FatJet_JMEFac", fatJetJME.data(), "FatJet_JMEFac[FatJet_Size]/F");
+            if(isVirtual) Book(tree, "FatJet_InputIdx", fatJetInputIdx.data(), "FatJet_InputIdx[FatJet_Size]/S");
             
             if(!isData){
                 std::size_t JECIdx = -1;
@@ -282,55 +531,55 @@ void Output::Register(const std::string& name, const std::vector<std::shared_ptr
                     const std::string JECSyst = j.second.get_value<std::string>();
                     ++JECIdx;            
                 
-                    tree->Branch(("Jet_Pt_JEC" + JECSyst + "Up").c_str(), jetPtJECUp[JECIdx].data(), ("Jet_Pt_JEC" + JECSyst + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_Pt_JEC" + JECSyst + "Down").c_str(), jetPtJECDown[JECIdx].data(), ("Jet_Pt_JEC" + JECSyst + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_Mass_JEC" + JECSyst + "Up").c_str(), jetMassJECUp[JECIdx].data(), ("Jet_Mass_JEC" + JECSyst + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_Mass_JEC" + JECSyst + "Down").c_str(), jetMassJECDown[JECIdx].data(), ("Jet_Mass_JEC" + JECSyst + "Down[Jet_Size]/F").c_str());
+                    Book(tree, "Jet_Pt_JEC" + JECSyst + "Up", jetPtJECUp[JECIdx].data(), "Jet_Pt_JEC" + JECSyst + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_Pt_JEC" + JECSyst + "Down", jetPtJECDown[JECIdx].data(), "Jet_Pt_JEC" + JECSyst + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_Mass_JEC" + JECSyst + "Up", jetMassJECUp[JECIdx].data(), "Jet_Mass_JEC" + JECSyst + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_Mass_JEC" + JECSyst + "Down", jetMassJECDown[JECIdx].data(), "Jet_Mass_JEC" + JECSyst + "Down[Jet_Size]/F");
                     
-                    tree->Branch(("FatJet_Pt_JEC" + JECSyst + "Up").c_str(), fatJetPtJECUp[JECIdx].data(), ("FatJet_Pt_JEC" + JECSyst + "Up[FatJet_Size]/F").c_str());
-                    tree->Branch(("FatJet_Pt_JEC" + JECSyst + "Down").c_str(), fatJetPtJECDown[JECIdx].data(), ("FatJet_Pt_JEC" + JECSyst + "Down[FatJet_Size]/F").c_str());
-                    tree->Branch(("FatJet_Mass_JEC" + JECSyst + "Up").c_str(), fatJetMassJECUp[JECIdx].data(), ("FatJet_Mass_JEC" + JECSyst + "Up[FatJet_Size]/F").c_str());
-                    tree->Branch(("FatJet_Mass_JEC" + JECSyst + "Down").c_str(), fatJetMassJECDown[JECIdx].data(), ("FatJet_Mass_JEC" + JECSyst + "Down[FatJet_Size]/F").c_str());
+                    Book(tree, "FatJet_Pt_JEC" + JECSyst + "Up", fatJetPtJECUp[JECIdx].data(), "FatJet_Pt_JEC" + JECSyst + "Up[FatJet_Size]/F");
+                    Book(tree, "FatJet_Pt_JEC" + JECSyst + "Down", fatJetPtJECDown[JECIdx].data(), "FatJet_Pt_JEC" + JECSyst + "Down[FatJet_Size]/F");
+                    Book(tree, "FatJet_Mass_JEC" + JECSyst + "Up", fatJetMassJECUp[JECIdx].data(), "FatJet_Mass_JEC" + JECSyst + "Up[FatJet_Size]/F");
+                    Book(tree, "FatJet_Mass_JEC" + JECSyst + "Down", fatJetMassJECDown[JECIdx].data(), "FatJet_Mass_JEC" + JECSyst + "Down[FatJet_Size]/F");
                     
-                    tree->Branch(("SubJet_Pt_JEC" + JECSyst + "Up").c_str(), subJetPtJECUp[JECIdx].data(), ("SubJet_Pt_JEC" + JECSyst + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_Pt_JEC" + JECSyst + "Down").c_str(), subJetPtJECDown[JECIdx].data(), ("SubJet_Pt_JEC" + JECSyst + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_Mass_JEC" + JECSyst + "Up").c_str(), subJetMassJECUp[JECIdx].data(), ("SubJet_Mass_JEC" + JECSyst + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_Mass_JEC" + JECSyst + "Down").c_str(), subJetMassJECDown[JECIdx].data(), ("SubJet_Mass_JEC" + JECSyst + "Down[SubJet_Size]/F").c_str());
+                    Book(tree, "SubJet_Pt_JEC" + JECSyst + "Up", subJetPtJECUp[JECIdx].data(), "SubJet_Pt_JEC" + JECSyst + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_Pt_JEC" + JECSyst + "Down", subJetPtJECDown[JECIdx].data(), "SubJet_Pt_JEC" + JECSyst + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_Mass_JEC" + JECSyst + "Up", subJetMassJECUp[JECIdx].data(), "SubJet_Mass_JEC" + JECSyst + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_Mass_JEC" + JECSyst + "Down", subJetMassJECDown[JECIdx].data(), "SubJet_Mass_JEC" + JECSyst + "Down[SubJet_Size]/F");
                     
-                    tree->Branch(("MET_Pt_JEC" + JECSyst + "Up").c_str(), &metPtJECUp[JECIdx], ("MET_Pt_JEC" + JECSyst + "Up/F").c_str());
-                    tree->Branch(("MET_Pt_JEC" + JECSyst + "Down").c_str(), &metPtJECDown[JECIdx], ("MET_Pt_JEC" + JECSyst + "Down/F").c_str());
-                    tree->Branch(("MET_Phi_JEC" + JECSyst + "Up").c_str(), &metPhiJECUp[JECIdx], ("MET_Phi_JEC" + JECSyst + "Up/F").c_str());
-                    tree->Branch(("MET_Phi_JEC" + JECSyst + "Down").c_str(), &metPhiJECDown[JECIdx], ("MET_Phi_JEC" + JECSyst + "Down/F").c_str());  
+                    Book(tree, "MET_Pt_JEC" + JECSyst + "Up", &metPtJECUp[JECIdx], "MET_Pt_JEC" + JECSyst + "Up/F");
+                    Book(tree, "MET_Pt_JEC" + JECSyst + "Down", &metPtJECDown[JECIdx], "MET_Pt_JEC" + JECSyst + "Down/F");
+                    Book(tree, "MET_Phi_JEC" + JECSyst + "Up", &metPhiJECUp[JECIdx], "MET_Phi_JEC" + JECSyst + "Up/F");
+                    Book(tree, "MET_Phi_JEC" + JECSyst + "Down", &metPhiJECDown[JECIdx], "MET_Phi_JEC" + JECSyst + "Down/F");  
                 }
 
-                tree->Branch("Jet_PartonFlavour", jetPartFlav.data(), "Jet_PartonFlavour[Jet_Size]/S");
-                tree->Branch("Jet_GenPt", jetGenPt.data(), "Jet_GenPt[Jet_Size]/F");
-                tree->Branch("Jet_GenEta", jetGenEta.data(), "Jet_GenEta[Jet_Size]/F");
-                tree->Branch("Jet_GenPhi", jetGenPhi.data(), "Jet_GenPhi[Jet_Size]/F");
-                tree->Branch("Jet_GenID", jetGenID.data(), "Jet_GenID[Jet_Size]/S");
-                tree->Branch("Jet_GenMotherID", jetGenMotherID.data(), "Jet_GenMotherID[Jet_Size]/S");
-                tree->Branch("Jet_GenGrandMotherID", jetGenGrandMotherID.data(), "Jet_GenGrandMotherID[Jet_Size]/S");
-
-                tree->Branch("SubJet_GenPt", subJetGenPt.data(), "SubJet_GenPt[SubJet_Size]/F");
-                tree->Branch("SubJet_GenEta", subJetGenEta.data(), "SubJet_GenEta[SubJet_Size]/F");
-                tree->Branch("SubJet_GenPhi", subJetGenPhi.data(), "SubJet_GenPhi[SubJet_Size]/F");
-                tree->Branch("SubJet_GenID", subJetGenID.data(), "SubJet_GenID[SubJet_Size]/S");
-                tree->Branch("SubJet_GenMotherID", subJetGenMotherID.data(), "SubJet_GenMotherID[SubJet_Size]/S");
-                tree->Branch("SubJet_GenGrandMotherID", subJetGenGrandMotherID.data(), "SubJet_GenGrandMotherID[SubJet_Size]/S");
-
-                tree->Branch("Jet_looseDeepCSVSF", jetLooseDeepCSVSF.data(), "Jet_looseDeepCSVSF[Jet_Size]/F");
-                tree->Branch("Jet_mediumDeepCSVSF", jetMediumDeepCSVSF.data(), "Jet_mediumDeepCSVSF[Jet_Size]/F");
-                tree->Branch("Jet_tightDeepCSVSF", jetTightDeepCSVSF.data(), "Jet_tightDeepCSVSF[Jet_Size]/F");
-                tree->Branch("Jet_looseDeepJetSF", jetLooseDeepJetSF.data(), "Jet_looseDeepJetSF[Jet_Size]/F");
-                tree->Branch("Jet_mediumDeepJetSF", jetMediumDeepJetSF.data(), "Jet_mediumDeepJetSF[Jet_Size]/F");
-                tree->Branch("Jet_tightDeepJetSF", jetTightDeepJetSF.data(), "Jet_tightDeepJetSF[Jet_Size]/F");
-
-                tree->Branch("SubJet_looseDeepCSVSF", subJetLooseDeepCSVSF.data(), "SubJet_looseDeepCSVSF[SubJet_Size]/F");
-                tree->Branch("SubJet_mediumDeepCSVSF", subJetMediumDeepCSVSF.data(), "SubJet_mediumDeepCSVSF[SubJet_Size]/F");
-                tree->Branch("SubJet_tightDeepCSVSF", subJetTightDeepCSVSF.data(), "SubJet_tightDeepCSVSF[SubJet_Size]/F");
-                tree->Branch("SubJet_looseDeepJetSF", subJetLooseDeepJetSF.data(), "SubJet_looseDeepJetSF[SubJet_Size]/F");
-                tree->Branch("SubJet_mediumDeepJetSF", subJetMediumDeepJetSF.data(), "SubJet_mediumDeepJetSF[SubJet_Size]/F");
-                tree->Branch("SubJet_tightDeepJetSF", subJetTightDeepJetSF.data(), "SubJet_tightDeepJetSF[SubJet_Size]/F");
+                Book(tree, "Jet_PartonFlavour", jetPartFlav.data(), "Jet_PartonFlavour[Jet_Size]/S");
+                Book(tree, "Jet_GenPt", jetGenPt.data(), "Jet_GenPt[Jet_Size]/F");
+                Book(tree, "Jet_GenEta", jetGenEta.data(), "Jet_GenEta[Jet_Size]/F");
+                Book(tree, "Jet_GenPhi", jetGenPhi.data(), "Jet_GenPhi[Jet_Size]/F");
+                Book(tree, "Jet_GenID", jetGenID.data(), "Jet_GenID[Jet_Size]/S");
+                Book(tree, "Jet_GenMotherID", jetGenMotherID.data(), "Jet_GenMotherID[Jet_Size]/S");
+                Book(tree, "Jet_GenGrandMotherID", jetGenGrandMotherID.data(), "Jet_GenGrandMotherID[Jet_Size]/S");
+
+                Book(tree, "SubJet_GenPt", subJetGenPt.data(), "SubJet_GenPt[SubJet_Size]/F");
+                Book(tree, "SubJet_GenEta", subJetGenEta.data(), "SubJet_GenEta[SubJet_Size]/F");
+                Book(tree, "SubJet_GenPhi", subJetGenPhi.data(), "SubJet_GenPhi[SubJet_Size]/F");
+                Book(tree, "SubJet_GenID", subJetGenID.data(), "SubJet_GenID[SubJet_Size]/S");
+                Book(tree, "SubJet_GenMotherID", subJetGenMotherID.data(), "SubJet_GenMotherID[SubJet_Size]/S");
+                Book(tree, "SubJet_GenGrandMotherID", subJetGenGrandMotherID.data(), "SubJet_GenGrandMotherID[SubJet_Size]/S");
+
+                Book(tree, "Jet_looseDeepCSVSF", jetLooseDeepCSVSF.data(), "Jet_looseDeepCSVSF[Jet_Size]/F");
+                Book(tree, "Jet_mediumDeepCSVSF", jetMediumDeepCSVSF.data(), "Jet_mediumDeepCSVSF[Jet_Size]/F");
+                Book(tree, "Jet_tightDeepCSVSF", jetTightDeepCSVSF.data(), "Jet_tightDeepCSVSF[Jet_Size]/F");
+                Book(tree, "Jet_looseDeepJetSF", jetLooseDeepJetSF.data(), "Jet_looseDeepJetSF[Jet_Size]/F");
+                Book(tree, "Jet_mediumDeepJetSF", jetMediumDeepJetSF.data(), "Jet_mediumDeepJetSF[Jet_Size]/F");
+                Book(tree, "Jet_tightDeepJetSF", jetTightDeepJetSF.data(), "Jet_tightDeepJetSF[Jet_Size]/F");
+
+                Book(tree, "SubJet_looseDeepCSVSF", subJetLooseDeepCSVSF.data(), "SubJet_looseDeepCSVSF[SubJet_Size]/F");
+                Book(tree, "SubJet_mediumDeepCSVSF", subJetMediumDeepCSVSF.data(), "SubJet_mediumDeepCSVSF[SubJet_Size]/F");
+                Book(tree, "SubJet_tightDeepCSVSF", subJetTightDeepCSVSF.data(), "SubJet_tightDeepCSVSF[SubJet_Size]/F");
+                Book(tree, "SubJet_looseDeepJetSF", subJetLooseDeepJetSF.data(), "SubJet_looseDeepJetSF[SubJet_Size]/F");
+                Book(tree, "SubJet_mediumDeepJetSF", subJetMediumDeepJetSF.data(), "SubJet_mediumDeepJetSF[SubJet_Size]/F");
+                Book(tree, "SubJet_tightDeepJetSF", subJetTightDeepJetSF.data(), "SubJet_tightDeepJetSF[SubJet_Size]/F");
 
                 std::size_t bTagUncIdx = -1;
 
@@ -339,91 +588,65 @@ void Output::Register(const std::string& name, const std::vector<std::shared_ptr
                     bUnc[0] = std::toupper(bUnc[0]);
                     ++bTagUncIdx;
 
-                    tree->Branch(("Jet_looseDeepCSVSF" + bUnc + "Up").c_str(), jetLooseDeepCSVSFUp[bTagUncIdx].data(), ("Jet_looseDeepCSVSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepCSVSF" + bUnc + "Down").c_str(), jetLooseDeepCSVSFDown[bTagUncIdx].data(), ("Jet_looseDeepCSVSF" + bUnc + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepCSVSF" + bUnc + "Up").c_str(), jetMediumDeepCSVSFUp[bTagUncIdx].data(), ("Jet_mediumDeepCSVSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepCSVSF" + bUnc + "Down").c_str(), jetMediumDeepCSVSFDown[bTagUncIdx].data(), ("Jet_mediumDeepCSVSF" + bUnc + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepCSVSF" + bUnc + "Up").c_str(), jetTightDeepCSVSFUp[bTagUncIdx].data(), ("Jet_tightDeepCSVSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepCSVSF" + bUnc + "Down").c_str(), jetTightDeepCSVSFDown[bTagUncIdx].data(), ("Jet_tightDeepCSVSF" + bUnc + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepJetSF" + bUnc + "Up").c_str(), jetLooseDeepJetSFUp[bTagUncIdx].data(), ("Jet_looseDeepJetSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepJetSF" + bUnc + "Down").c_str(), jetLooseDeepJetSFDown[bTagUncIdx].data(), ("Jet_looseDeepJetSF" + bUnc + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepJetSF" + bUnc + "Up").c_str(), jetMediumDeepJetSFUp[bTagUncIdx].data(), ("Jet_mediumDeepJetSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepJetSF" + bUnc + "Down").c_str(), jetMediumDeepJetSFDown[bTagUncIdx].data(), ("Jet_mediumDeepJetSF" + bUnc + "Down[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepJetSF" + bUnc + "Up").c_str(), jetTightDeepJetSFUp[bTagUncIdx].data(), ("Jet_tightDeepJetSF" + bUnc + "Up[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepJetSF" + bUnc + "Down").c_str(), jetTightDeepJetSFDown[bTagUncIdx].data(), ("Jet_tightDeepJetSF" + bUnc + "Down[Jet_Size]/F").c_str());
-
-                    tree->Branch(("SubJet_looseDeepCSVSF" + bUnc + "Up").c_str(), subJetLooseDeepCSVSFUp[bTagUncIdx].data(), ("SubJet_looseDeepCSVSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepCSVSF" + bUnc + "Down").c_str(), subJetLooseDeepCSVSFDown[bTagUncIdx].data(), ("SubJet_looseDeepCSVSF" + bUnc + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepCSVSF" + bUnc + "Up").c_str(), subJetMediumDeepCSVSFUp[bTagUncIdx].data(), ("SubJet_mediumDeepCSVSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepCSVSF" + bUnc + "Down").c_str(), subJetMediumDeepCSVSFDown[bTagUncIdx].data(), ("SubJet_mediumDeepCSVSF" + bUnc + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepCSVSF" + bUnc + "Up").c_str(), subJetTightDeepCSVSFUp[bTagUncIdx].data(), ("SubJet_tightDeepCSVSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepCSVSF" + bUnc + "Down").c_str(), subJetTightDeepCSVSFDown[bTagUncIdx].data(), ("SubJet_tightDeepCSVSF" + bUnc + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepJetSF" + bUnc + "Up").c_str(), subJetLooseDeepJetSFUp[bTagUncIdx].data(), ("SubJet_looseDeepJetSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepJetSF" + bUnc + "Down").c_str(), subJetLooseDeepJetSFDown[bTagUncIdx].data(), ("SubJet_looseDeepJetSF" + bUnc + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepJetSF" + bUnc + "Up").c_str(), subJetMediumDeepJetSFUp[bTagUncIdx].data(), ("SubJet_mediumDeepJetSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepJetSF" + bUnc + "Down").c_str(), subJetMediumDeepJetSFDown[bTagUncIdx].data(), ("SubJet_mediumDeepJetSF" + bUnc + "Down[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepJetSF" + bUnc + "Up").c_str(), subJetTightDeepJetSFUp[bTagUncIdx].data(), ("SubJet_tightDeepJetSF" + bUnc + "Up[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepJetSF" + bUnc + "Down").c_str(), subJetTightDeepJetSFDown[bTagUncIdx].data(), ("SubJet_tightDeepJetSF" + bUnc + "Down[SubJet_Size]/F").c_str());
+                    Book(tree, "Jet_looseDeepCSVSF" + bUnc + "Up", jetLooseDeepCSVSFUp[bTagUncIdx].data(), "Jet_looseDeepCSVSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepCSVSF" + bUnc + "Down", jetLooseDeepCSVSFDown[bTagUncIdx].data(), "Jet_looseDeepCSVSF" + bUnc + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepCSVSF" + bUnc + "Up", jetMediumDeepCSVSFUp[bTagUncIdx].data(), "Jet_mediumDeepCSVSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepCSVSF" + bUnc + "Down", jetMediumDeepCSVSFDown[bTagUncIdx].data(), "Jet_mediumDeepCSVSF" + bUnc + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepCSVSF" + bUnc + "Up", jetTightDeepCSVSFUp[bTagUncIdx].data(), "Jet_tightDeepCSVSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepCSVSF" + bUnc + "Down", jetTightDeepCSVSFDown[bTagUncIdx].data(), "Jet_tightDeepCSVSF" + bUnc + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepJetSF" + bUnc + "Up", jetLooseDeepJetSFUp[bTagUncIdx].data(), "Jet_looseDeepJetSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepJetSF" + bUnc + "Down", jetLooseDeepJetSFDown[bTagUncIdx].data(), "Jet_looseDeepJetSF" + bUnc + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepJetSF" + bUnc + "Up", jetMediumDeepJetSFUp[bTagUncIdx].data(), "Jet_mediumDeepJetSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepJetSF" + bUnc + "Down", jetMediumDeepJetSFDown[bTagUncIdx].data(), "Jet_mediumDeepJetSF" + bUnc + "Down[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepJetSF" + bUnc + "Up", jetTightDeepJetSFUp[bTagUncIdx].data(), "Jet_tightDeepJetSF" + bUnc + "Up[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepJetSF" + bUnc + "Down", jetTightDeepJetSFDown[bTagUncIdx].data(), "Jet_tightDeepJetSF" + bUnc + "Down[Jet_Size]/F");
+
+                    Book(tree, "SubJet_looseDeepCSVSF" + bUnc + "Up", subJetLooseDeepCSVSFUp[bTagUncIdx].data(), "SubJet_looseDeepCSVSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepCSVSF" + bUnc + "Down", subJetLooseDeepCSVSFDown[bTagUncIdx].data(), "SubJet_looseDeepCSVSF" + bUnc + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepCSVSF" + bUnc + "Up", subJetMediumDeepCSVSFUp[bTagUncIdx].data(), "SubJet_mediumDeepCSVSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepCSVSF" + bUnc + "Down", subJetMediumDeepCSVSFDown[bTagUncIdx].data(), "SubJet_mediumDeepCSVSF" + bUnc + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepCSVSF" + bUnc + "Up", subJetTightDeepCSVSFUp[bTagUncIdx].data(), "SubJet_tightDeepCSVSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepCSVSF" + bUnc + "Down", subJetTightDeepCSVSFDown[bTagUncIdx].data(), "SubJet_tightDeepCSVSF" + bUnc + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepJetSF" + bUnc + "Up", subJetLooseDeepJetSFUp[bTagUncIdx].data(), "SubJet_looseDeepJetSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepJetSF" + bUnc + "Down", subJetLooseDeepJetSFDown[bTagUncIdx].data(), "SubJet_looseDeepJetSF" + bUnc + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepJetSF" + bUnc + "Up", subJetMediumDeepJetSFUp[bTagUncIdx].data(), "SubJet_mediumDeepJetSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepJetSF" + bUnc + "Down", subJetMediumDeepJetSFDown[bTagUncIdx].data(), "SubJet_mediumDeepJetSF" + bUnc + "Down[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepJetSF" + bUnc + "Up", subJetTightDeepJetSFUp[bTagUncIdx].data(), "SubJet_tightDeepJetSF" + bUnc + "Up[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepJetSF" + bUnc + "Down", subJetTightDeepJetSFDown[bTagUncIdx].data(), "SubJet_tightDeepJetSF" + bUnc + "Down[SubJet_Size]/F");
                 }
 
-                bTagUncIdx = 0;
+                bTagUncIdx = -1;
 
                 for(const std::pair<std::string, boost::property_tree::ptree> j : skim.get_child("Analyzer.Jet.BTagSystLight")){
                     std::string bUnc = j.second.get_value<std::string>();
                     bUnc[0] = std::toupper(bUnc[0]);
                     ++bTagUncIdx;
 
-                    jetLooseDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    jetLooseDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    jetMediumDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    jetMediumDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    jetTightDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    jetTightDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    jetLooseDeepJetSFLightDown.push_back(std::array<float, jetMax>()); 
-                    jetLooseDeepJetSFLightUp.push_back(std::array<float, jetMax>());
-                    jetMediumDeepJetSFLightDown.push_back(std::array<float, jetMax>()); 
-                    jetMediumDeepJetSFLightUp.push_back(std::array<float, jetMax>());  
-                    jetTightDeepJetSFLightDown.push_back(std::array<float, jetMax>()); 
-                    jetTightDeepJetSFLightUp.push_back(std::array<float, jetMax>());
-
-                    subJetLooseDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    subJetLooseDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    subJetMediumDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    subJetMediumDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    subJetTightDeepCSVSFLightDown.push_back(std::array<float, jetMax>());
-                    subJetTightDeepCSVSFLightUp.push_back(std::array<float, jetMax>());
-                    subJetLooseDeepJetSFLightDown.push_back(std::array<float, jetMax>()); 
-                    subJetLooseDeepJetSFLightUp.push_back(std::array<float, jetMax>());
-                    subJetMediumDeepJetSFLightDown.push_back(std::array<float, jetMax>()); 
-                    subJetMediumDeepJetSFLightUp.push_back(std::array<float, jetMax>());  
-                    subJetTightDeepJetSFLightDown.push_back(std::array<float, jetMax>());
-                    subJetTightDeepJetSFLightUp.push_back(std::array<float, jetMax>()); 
-
-                    tree->Branch(("Jet_looseDeepCSVSF" + bUnc + "LightUp").c_str(), jetLooseDeepCSVSFLightUp[bTagUncIdx].data(), ("Jet_looseDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepCSVSF" + bUnc + "LightDown").c_str(), jetLooseDeepCSVSFLightDown[bTagUncIdx].data(), ("Jet_looseDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepCSVSF" + bUnc + "LightUp").c_str(), jetMediumDeepCSVSFLightUp[bTagUncIdx].data(), ("Jet_mediumDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepCSVSF" + bUnc + "LightDown").c_str(), jetMediumDeepCSVSFLightDown[bTagUncIdx].data(), ("Jet_mediumDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepCSVSF" + bUnc + "LightUp").c_str(), jetTightDeepCSVSFLightUp[bTagUncIdx].data(), ("Jet_tightDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepCSVSF" + bUnc + "LightDown").c_str(), jetTightDeepCSVSFLightDown[bTagUncIdx].data(), ("Jet_tightDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepJetSF" + bUnc + "LightUp").c_str(), jetLooseDeepJetSFLightUp[bTagUncIdx].data(), ("Jet_looseDeepJetSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_looseDeepJetSF" + bUnc + "LightDown").c_str(), jetLooseDeepJetSFLightDown[bTagUncIdx].data(), ("Jet_looseDeepJetSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepJetSF" + bUnc + "LightUp").c_str(), jetMediumDeepJetSFLightUp[bTagUncIdx].data(), ("Jet_mediumDeepJetSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_mediumDeepJetSF" + bUnc + "LightDown").c_str(), jetMediumDeepJetSFLightDown[bTagUncIdx].data(), ("Jet_mediumDeepJetSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepJetSF" + bUnc + "LightUp").c_str(), jetTightDeepJetSFLightUp[bTagUncIdx].data(), ("Jet_tightDeepJetSF" + bUnc + "LightUp[Jet_Size]/F").c_str());
-                    tree->Branch(("Jet_tightDeepJetSF" + bUnc + "LightDown").c_str(), jetTightDeepJetSFLightDown[bTagUncIdx].data(), ("Jet_tightDeepJetSF" + bUnc + "LightDown[Jet_Size]/F").c_str());
-
-                    tree->Branch(("SubJet_looseDeepCSVSF" + bUnc + "LightUp").c_str(), subJetLooseDeepCSVSFLightUp[bTagUncIdx].data(), ("SubJet_looseDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepCSVSF" + bUnc + "LightDown").c_str(), subJetLooseDeepCSVSFLightDown[bTagUncIdx].data(), ("SubJet_looseDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepCSVSF" + bUnc + "LightUp").c_str(), subJetMediumDeepCSVSFLightUp[bTagUncIdx].data(), ("SubJet_mediumDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepCSVSF" + bUnc + "LightDown").c_str(), subJetMediumDeepCSVSFLightDown[bTagUncIdx].data(), ("SubJet_mediumDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepCSVSF" + bUnc + "LightUp").c_str(), subJetTightDeepCSVSFLightUp[bTagUncIdx].data(), ("SubJet_tightDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepCSVSF" + bUnc + "LightDown").c_str(), subJetTightDeepCSVSFLightDown[bTagUncIdx].data(), ("SubJet_tightDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepJetSF" + bUnc + "LightUp").c_str(), subJetLooseDeepJetSFLightUp[bTagUncIdx].data(), ("SubJet_looseDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_looseDeepJetSF" + bUnc + "LightDown").c_str(), subJetLooseDeepJetSFLightDown[bTagUncIdx].data(), ("SubJet_looseDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepJetSF" + bUnc + "LightUp").c_str(), subJetMediumDeepJetSFLightUp[bTagUncIdx].data(), ("SubJet_mediumDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_mediumDeepJetSF" + bUnc + "LightDown").c_str(), subJetMediumDeepJetSFLightDown[bTagUncIdx].data(), ("SubJet_mediumDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepJetSF" + bUnc + "LightUp").c_str(), subJetTightDeepJetSFLightUp[bTagUncIdx].data(), ("SubJet_tightDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F").c_str());
-                    tree->Branch(("SubJet_tightDeepJetSF" + bUnc + "LightDown").c_str(), subJetTightDeepJetSFLightDown[bTagUncIdx].data(), ("SubJet_tightDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F").c_str());
+                    Book(tree, "Jet_looseDeepCSVSF" + bUnc + "LightUp", jetLooseDeepCSVSFLightUp[bTagUncIdx].data(), "Jet_looseDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepCSVSF" + bUnc + "LightDown", jetLooseDeepCSVSFLightDown[bTagUncIdx].data(), "Jet_looseDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepCSVSF" + bUnc + "LightUp", jetMediumDeepCSVSFLightUp[bTagUncIdx].data(), "Jet_mediumDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepCSVSF" + bUnc + "LightDown", jetMediumDeepCSVSFLightDown[bTagUncIdx].data(), "Jet_mediumDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepCSVSF" + bUnc + "LightUp", jetTightDeepCSVSFLightUp[bTagUncIdx].data(), "Jet_tightDeepCSVSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepCSVSF" + bUnc + "LightDown", jetTightDeepCSVSFLightDown[bTagUncIdx].data(), "Jet_tightDeepCSVSF" + bUnc + "LightDown[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepJetSF" + bUnc + "LightUp", jetLooseDeepJetSFLightUp[bTagUncIdx].data(), "Jet_looseDeepJetSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_looseDeepJetSF" + bUnc + "LightDown", jetLooseDeepJetSFLightDown[bTagUncIdx].data(), "Jet_looseDeepJetSF" + bUnc + "LightDown[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepJetSF" + bUnc + "LightUp", jetMediumDeepJetSFLightUp[bTagUncIdx].data(), "Jet_mediumDeepJetSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_mediumDeepJetSF" + bUnc + "LightDown", jetMediumDeepJetSFLightDown[bTagUncIdx].data(), "Jet_mediumDeepJetSF" + bUnc + "LightDown[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepJetSF" + bUnc + "LightUp", jetTightDeepJetSFLightUp[bTagUncIdx].data(), "Jet_tightDeepJetSF" + bUnc + "LightUp[Jet_Size]/F");
+                    Book(tree, "Jet_tightDeepJetSF" + bUnc + "LightDown", jetTightDeepJetSFLightDown[bTagUncIdx].data(), "Jet_tightDeepJetSF" + bUnc + "LightDown[Jet_Size]/F");
+
+                    Book(tree, "SubJet_looseDeepCSVSF" + bUnc + "LightUp", subJetLooseDeepCSVSFLightUp[bTagUncIdx].data(), "SubJet_looseDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepCSVSF" + bUnc + "LightDown", subJetLooseDeepCSVSFLightDown[bTagUncIdx].data(), "SubJet_looseDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepCSVSF" + bUnc + "LightUp", subJetMediumDeepCSVSFLightUp[bTagUncIdx].data(), "SubJet_mediumDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepCSVSF" + bUnc + "LightDown", subJetMediumDeepCSVSFLightDown[bTagUncIdx].data(), "SubJet_mediumDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepCSVSF" + bUnc + "LightUp", subJetTightDeepCSVSFLightUp[bTagUncIdx].data(), "SubJet_tightDeepCSVSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepCSVSF" + bUnc + "LightDown", subJetTightDeepCSVSFLightDown[bTagUncIdx].data(), "SubJet_tightDeepCSVSF" + bUnc + "LightDown[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepJetSF" + bUnc + "LightUp", subJetLooseDeepJetSFLightUp[bTagUncIdx].data(), "SubJet_looseDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_looseDeepJetSF" + bUnc + "LightDown", subJetLooseDeepJetSFLightDown[bTagUncIdx].data(), "SubJet_looseDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepJetSF" + bUnc + "LightUp", subJetMediumDeepJetSFLightUp[bTagUncIdx].data(), "SubJet_mediumDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_mediumDeepJetSF" + bUnc + "LightDown", subJetMediumDeepJetSFLightDown[bTagUncIdx].data(), "SubJet_mediumDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepJetSF" + bUnc + "LightUp", subJetTightDeepJetSFLightUp[bTagUncIdx].data(), "SubJet_tightDeepJetSF" + bUnc + "LightUp[SubJet_Size]/F");
+                    Book(tree, "SubJet_tightDeepJetSF" + bUnc + "LightDown", subJetTightDeepJetSFLightDown[bTagUncIdx].data(), "SubJet_tightDeepJetSF" + bUnc + "LightDown[SubJet_Size]/F");
                 }
             }
         }
@@ -431,24 +654,28 @@ void Output::Register(const std::string& name, const std::vector<std::shared_ptr
 
     if(name == "Isotrack"){
         for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch("IsoTrack_Size", &isotrkSize, "IsoTrack_Size/S");
-
-            tree->Branch("IsoTrack_PDG", isotrkPDG.data(), "IsoTrack_PDG[IsoTrack_Size]/S");
-            tree->Branch("IsoTrack_Charge", isotrkCharge.data(), "IsoTrack_Charge[IsoTrack_Size]/S");
-            tree->Branch("IsoTrack_Pt", isotrkPt.data(), "IsoTrack_Pt[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_Eta", isotrkEta.data(), "IsoTrack_Eta[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_Phi", isotrkPhi.data(), "IsoTrack_Phi[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_Dxy", isotrkDxy.data(), "IsoTrack_Dxy[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_Dz", isotrkDz.data(), "IsoTrack_Dz[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_Isolation03", isotrkIso03.data(), "IsoTrack_Isolation03[IsoTrack_Size]/F");
-            tree->Branch("IsoTrack_MiniIsolation", isotrkMiniIso.data(), "IsoTrack_MiniIsolation[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Size", &isotrkSize, "IsoTrack_Size/S");
+
+            Book(tree, "IsoTrack_PDG", isotrkPDG.data(), "IsoTrack_PDG[IsoTrack_Size]/S");
+            Book(tree, "IsoTrack_Charge", isotrkCharge.data(), "IsoTrack_Charge[IsoTrack_Size]/S");
+            Book(tree, "IsoTrack_Pt", isotrkPt.data(), "IsoTrack_Pt[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Eta", isotrkEta.data(), "IsoTrack_Eta[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Phi", isotrkPhi.data(), "IsoTrack_Phi[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Dxy", isotrkDxy.data(), "IsoTrack_Dxy[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Dz", isotrkDz.data(), "IsoTrack_Dz[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_Isolation03", isotrkIso03.data(), "IsoTrack_Isolation03[IsoTrack_Size]/F");
+            Book(tree, "IsoTrack_MiniIsolation", isotrkMiniIso.data(), "IsoTrack_MiniIsolation[IsoTrack_Size]/F");
+            if(isVirtual) Book(tree, "IsoTrack_InputIdx", isotrkInputIdx.data(), "IsoTrack_InputIdx[IsoTrack_Size]/S");
         }
     }
 
     if(name == "Misc"){
         for(const std::shared_ptr<TTree>& tree: trees){
-            tree->Branch("Misc_eventNumber", &evNr, "Misc_eventNumber/I");
-            if(!isData) tree->Branch("Misc_nParton", &nParton, "Misc_nParton/S");
+            Book(tree, "Misc_eventNumber", &evNr, "Misc_eventNumber/l");
+            Book(tree, "Misc_run", &runNr, "Misc_run/i");
+            Book(tree, "Misc_lumiBlock", &lumiNr, "Misc_lumiBlock/i");
+            if(isVirtual) Book(tree, "Misc_InputEntry", &inputEntry, "Misc_InputEntry/l");
+            if(!isData) Book(tree, "Misc_nParton", &nParton, "Misc_nParton/S");
         }
     }
 }
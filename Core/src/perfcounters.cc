@@ -0,0 +1,164 @@
+#include <ChargedSkimming/Core/interface/perfcounters.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#ifdef __linux__
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+#endif
+
+namespace pt = boost::property_tree;
+
+const std::array<std::string, PerfCounters::nCounters> PerfCounters::counterNames = {"Cycles", "Instructions", "CacheMisses", "BranchMisses"};
+
+PerfCounters::PerfCounters(){
+    position.fill(-1);
+
+#ifdef __linux__
+    const std::array<std::uint64_t, nCounters> configs = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    for(std::size_t i = 0; i < nCounters; ++i){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.disabled = leader < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+
+        if(fd < 0){
+            //Without cycles there is no group, other counters are optional
+            if(i == 0) break;
+
+            std::cout << "Hardware counter not available: " << counterNames[i] << std::endl;
+            continue;
+        }
+
+        if(leader < 0) leader = fd;
+        fds.push_back(fd);
+        position[i] = nOpened++;
+    }
+
+    if(leader >= 0){
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+
+    if(leader < 0) std::cout << "Hardware performance counters not available (check /proc/sys/kernel/perf_event_paranoid), counters are disabled" << std::endl;
+}
+
+PerfCounters::~PerfCounters(){
+#ifdef __linux__
+    for(const int& fd : fds) close(fd);
+#endif
+}
+
+std::size_t PerfCounters::AddStage(const std::string& name){
+    Stage s;
+    s.name = name;
+    stages.push_back(s);
+
+    return stages.size() - 1;
+}
+
+void PerfCounters::Read(Values& values) const {
+    values = Values();
+
+#ifdef __linux__
+    //Group read format: number of counters, time enabled and time running followed by their values
+    std::uint64_t buffer[3 + nCounters];
+    if(read(leader, buffer, sizeof(buffer)) <= 0) return;
+
+    values.enabled = buffer[1];
+    values.running = buffer[2];
+
+    for(std::size_t i = 0; i < nCounters; ++i){
+        if(position[i] >= 0) values.counts[i] = buffer[3 + position[i]];
+    }
+#endif
+}
+
+void PerfCounters::Add(const std::size_t& stage, const Values& start){
+    Values end;
+    Read(end);
+
+    Stage& s = stages[stage];
+    ++s.calls;
+
+    //Failed read, or the group was never scheduled on the PMU during the scope
+    if(start.enabled == 0 or end.enabled == 0 or end.running <= start.running) return;
+
+    //Raw counts are cumulative, so the differences are never negative. If the PMU multiplexed during the scope,
+    //the group only counted while running, so the difference is scaled to the enabled time of the scope
+    std::uint64_t enabled = end.enabled - start.enabled, running = end.running - start.running;
+    double scale = 1.;
+
+    if(running < enabled){
+        multiplexed = true;
+        scale = double(enabled)/running;
+    }
+
+    for(std::size_t i = 0; i < nCounters; ++i) s.counts[i] += (end.counts[i] - start.counts[i]) * scale;
+}
+
+void PerfCounters::Print() const {
+    if(!Available()) return;
+
+    std::cout << std::left << std::setw(12) << "Stage" << std::setw(12) << "Calls" << std::setw(8) << "IPC";
+    for(const std::string& name : counterNames) std::cout << std::setw(16) << name + "/call";
+    std::cout << std::endl;
+
+    for(const Stage& s : stages){
+        std::cout << std::left << std::setw(12) << s.name << std::setw(12) << s.calls << std::setw(8) << std::setprecision(3) << (s.counts[0] != 0 ? double(s.counts[1])/s.counts[0] : 0);
+
+        for(std::size_t i = 0; i < nCounters; ++i){
+            std::cout << std::setw(16) << std::setprecision(6) << (s.calls != 0 ? double(s.counts[i])/s.calls : 0);
+        }
+
+        std::cout << std::endl;
+    }
+
+    if(multiplexed) std::cout << "Counters were multiplexed by the PMU, counts are scaled estimates" << std::endl;
+}
+
+void PerfCounters::WriteReport(const std::string& fileName) const {
+    pt::ptree report, available, stageList;
+
+    for(std::size_t i = 0; i < nCounters; ++i){
+        available.put(counterNames[i], position[i] >= 0);
+    }
+
+    for(const Stage& s : stages){
+        pt::ptree stage;
+
+        stage.put("name", s.name);
+        stage.put("calls", s.calls);
+        stage.put("IPC", s.counts[0] != 0 ? double(s.counts[1])/s.counts[0] : 0);
+
+        for(std::size_t i = 0; i < nCounters; ++i){
+            stage.put(counterNames[i], s.counts[i]);
+            stage.put(counterNames[i] + "PerCall", s.calls != 0 ? double(s.counts[i])/s.calls : 0);
+        }
+
+        stageList.push_back(std::make_pair("", stage));
+    }
+
+    report.put("Multiplexed", multiplexed);
+    report.add_child("Available", available);
+    report.add_child("Stages", stageList);
+    pt::write_json(fileName, report);
+
+    std::cout << "Written performance counter report: " << fileName << std::endl;
+}
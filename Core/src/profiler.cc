@@ -0,0 +1,102 @@
+#include <ChargedSkimming/Core/interface/profiler.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include <TH1D.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+std::size_t Profiler::AddStage(const std::string& name){
+    Stage s;
+    s.name = name;
+    stages.push_back(s);
+
+    return stages.size() - 1;
+}
+
+double Profiler::Percentile(const std::size_t& stage, const double& q) const {
+    const Stage& s = stages[stage];
+    if(s.calls == 0) return 0;
+
+    double target = q * s.calls, sum = 0;
+
+    for(std::size_t i = 0; i < nBins; ++i){
+        if(s.histogram[i] == 0) continue;
+
+        //Linear interpolation inside the bin
+        if(sum + s.histogram[i] >= target){
+            return LowEdge(i) + (target - sum) / s.histogram[i] * (LowEdge(i + 1) - LowEdge(i));
+        }
+
+        sum += s.histogram[i];
+    }
+
+    return LowEdge(nBins);
+}
+
+void Profiler::Print() const {
+    double total = 0;
+    for(const Stage& s : stages) total += s.total;
+
+    std::cout << std::left << std::setw(12) << "Stage" << std::setw(12) << "Calls" << std::setw(12) << "Total [s]" << std::setw(10) << "Share" << std::setw(12) << "Mean [us]" << std::setw(12) << "p50 [us]" << std::setw(12) << "p99 [us]" << "p99.9 [us]" << std::endl;
+
+    for(std::size_t i = 0; i < stages.size(); ++i){
+        const Stage& s = stages[i];
+
+        std::cout << std::left << std::setw(12) << s.name << std::setw(12) << s.calls << std::setw(12) << s.total/1e9 << std::setw(10) << (total != 0 ? s.total/total*100 : 0) << std::setw(12) << (s.calls != 0 ? s.total/s.calls/1e3 : 0)
+                  << std::setw(12) << Percentile(i, 0.5)/1e3 << std::setw(12) << Percentile(i, 0.99)/1e3 << Percentile(i, 0.999)/1e3 << std::endl;
+    }
+}
+
+void Profiler::WriteOutput(const std::shared_ptr<TFile>& outFile) const {
+    outFile->cd();
+
+    std::vector<double> edges;
+    for(std::size_t i = 0; i <= nBins; ++i) edges.push_back(LowEdge(i)/1e3);
+
+    TH1D totals("Timing_Total", "Timing_Total", stages.size(), 0, stages.size());
+
+    for(std::size_t i = 0; i < stages.size(); ++i){
+        const Stage& s = stages[i];
+
+        //Latency distribution in microseconds
+        TH1D latency(("Timing_" + s.name).c_str(), ("Timing_" + s.name).c_str(), nBins, edges.data());
+        for(std::size_t b = 0; b < nBins; ++b) latency.SetBinContent(b + 1, s.histogram[b]);
+        latency.SetEntries(s.calls);
+        latency.Write();
+
+        totals.GetXaxis()->SetBinLabel(i + 1, s.name.c_str());
+        totals.SetBinContent(i + 1, s.total/1e9);
+    }
+
+    totals.Write();
+}
+
+void Profiler::WriteReport(const std::string& fileName) const {
+    pt::ptree report, stageList;
+
+    for(std::size_t i = 0; i < stages.size(); ++i){
+        const Stage& s = stages[i];
+        pt::ptree stage;
+
+        stage.put("name", s.name);
+        stage.put("calls", s.calls);
+        stage.put("totalSeconds", s.total/1e9);
+        stage.put("meanMicroseconds", s.calls != 0 ? s.total/s.calls/1e3 : 0);
+        stage.put("p50Microseconds", Percentile(i, 0.5)/1e3);
+        stage.put("p90Microseconds", Percentile(i, 0.9)/1e3);
+        stage.put("p99Microseconds", Percentile(i, 0.99)/1e3);
+        stage.put("p999Microseconds", Percentile(i, 0.999)/1e3);
+
+        stageList.push_back(std::make_pair("", stage));
+    }
+
+    report.add_child("Stages", stageList);
+    pt::write_json(fileName, report);
+
+    std::cout << "Written timing report: " << fileName << std::endl;
+}
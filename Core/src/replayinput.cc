@@ -0,0 +1,298 @@
+#include <ChargedSkimming/Core/interface/replayinput.h>
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+ReplayInput::ReplayInput(const std::string& fileName){
+    this->fileName = fileName;
+
+    std::ifstream in(fileName, std::ios::binary);
+    if(!in) throw std::runtime_error("Could not open replay file: '" + fileName + "'");
+
+    char fileMagic[8];
+    in.read(fileMagic, 8);
+    if(std::memcmp(fileMagic, magic, 8) != 0) throw std::runtime_error("Not a replay file: '" + fileName + "'");
+
+    std::uint32_t fileSizes[8];
+    in.read(reinterpret_cast<char*>(fileSizes), sizeof(fileSizes));
+    if(std::memcmp(fileSizes, recordSizes, sizeof(recordSizes)) != 0) throw std::runtime_error("Replay file was written with another record layout, capture the events again: '" + fileName + "'");
+
+    std::uint64_t nEvents;
+    in.read(reinterpret_cast<char*>(&nEvents), 8);
+    in.read(reinterpret_cast<char*>(&isData), sizeof(bool));
+
+    for(std::vector<std::string>* names : {&triggerNames, &METFilterNames}){
+        std::uint32_t nNames;
+        in.read(reinterpret_cast<char*>(&nNames), 4);
+
+        for(std::size_t i = 0; i < nNames; ++i){
+            std::uint32_t length;
+            in.read(reinterpret_cast<char*>(&length), 4);
+
+            std::string name(length, ' ');
+            in.read(&name[0], length);
+            names->push_back(name);
+        }
+    }
+
+    triggerMask = std::vector<std::uint64_t>((triggerNames.size() + 63)/64, 0);
+    METFilterMask = std::vector<std::uint64_t>((METFilterNames.size() + 63)/64, 0);
+
+    scalars = std::vector<Scalars>(nEvents);
+    in.read(reinterpret_cast<char*>(scalars.data()), nEvents * sizeof(Scalars));
+
+    triggerMasks = std::vector<std::uint64_t>(nEvents * triggerMask.size());
+    in.read(reinterpret_cast<char*>(triggerMasks.data()), triggerMasks.size() * 8);
+
+    METFilterMasks = std::vector<std::uint64_t>(nEvents * METFilterMask.size());
+    in.read(reinterpret_cast<char*>(METFilterMasks.data()), METFilterMasks.size() * 8);
+
+    ReadCollection(in, electrons);
+    ReadCollection(in, muons);
+    ReadCollection(in, jets);
+    ReadCollection(in, fatJets);
+    ReadCollection(in, genJets);
+    ReadCollection(in, genFatJets);
+    ReadCollection(in, isotrks);
+    ReadCollection(in, genParts);
+
+    if(!in) throw std::runtime_error("Replay file is truncated: '" + fileName + "'");
+
+    std::cout << "Replay events: " << fileName << " (" << nEvents << " events, " << (isData ? "data" : "MC") << ")" << std::endl;
+}
+
+template <typename R>
+void ReplayInput::WriteCollection(std::ofstream& out, const Collection<R>& c){
+    out.write(reinterpret_cast<const char*>(c.offset.data()), c.offset.size() * 4);
+    out.write(reinterpret_cast<const char*>(c.objects.data()), c.objects.size() * sizeof(R));
+}
+
+template <typename R>
+void ReplayInput::ReadCollection(std::ifstream& in, Collection<R>& c){
+    //Number of events is known from the scalars
+    c.offset = std::vector<std::uint32_t>(scalars.size() + 1);
+    in.read(reinterpret_cast<char*>(c.offset.data()), c.offset.size() * 4);
+
+    c.objects = std::vector<R>(c.offset.back());
+    in.read(reinterpret_cast<char*>(c.objects.data()), c.objects.size() * sizeof(R));
+}
+
+void ReplayInput::AddEvent(){
+    electrons.offset.push_back(electrons.objects.size());
+    muons.offset.push_back(muons.objects.size());
+    jets.offset.push_back(jets.objects.size());
+    fatJets.offset.push_back(fatJets.objects.size());
+    genJets.offset.push_back(genJets.objects.size());
+    genFatJets.offset.push_back(genFatJets.objects.size());
+    isotrks.offset.push_back(isotrks.objects.size());
+    genParts.offset.push_back(genParts.objects.size());
+}
+
+void ReplayInput::Write(const std::string& fileName){
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out) throw std::runtime_error("Could not create replay file: '" + fileName + "'");
+
+    std::uint64_t nEvents = scalars.size();
+
+    out.write(magic, 8);
+    out.write(reinterpret_cast<const char*>(recordSizes), sizeof(recordSizes));
+    out.write(reinterpret_cast<const char*>(&nEvents), 8);
+    out.write(reinterpret_cast<const char*>(&isData), sizeof(bool));
+
+    for(const std::vector<std::string>* names : {&triggerNames, &METFilterNames}){
+        std::uint32_t nNames = names->size();
+        out.write(reinterpret_cast<const char*>(&nNames), 4);
+
+        for(const std::string& name : *names){
+            std::uint32_t length = name.size();
+            out.write(reinterpret_cast<const char*>(&length), 4);
+            out.write(name.data(), length);
+        }
+    }
+
+    out.write(reinterpret_cast<const char*>(scalars.data()), nEvents * sizeof(Scalars));
+    out.write(reinterpret_cast<const char*>(triggerMasks.data()), triggerMasks.size() * 8);
+    out.write(reinterpret_cast<const char*>(METFilterMasks.data()), METFilterMasks.size() * 8);
+
+    WriteCollection(out, electrons);
+    WriteCollection(out, muons);
+    WriteCollection(out, jets);
+    WriteCollection(out, fatJets);
+    WriteCollection(out, genJets);
+    WriteCollection(out, genFatJets);
+    WriteCollection(out, isotrks);
+    WriteCollection(out, genParts);
+
+    out.close();
+    std::cout << "Written replay file: " << fileName << " (" << nEvents << " events)" << std::endl;
+}
+
+void ReplayInput::GetWeightEntry(){
+    const Scalars& s = scalars[entry];
+
+    std::copy(std::begin(s.pdfWeight), std::end(s.pdfWeight), std::begin(pdfWeight));
+    std::copy(std::begin(s.scaleWeight), std::end(s.scaleWeight), std::begin(scaleWeight));
+    nTrueInt = s.nTrueInt;
+    genWeight = s.genWeight;
+    preFire = s.preFire;
+    preFireUp = s.preFireUp;
+    preFireDown = s.preFireDown;
+}
+
+void ReplayInput::GetTrigger(){
+    std::copy_n(triggerMasks.begin() + entry * triggerMask.size(), triggerMask.size(), triggerMask.begin());
+}
+
+void ReplayInput::GetMETFilter(){
+    std::copy_n(METFilterMasks.begin() + entry * METFilterMask.size(), METFilterMask.size(), METFilterMask.begin());
+}
+
+void ReplayInput::GetElectron(const std::size_t& idx){
+    const Electron& e = electrons.Get(entry, idx);
+
+    eleCharge = e.charge;
+    eleCutID = e.cutID;
+    eleMVAID = e.MVAID;
+    eleConvVeto = e.convVeto;
+    elePt = e.pt;
+    elePtSigmaUp = e.ptSigmaUp;
+    elePtSigmaDown = e.ptSigmaDown;
+    elePtScaleUp = e.ptScaleUp;
+    elePtScaleDown = e.ptScaleDown;
+    eleEta = e.eta;
+    elePhi = e.phi;
+    eleDxy = e.dxy;
+    eleDz = e.dz;
+    eleRelJetIso = e.relJetIso;
+    eleIso03 = e.iso03;
+    eleIso04 = e.iso04;
+    eleMiniIso = e.miniIso;
+}
+
+void ReplayInput::GetMuon(const std::size_t& idx){
+    const Muon& m = muons.Get(entry, idx);
+
+    muCharge = m.charge;
+    muCutID = m.cutID;
+    muMVAID = m.MVAID;
+    muNTrackerLayers = m.nTrackerLayers;
+    muPt = m.pt;
+    muEta = m.eta;
+    muPhi = m.phi;
+    muDxy = m.dxy;
+    muDz = m.dz;
+    muRelJetIso = m.relJetIso;
+    muIso03 = m.iso03;
+    muIso04 = m.iso04;
+    muMiniIso = m.miniIso;
+}
+
+void ReplayInput::ReadJetEntry(const bool& isData){
+    const Scalars& s = scalars[entry];
+
+    rho = s.rho;
+    metPt = s.metPt;
+    metPhi = s.metPhi;
+    metDeltaUnClustX = s.metDeltaUnClustX;
+    metDeltaUnClustY = s.metDeltaUnClustY;
+
+    jetSize = jets.Size(entry);
+    fatJetSize = fatJets.Size(entry);
+
+    if(!isData){
+        genJetSize = genJets.Size(entry);
+        genFatJetSize = genFatJets.Size(entry);
+    }
+}
+
+void ReplayInput::GetJet(const std::size_t& idx){
+    const Jet& j = jets.Get(entry, idx);
+
+    jetID = j.ID;
+    jetPUID = j.PUID;
+    jetPt = j.pt;
+    jetMass = j.mass;
+    jetPtRaw = j.ptRaw;
+    jetMassRaw = j.massRaw;
+    jetEta = j.eta;
+    jetPhi = j.phi;
+    jetArea = j.area;
+    jetDeepJet = j.deepJet;
+    jetDeepCSV = j.deepCSV;
+    jetPartFlav = j.partFlav;
+}
+
+void ReplayInput::GetFatJet(const std::size_t& idx){
+    const FatJet& j = fatJets.Get(entry, idx);
+
+    fatJetDAK8ID = j.DAK8ID;
+    fatJetPt = j.pt;
+    fatJetMass = j.mass;
+    fatJetPtRaw = j.ptRaw;
+    fatJetMassRaw = j.massRaw;
+    fatJetEta = j.eta;
+    fatJetPhi = j.phi;
+    fatJetArea = j.area;
+    fatJetTau1 = j.tau1;
+    fatJetTau2 = j.tau2;
+    fatJetTau3 = j.tau3;
+}
+
+void ReplayInput::GetGenJet(const std::size_t& idx){
+    const GenJet& j = genJets.Get(entry, idx);
+
+    genJetPt = j.pt;
+    genJetEta = j.eta;
+    genJetPhi = j.phi;
+}
+
+void ReplayInput::GetGenFatJet(const std::size_t& idx){
+    const GenJet& j = genFatJets.Get(entry, idx);
+
+    genFatJetPt = j.pt;
+    genFatJetEta = j.eta;
+    genFatJetPhi = j.phi;
+}
+
+void ReplayInput::GetIsotrk(const std::size_t& idx){
+    const Isotrk& t = isotrks.Get(entry, idx);
+
+    isotrkPDG = t.PDG;
+    isotrkPt = t.pt;
+    isotrkEta = t.eta;
+    isotrkPhi = t.phi;
+    isotrkDxy = t.dxy;
+    isotrkDz = t.dz;
+    isotrkIso03 = t.iso03;
+    isotrkIso04 = t.iso04;
+    isotrkMiniIso = t.miniIso;
+}
+
+void ReplayInput::GetMisc(){
+    const Scalars& s = scalars[entry];
+
+    nParton = s.nParton;
+    evNr = s.evNr;
+    runNr = s.runNr;
+    lumiNr = s.lumiNr;
+    inputEntry = s.inputEntry;
+}
+
+void ReplayInput::GetGenPart(const std::size_t& idx){
+    //Mother index -1 is requested by Input::LastGenCopy for the first particles
+    if(idx >= genParts.Size(entry)){
+        genPDG = 0;
+        genMotherIdx = -1;
+        return;
+    }
+
+    const GenPart& g = genParts.Get(entry, idx);
+
+    genPDG = g.PDG;
+    genMotherIdx = g.motherIdx;
+    genPt = g.pt;
+    genPhi = g.phi;
+    genEta = g.eta;
+    genMass = g.mass;
+}
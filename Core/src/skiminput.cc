@@ -0,0 +1,30 @@
+#include <ChargedSkimming/Core/interface/skiminput.h>
+
+#include <TBranch.h>
+#include <TObjArray.h>
+
+SkimInput::SkimInput(const std::string& fileName, const std::string& treeName){
+    this->fileName = fileName;
+
+    inputFile = std::shared_ptr<TFile>(TFile::Open(fileName.c_str(), "READ"));
+    if(!inputFile or inputFile->IsZombie()) throw std::runtime_error("Could not open file: '" + fileName + "'");
+
+    inputTree.reset(static_cast<TTree*>(inputFile->Get(treeName.c_str())));
+    if(!inputTree) throw std::runtime_error("Tree '" + treeName + "' not found in file: '" + fileName + "'");
+}
+
+std::vector<std::string> SkimInput::BranchNames(){
+    std::vector<std::string> names;
+    TObjArray* branches = inputTree->GetListOfBranches();
+
+    for(int i = 0; i < branches->GetEntries(); ++i){
+        names.push_back(branches->At(i)->GetName());
+    }
+
+    return names;
+}
+
+void SkimInput::ReadEntry(){
+    inputTree->GetEntry(entry);
+    inputEntry = entry;
+}
@@ -0,0 +1,122 @@
+#include <ChargedSkimming/Core/interface/sloweventrecorder.h>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+SlowEventRecorder::SlowEventRecorder(const long long& threshold, const std::size_t& topK) : threshold(threshold), topK(topK) {}
+
+std::size_t SlowEventRecorder::AddStage(const std::string& name){
+    stageNames.push_back(name);
+    stageTimes.push_back(0);
+
+    return stageNames.size() - 1;
+}
+
+void SlowEventRecorder::BeginEvent(const std::size_t& entry){
+    this->entry = entry;
+    std::fill(stageTimes.begin(), stageTimes.end(), 0);
+    start = std::chrono::steady_clock::now();
+}
+
+void SlowEventRecorder::EndEvent(const Multiplicity& multiplicity){
+    long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    ++nEvents;
+
+    bool isSlow = threshold > 0 and total > threshold;
+    bool isTop = topK != 0 and (top.size() < topK or total > top.front().total);
+    if(!isSlow and !isTop) return;
+
+    Event event{entry, total, stageTimes, multiplicity};
+
+    if(isSlow){
+        ++nAboveThreshold;
+        if(aboveThreshold.size() < maxRecorded) aboveThreshold.push_back(event);
+    }
+
+    if(isTop){
+        if(top.size() == topK){
+            std::pop_heap(top.begin(), top.end(), Faster);
+            top.pop_back();
+        }
+
+        top.push_back(event);
+        std::push_heap(top.begin(), top.end(), Faster);
+    }
+}
+
+std::vector<std::size_t> SlowEventRecorder::Entries() const {
+    std::vector<std::size_t> entries;
+
+    for(const std::vector<Event>* events : {&aboveThreshold, &top}){
+        for(const Event& e : *events) entries.push_back(e.entry);
+    }
+
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    return entries;
+}
+
+void SlowEventRecorder::Print() const {
+    std::vector<Event> sorted = top;
+    std::sort(sorted.begin(), sorted.end(), Faster);
+
+    std::cout << "Slow events: " << nAboveThreshold << " of " << nEvents << " above " << threshold/1e6 << " ms";
+    if(nAboveThreshold > (long long)maxRecorded) std::cout << " (only first " << maxRecorded << " recorded)";
+    std::cout << std::endl;
+
+    if(sorted.empty()) return;
+
+    std::cout << std::left << std::setw(12) << "Entry" << std::setw(12) << "Total [ms]" << std::setw(40) << "Slowest stage" << "nEle/nMu/nJet/nFatJet/nGen" << std::endl;
+
+    for(const Event& e : sorted){
+        std::size_t slowest = std::max_element(e.stageTimes.begin(), e.stageTimes.end()) - e.stageTimes.begin();
+        std::string stage = stageNames.empty() ? "" : stageNames[slowest] + " (" + std::to_string(e.stageTimes[slowest]/1e6) + " ms)";
+
+        std::cout << std::left << std::setw(12) << e.entry << std::setw(12) << e.total/1e6 << std::setw(40) << stage
+                  << e.multiplicity.electrons << "/" << e.multiplicity.muons << "/" << e.multiplicity.jets << "/" << e.multiplicity.fatJets << "/" << e.multiplicity.genParts << std::endl;
+    }
+}
+
+void SlowEventRecorder::WriteReport(const std::string& fileName) const {
+    pt::ptree report, topList, slowList;
+
+    auto toTree = [&](const Event& e){
+        pt::ptree event, stages;
+
+        event.put("Entry", e.entry);
+        event.put("TotalMicroseconds", e.total/1e3);
+
+        for(std::size_t i = 0; i < stageNames.size(); ++i) stages.put(stageNames[i], e.stageTimes[i]/1e3);
+        event.add_child("StageMicroseconds", stages);
+
+        event.put("Multiplicity.Electron", e.multiplicity.electrons);
+        event.put("Multiplicity.Muon", e.multiplicity.muons);
+        event.put("Multiplicity.Jet", e.multiplicity.jets);
+        event.put("Multiplicity.FatJet", e.multiplicity.fatJets);
+        event.put("Multiplicity.GenPart", e.multiplicity.genParts);
+
+        return event;
+    };
+
+    std::vector<Event> sorted = top;
+    std::sort(sorted.begin(), sorted.end(), Faster);
+
+    for(const Event& e : sorted) topList.push_back(std::make_pair("", toTree(e)));
+    for(const Event& e : aboveThreshold) slowList.push_back(std::make_pair("", toTree(e)));
+
+    report.put("Events", nEvents);
+    report.put("ThresholdMicroseconds", threshold/1e3);
+    report.put("AboveThreshold", nAboveThreshold);
+    report.add_child("Top", topList);
+    report.add_child("Slow", slowList);
+
+    pt::write_json(fileName, report);
+    std::cout << "Written slow event report: " << fileName << std::endl;
+}
@@ -0,0 +1,49 @@
+#include <ChargedSkimming/Core/interface/tracer.h>
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+
+Tracer::Tracer(const std::size_t& sampleRate) : sampleRate(std::max(sampleRate, std::size_t(1))), begin(std::chrono::steady_clock::now()) {
+    std::cout << "Trace event timeline of every " << this->sampleRate << ". event" << std::endl;
+}
+
+void Tracer::Record(const std::string& name, const char* category, const double& start, const double& duration){
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //Small thread numbers instead of the native ids
+    std::vector<std::thread::id>::iterator it = std::find(threads.begin(), threads.end(), std::this_thread::get_id());
+    if(it == threads.end()) it = threads.insert(threads.end(), std::this_thread::get_id());
+
+    events.push_back({name, category, start, duration, std::size_t(it - threads.begin()), entry});
+}
+
+void Tracer::Write(const std::string& fileName){
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::ofstream out(fileName);
+    if(!out) throw std::runtime_error("Could not create trace file: '" + fileName + "'");
+
+    int pid = ::getpid();
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+    for(std::size_t i = 0; i < threads.size(); ++i){
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << i << ", \"args\": {\"name\": \"" << (i == 0 ? "Event loop" : "Thread " + std::to_string(i)) << "\"}},\n";
+    }
+
+    for(std::size_t i = 0; i < events.size(); ++i){
+        const Event& e = events[i];
+
+        out << "{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", \"ts\": " << std::fixed << e.start << ", \"dur\": " << e.duration
+            << ", \"pid\": " << pid << ", \"tid\": " << e.thread << ", \"args\": {\"entry\": " << e.entry << "}}" << (i + 1 != events.size() ? ",\n" : "\n");
+    }
+
+    out << "]}\n";
+    out.close();
+
+    std::cout << "Written trace: " << fileName << " (" << events.size() << " spans)" << std::endl;
+}
@@ -0,0 +1,31 @@
+#include <ChargedSkimming/Core/interface/virtualskimreader.h>
+
+#include <TList.h>
+#include <TNamed.h>
+
+VirtualSkimReader::VirtualSkimReader(const std::string& skimFileName, const std::string& channel, const std::string& nanoFileName){
+    skimFile = std::shared_ptr<TFile>(TFile::Open(skimFileName.c_str(), "READ"));
+    if(!skimFile or skimFile->IsZombie()) throw std::runtime_error("Could not open file: '" + skimFileName + "'");
+
+    skimTree = skimFile->Get<TTree>(channel.c_str());
+    if(!skimTree) throw std::runtime_error("Tree '" + channel + "' not found in file: '" + skimFileName + "'");
+
+    TNamed* inputFile = static_cast<TNamed*>(skimTree->GetUserInfo()->FindObject("InputFile"));
+    TNamed* inputTree = static_cast<TNamed*>(skimTree->GetUserInfo()->FindObject("InputTree"));
+    if(!inputFile or !inputTree) throw std::runtime_error("Tree '" + channel + "' in file '" + skimFileName + "' was not written in virtual mode");
+
+    std::string fileName = nanoFileName != "" ? nanoFileName : inputFile->GetTitle();
+
+    nanoFile = std::shared_ptr<TFile>(TFile::Open(fileName.c_str(), "READ"));
+    if(!nanoFile or nanoFile->IsZombie()) throw std::runtime_error("Could not open file: '" + fileName + "'");
+
+    nanoTree = nanoFile->Get<TTree>(inputTree->GetTitle());
+    if(!nanoTree) throw std::runtime_error("Tree '" + std::string(inputTree->GetTitle()) + "' not found in file: '" + fileName + "'");
+
+    skimTree->SetBranchAddress("Misc_InputEntry", &inputEntry);
+}
+
+void VirtualSkimReader::GetEntry(const long long& entry){
+    skimTree->GetEntry(entry);
+    nanoTree->GetEntry(inputEntry);
+}
@@ -0,0 +1,202 @@
+#include <ChargedSkimming/Core/interface/zonemap.h>
+
+#include <iostream>
+#include <algorithm>
+#include <experimental/filesystem>
+
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+ZoneMap::ZoneMap(const std::string& cacheDir, const std::string& fileName, TTree* tree, const std::vector<std::string>& triggerNames) : fileName(fileName), nEntries(tree->GetEntries()), triggerNames(triggerNames) {
+    //Sidecar is keyed by a hash of the input file name
+    sideCar = cacheDir + "/" + Util::HashName(Util::Hash(fileName.data(), fileName.size())) + ".json";
+
+    if(Load()){
+        complete = true;
+        std::cout << "Use zone map: " << sideCar << " (" << zones.size() << " clusters)" << std::endl;
+        return;
+    }
+
+    //Zone boundaries are the cluster boundaries of the input tree
+    TTree::TClusterIterator cluster = tree->GetClusterIterator(0);
+    long long first;
+
+    while((first = cluster.Next()) < nEntries){
+        Zone zone;
+        zone.first = first;
+        zone.end = std::min(cluster.GetNextEntry(), nEntries);
+        zone.triggerMask = std::vector<std::uint64_t>((triggerNames.size() + 63)/64, 0);
+
+        zones.push_back(zone);
+    }
+
+    std::cout << "Build zone map: " << sideCar << " (" << zones.size() << " clusters)" << std::endl;
+}
+
+bool ZoneMap::Load(){
+    if(!std::experimental::filesystem::exists(sideCar)) return false;
+
+    pt::ptree index;
+    pt::read_json(sideCar, index);
+
+    //Different file with same hash or file changed since the index was build
+    if(index.get<std::string>("File") != fileName or index.get<long long>("Entries") != nEntries){
+        std::cout << "Zone map '" << sideCar << "' does not match input file, it will be rebuild" << std::endl;
+        return false;
+    }
+
+    triggerNames.clear();
+    for(const std::pair<const std::string, pt::ptree>& t : index.get_child("Trigger")) triggerNames.push_back(t.second.get_value<std::string>());
+
+    for(const std::pair<const std::string, pt::ptree>& z : index.get_child("Zones")){
+        Zone zone;
+        zone.first = z.second.get<long long>("First");
+        zone.end = z.second.get<long long>("End");
+        zone.maxElectrons = z.second.get<short>("MaxElectron");
+        zone.maxMuons = z.second.get<short>("MaxMuon");
+        zone.maxJets = z.second.get<short>("MaxJet");
+        zone.maxFatJets = z.second.get<short>("MaxFatJet");
+        zone.maxLeptonPt = z.second.get<float>("MaxLeptonPt");
+
+        for(const std::pair<const std::string, pt::ptree>& w : z.second.get_child("Trigger")) zone.triggerMask.push_back(w.second.get_value<std::uint64_t>());
+
+        zones.push_back(zone);
+    }
+
+    return true;
+}
+
+std::size_t ZoneMap::FindZone(const long long& entry){
+    //Entries are normally read in order, so check the current zone first
+    if(current < zones.size() and zones[current].first <= entry and entry < zones[current].end) return current;
+    if(current + 1 < zones.size() and zones[current + 1].first <= entry and entry < zones[current + 1].end) return ++current;
+
+    current = std::upper_bound(zones.begin(), zones.end(), entry, [](const long long& e, const Zone& z){return e < z.first;}) - zones.begin() - 1;
+
+    return current;
+}
+
+void ZoneMap::Fill(const long long& entry, const short& nElectrons, const short& nMuons, const short& nJets, const short& nFatJets, const float& leadingLeptonPt, const std::vector<std::uint64_t>& triggerMask){
+    if(complete) return;
+
+    Zone& zone = zones[FindZone(entry)];
+
+    zone.maxElectrons = std::max(zone.maxElectrons, nElectrons);
+    zone.maxMuons = std::max(zone.maxMuons, nMuons);
+    zone.maxJets = std::max(zone.maxJets, nJets);
+    zone.maxFatJets = std::max(zone.maxFatJets, nFatJets);
+    zone.maxLeptonPt = std::max(zone.maxLeptonPt, leadingLeptonPt);
+
+    for(std::size_t w = 0; w < zone.triggerMask.size(); ++w) zone.triggerMask[w] |= triggerMask[w];
+
+    ++nFilled;
+}
+
+void ZoneMap::SetRequirements(const std::vector<ZoneRequirement>& requirements){
+    skippable = std::vector<char>(zones.size(), false);
+    if(!complete) return;
+
+    std::size_t nSkippable = 0;
+    long long nSkippedEntries = 0;
+
+    for(std::size_t i = 0; i < zones.size(); ++i){
+        const Zone& zone = zones[i];
+        bool anyChannel = false;
+
+        for(const ZoneRequirement& r : requirements){
+            if(zone.maxElectrons < r.minElectrons or zone.maxMuons < r.minMuons or zone.maxJets < r.minJets or zone.maxFatJets < r.minFatJets) continue;
+            if(r.minLeptonPt > 0 and zone.maxLeptonPt <= r.minLeptonPt) continue;
+
+            //Trigger not known to the index might have fired
+            bool anyTrigger = r.triggers.empty();
+
+            for(const std::string& name : r.triggers){
+                std::vector<std::string>::iterator it = std::find(triggerNames.begin(), triggerNames.end(), name);
+                std::size_t bit = it - triggerNames.begin();
+
+                if(it == triggerNames.end() or zone.triggerMask[bit/64] >> bit%64 & 1){
+                    anyTrigger = true;
+                    break;
+                }
+            }
+
+            if(anyTrigger){
+                anyChannel = true;
+                break;
+            }
+        }
+
+        skippable[i] = !anyChannel;
+
+        if(skippable[i]){
+            ++nSkippable;
+            nSkippedEntries += zone.end - zone.first;
+        }
+    }
+
+    std::cout << "Zone map: " << nSkippable << " of " << zones.size() << " clusters (" << nSkippedEntries << " events) can be skipped" << std::endl;
+}
+
+long long ZoneMap::NextEntry(const long long& entry){
+    if(!complete or entry >= nEntries) return entry;
+
+    long long next = entry;
+
+    for(std::size_t i = FindZone(entry); i < zones.size() and skippable[i]; ++i){
+        next = zones[i].end;
+    }
+
+    return next;
+}
+
+void ZoneMap::Write(){
+    if(complete) return;
+
+    if(nFilled != nEntries){
+        std::cout << "Zone map not written, only " << nFilled << " of " << nEntries << " events were indexed" << std::endl;
+        return;
+    }
+
+    pt::ptree index, trigger, zoneList;
+    index.put("File", fileName);
+    index.put("Entries", nEntries);
+
+    for(const std::string& name : triggerNames){
+        pt::ptree t;
+        t.put("", name);
+        trigger.push_back(std::make_pair("", t));
+    }
+
+    index.add_child("Trigger", trigger);
+
+    for(const Zone& zone : zones){
+        pt::ptree z, mask;
+        z.put("First", zone.first);
+        z.put("End", zone.end);
+        z.put("MaxElectron", zone.maxElectrons);
+        z.put("MaxMuon", zone.maxMuons);
+        z.put("MaxJet", zone.maxJets);
+        z.put("MaxFatJet", zone.maxFatJets);
+        z.put("MaxLeptonPt", zone.maxLeptonPt);
+
+        for(const std::uint64_t& word : zone.triggerMask){
+            pt::ptree w;
+            w.put("", word);
+            mask.push_back(std::make_pair("", w));
+        }
+
+        z.add_child("Trigger", mask);
+        zoneList.push_back(std::make_pair("", z));
+    }
+
+    index.add_child("Zones", zoneList);
+
+    //Best effort, the skim does not need the sidecar (e.g. read-only or full cache directory)
+    try {
+        Util::WriteAtomic(sideCar, [&](const std::string& tmp){pt::write_json(tmp, index);});
+        std::cout << "Written zone map: " << sideCar << std::endl;
+    }
+
+    catch(const std::exception& e){
+        std::cout << "Warning: Could not write zone map '" << sideCar << "': " << e.what() << std::endl;
+    }
+}
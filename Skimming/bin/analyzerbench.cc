@@ -0,0 +1,134 @@
+#include <ChargedSkimming/Core/interface/replayinput.h>
+#include <ChargedSkimming/Core/interface/output.h>
+#include <ChargedSkimming/Core/interface/skimmer.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Replay captured events through one analyzer and report the time per event
+    std::string replayFile = Util::ParseLine(argc, argv, "replay-file");
+    std::string analyzerName = Util::ParseLine(argc, argv, "analyzer");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string warmup = Util::ParseLine(argc, argv, "warmup");
+    std::string repetitions = Util::ParseLine(argc, argv, "repetitions");
+    std::string history = Util::ParseLine(argc, argv, "history");
+
+    if(replayFile == "" or analyzerName == "" or era == "") throw std::runtime_error("Usage: AnalyzerBench --replay-file <file> --analyzer <name> --era <era> [--warmup <n>] [--repetitions <n>] [--history <jsonl>]");
+
+    ReplayInput input(replayFile);
+    bool isData = input.IsData();
+    std::string run = isData ? "A" : "MC";
+
+    //Read in json config
+    pt::ptree sf = Skimmer<ReplayInput>::ReadConfig("sf.json"), skim = Skimmer<ReplayInput>::ReadConfig("skim.json");
+
+    skim.put<std::string>("xSec", "1");
+    skim.put<std::string>("xSecUnc", "0");
+    skim.put<std::string>("run", run);
+    skim.put<std::string>("era", era);
+    skim.put<bool>("isData", isData);
+
+    //Branches are booked on a tree which is never filled, only to lay out the output class like in the skimming
+    std::shared_ptr<TTree> tree = std::make_shared<TTree>("Bench", "Bench");
+    tree->SetDirectory(nullptr);
+
+    Output output;
+    output.AddBranchSelection("Bench", {"*"}, {});
+    output.RegisterTrigger(input.triggerNames, {tree});
+
+    for(const std::string& name : {"Weight", "Electron", "Muon", "Jet", "Isotrack", "Misc"}){
+        output.Register(name, {tree}, skim, isData);
+    }
+
+    //Same analyzers as in the skimmer, analyzers before the benchmarked one provide its output state
+    std::vector<std::shared_ptr<BaseAnalyzer<ReplayInput>>> analyzer = Skimmer<ReplayInput>::MakeAnalyzers();
+
+    std::size_t target = analyzer.size();
+    std::vector<std::string> names;
+
+    for(std::size_t i = 0; i < analyzer.size(); ++i){
+        names.push_back(analyzer[i]->Name());
+        if(names.back() == analyzerName) target = i;
+    }
+
+    if(target == analyzer.size()){
+        std::string known;
+        for(const std::string& name : names) known += " " + name;
+
+        throw std::runtime_error("Unknown analyzer '" + analyzerName + "', available:" + known);
+    }
+
+    for(std::size_t i = 0; i <= target; ++i) analyzer[i]->BeginJob(skim, sf);
+
+    //Time per event in ns of each repetition, warmup repetitions are not recorded
+    int nWarmup = warmup != "" ? std::stoi(warmup) : 1, nRepetitions = repetitions != "" ? std::stoi(repetitions) : 10;
+    if(nWarmup < 0 or nRepetitions < 1) throw std::runtime_error("Need at least one repetition and no negative number of warmup repetitions");
+
+    std::vector<double> times;
+
+    for(int rep = -nWarmup; rep < nRepetitions; ++rep){
+        long long ns = 0;
+
+        for(std::size_t entry = 0; entry < input.GetEntries(); ++entry){
+            input.SetEntry(entry);
+
+            for(std::size_t i = 0; i < target; ++i) analyzer[i]->Analyze(input, output);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            analyzer[target]->Analyze(input, output);
+            ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        if(rep >= 0) times.push_back(double(ns)/input.GetEntries());
+    }
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+
+    double mean = 0, stdDev = 0;
+    for(const double& t : times) mean += t/times.size();
+    for(const double& t : times) stdDev += (t - mean)*(t - mean)/std::max(times.size() - 1, std::size_t(1));
+    stdDev = std::sqrt(stdDev);
+
+    double median = sorted.size() % 2 ? sorted[sorted.size()/2] : (sorted[sorted.size()/2 - 1] + sorted[sorted.size()/2])/2;
+
+    std::cout << "Analyzer: " << analyzerName << ", " << input.GetEntries() << " events x " << nRepetitions << " repetitions" << std::endl;
+    std::cout << "Time per event [ns]: mean " << mean << " +- " << stdDev << ", median " << median << ", min " << sorted.front() << ", max " << sorted.back() << std::endl;
+
+    //Append result to the performance history of the analyzer (one JSON object per line)
+    if(history != ""){
+        pt::ptree entry;
+        entry.put("Time", std::time(nullptr));
+        entry.put("Analyzer", analyzerName);
+        entry.put("Era", era);
+        entry.put("ReplayFile", replayFile);
+        entry.put("Events", input.GetEntries());
+        entry.put("Repetitions", nRepetitions);
+        entry.put("Mean", mean);
+        entry.put("Std", stdDev);
+        entry.put("Median", median);
+        entry.put("Min", sorted.front());
+
+        std::ofstream out(history, std::ios::app);
+        pt::write_json(out, entry, false);
+
+        std::cout << "Appended result to history: " << history << std::endl;
+    }
+}
@@ -0,0 +1,101 @@
+#include <ChargedSkimming/Core/interface/eventset.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TLeaf.h>
+#include <TKey.h>
+#include <TList.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+//Add the events of all trees (channels) of a skim file
+void AddSkim(const std::string& fileName, std::vector<EventSet::Event>& events){
+    std::shared_ptr<TFile> file(TFile::Open(fileName.c_str(), "READ"));
+    if(!file or file->IsZombie()) throw std::runtime_error("Could not open skim: '" + fileName + "'");
+
+    TList* keys = file->GetListOfKeys();
+
+    for(int k = 0; k < keys->GetEntries(); ++k){
+        TKey* key = static_cast<TKey*>(keys->At(k));
+        if(std::string(key->GetClassName()) != "TTree") continue;
+
+        TTree* tree = static_cast<TTree*>(key->ReadObj());
+        TLeaf* run = tree->GetLeaf("Misc_run");
+        TLeaf* lumi = tree->GetLeaf("Misc_lumiBlock");
+        TLeaf* event = tree->GetLeaf("Misc_eventNumber");
+
+        if(run == nullptr or lumi == nullptr or event == nullptr){
+            throw std::runtime_error("Tree '" + std::string(tree->GetName()) + "' in '" + fileName + "' has no Misc_run/Misc_lumiBlock/Misc_eventNumber, skim it again");
+        }
+
+        //Older skims store the event number as 32 bit integer, which does not identify the event
+        if(std::string(event->GetTypeName()) != "ULong64_t"){
+            throw std::runtime_error("Tree '" + std::string(tree->GetName()) + "' in '" + fileName + "' has a 32 bit Misc_eventNumber, skim it again");
+        }
+
+        for(long long i = 0; i < tree->GetEntries(); ++i){
+            run->GetBranch()->GetEntry(i);
+            lumi->GetBranch()->GetEntry(i);
+            event->GetBranch()->GetEntry(i);
+
+            events.push_back({std::uint32_t(run->GetValue()), std::uint32_t(lumi->GetValue()), event->GetTypedValue<std::uint64_t>()});
+        }
+
+        std::cout << "Read " << tree->GetEntries() << " events of tree '" << tree->GetName() << "' in " << fileName << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]){
+    //Extract informations of command line
+    std::string dataset = Util::ParseLine(argc, argv, "dataset");
+    std::vector<std::string> skims = Util::SplitString(Util::ParseLine(argc, argv, "skims"), " ");
+    std::string outFile = Util::ParseLine(argc, argv, "out-file");
+
+    if(dataset == "" or skims.empty() or outFile == ""){
+        throw std::runtime_error("Usage: DedupSet --dataset <dataset to be skimmed> --skims \"<dataset>=<skim file> ...\" --out-file <event set>");
+    }
+
+    //Events of datasets with higher priority are removed from the skimmed dataset
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+    std::vector<std::string> priority = Util::GetVector<std::string>(skim, "Dedup.Priority");
+
+    std::function<std::size_t(const std::string&)> rank = [&](const std::string& name){
+        std::vector<std::string>::iterator it = std::find(priority.begin(), priority.end(), name);
+        if(it == priority.end()) throw std::runtime_error("Dataset '" + name + "' not in 'Dedup.Priority' of skim.json");
+
+        return std::size_t(it - priority.begin());
+    };
+
+    std::vector<EventSet::Event> events;
+
+    for(const std::string& s : skims){
+        if(s == "") continue;
+
+        std::size_t split = s.find("=");
+        if(split == std::string::npos) throw std::runtime_error("Skim '" + s + "' is not given as <dataset>=<skim file>");
+
+        std::string name = s.substr(0, split), fileName = s.substr(split + 1);
+
+        if(rank(name) >= rank(dataset)){
+            std::cout << "Skim of " << name << " has no priority over " << dataset << ", it is not used: " << fileName << std::endl;
+            continue;
+        }
+
+        AddSkim(fileName, events);
+    }
+
+    EventSet::Write(events, outFile);
+}
@@ -0,0 +1,92 @@
+#include <ChargedSkimming/Core/interface/skimmer.h>
+#include <ChargedSkimming/Core/interface/nanoinput.h>
+#include <ChargedSkimming/Core/interface/nanogenerator.h>
+#include <ChargedSkimming/Core/interface/output.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <experimental/filesystem>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Run the full skimming on a (synthetic) NanoAOD file and report the throughput
+    std::string fileName = Util::ParseLine(argc, argv, "file-name");
+    std::string preset = Util::ParseLine(argc, argv, "preset");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string nEvents = Util::ParseLine(argc, argv, "n-events");
+    std::string outDir = Util::ParseLine(argc, argv, "out-dir");
+    std::string timingReport = Util::ParseLine(argc, argv, "timing-report");
+    std::vector<std::string> channels = Util::SplitString(Util::ParseLine(argc, argv, "channels"), " ");
+
+    if(era == "") throw std::runtime_error("Usage: NanoBench --era <era> [--file-name <NanoAOD file>] [--preset ttbar|data] [--n-events <n>] [--channels \"<c1> <c2>\"] [--out-dir <dir>] [--timing-report <json>]");
+    if(preset == "") preset = "ttbar";
+    if(outDir == "") outDir = "/tmp/NanoBench";
+
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+    if(channels.empty()) channels = Util::GetKeys(skim, "Channel");
+
+    NanoGenerator::Config config = NanoGenerator::Preset(preset);
+
+    //Generate input if no file is given
+    if(fileName == ""){
+        if(nEvents != "") config.nEvents = std::stoul(nEvents);
+
+        config.triggers = Util::TriggerNames(skim, era);
+
+        config.METFilters = Util::GetVector<std::string>(skim, "Analyzer.METFilter." + era);
+
+        std::experimental::filesystem::create_directories(outDir);
+        fileName = outDir + "/" + preset + "_" + era + ".root";
+
+        NanoGenerator generator(config);
+        generator.Write(fileName);
+    }
+
+    std::string run = config.isData ? "A" : "MC";
+
+    NanoInput input(fileName, "Events");
+    Output output;
+
+    std::chrono::time_point<std::chrono::steady_clock> start;
+    float loopSeconds, seconds;
+
+    //Output files are closed when the skimmer goes out of scope
+    {
+        Skimmer<NanoInput> skimmer(channels, "1", "0", era, run);
+        skimmer.Configure(input, output, outDir + "/[C]", "bench.root");
+        skimmer.SetTimingReport(timingReport);
+
+        start = std::chrono::steady_clock::now();
+
+        for(std::size_t entry = 0; entry < input.GetEntries(); ++entry){
+            input.SetEntry(entry);
+            skimmer.Loop(input, output);
+        }
+
+        loopSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+        skimmer.WriteOutput();
+    }
+
+    seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+    long long bytesWritten = 0;
+
+    for(const std::string& channel : channels){
+        std::string outName = outDir + "/" + channel + "/bench.root";
+        if(std::experimental::filesystem::exists(outName)) bytesWritten += std::experimental::filesystem::file_size(outName);
+    }
+
+    std::cout << "Events: " << input.GetEntries() << ", event loop: " << loopSeconds << " s (" << input.GetEntries()/loopSeconds << " events/s), including output: " << seconds << " s (" << input.GetEntries()/seconds << " events/s)" << std::endl;
+    std::cout << "Bytes written: " << bytesWritten/1e6 << " MB (" << bytesWritten/1e6/seconds << " MB/s)" << std::endl;
+}
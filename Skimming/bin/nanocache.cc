@@ -0,0 +1,50 @@
+#include <ChargedSkimming/Core/interface/nanocache.h>
+#include <ChargedSkimming/Core/interface/nanoinput.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Write the NanoAOD leaves read by NanoInput into an uncompressed, memory-mappable cache file
+    std::string fileName = Util::ParseLine(argc, argv, "file-name");
+    std::string outFile = Util::ParseLine(argc, argv, "out-file");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string run = Util::ParseLine(argc, argv, "run");
+    std::string blockSize = Util::ParseLine(argc, argv, "block-size");
+    std::vector<std::string> filterChannels = Util::SplitString(Util::ParseLine(argc, argv, "prefilter-channels"), " ");
+
+    if(fileName == "" or outFile == "" or era == "") throw std::runtime_error("Usage: NanoCache --file-name <NanoAOD file> --out-file <cache file> --era <era> [--run <run>] [--block-size <events>] [--prefilter-channels \"<c1> <c2>\"]");
+    std::size_t nBlock = blockSize != "" ? std::stoul(blockSize) : 10000;
+    if(nBlock == 0) throw std::runtime_error("Block size has to be at least one event: '--block-size " + blockSize + "'");
+    if(!filterChannels.empty() and (run == "" or run == "MC")) throw std::runtime_error("Trigger pre-filter is only possible for data, for MC all events enter the weight sums");
+
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+
+    //Cache triggers of all channels, so any channel can be skimmed from the cache
+    std::vector<std::string> triggerNames = Util::TriggerNames(skim, era), filterTriggers;
+    if(!filterChannels.empty()) filterTriggers = Util::TriggerNames(skim, era, filterChannels);
+
+    //Resolve all leaves exactly like the skimming does
+    NanoInput input(fileName, "Events");
+    input.SetTrigger(triggerNames, false);
+    input.SetTrigger(Util::GetVector<std::string>(skim, "Analyzer.METFilter." + era), true);
+
+    std::shared_ptr<TFile> inFile(TFile::Open(fileName.c_str(), "READ"));
+    TTree* tree = inFile->Get<TTree>("Events");
+
+    NanoCache::Build(tree, input.LeafNames(), filterTriggers, outFile, nBlock);
+}
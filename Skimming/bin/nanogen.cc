@@ -0,0 +1,50 @@
+#include <ChargedSkimming/Core/interface/nanogenerator.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Write a synthetic NanoAOD file with all branches read by NanoInput
+    std::string outFile = Util::ParseLine(argc, argv, "out-file");
+    std::string preset = Util::ParseLine(argc, argv, "preset");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string nEvents = Util::ParseLine(argc, argv, "n-events");
+    std::string seed = Util::ParseLine(argc, argv, "seed");
+    std::string nElectrons = Util::ParseLine(argc, argv, "electrons");
+    std::string nMuons = Util::ParseLine(argc, argv, "muons");
+    std::string nJets = Util::ParseLine(argc, argv, "jets");
+    std::string nFatJets = Util::ParseLine(argc, argv, "fatjets");
+    std::string triggerRate = Util::ParseLine(argc, argv, "trigger-rate");
+
+    if(outFile == "" or era == "") throw std::runtime_error("Usage: NanoGen --out-file <file> --era <era> [--preset ttbar|data] [--n-events <n>] [--seed <seed>] [--electrons <mean>] [--muons <mean>] [--jets <mean>] [--fatjets <mean>] [--trigger-rate <p>]");
+
+    NanoGenerator::Config config = NanoGenerator::Preset(preset != "" ? preset : "ttbar");
+
+    if(nEvents != "") config.nEvents = std::stoul(nEvents);
+    if(seed != "") config.seed = std::stoul(seed);
+    if(nElectrons != "") config.nElectrons = std::stof(nElectrons);
+    if(nMuons != "") config.nMuons = std::stof(nMuons);
+    if(nJets != "") config.nJets = std::stof(nJets);
+    if(nFatJets != "") config.nFatJets = std::stof(nFatJets);
+    if(triggerRate != "") config.triggerRate = std::stof(triggerRate);
+
+    //Triggers of all channels and the MET filters of the era
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+
+    config.triggers = Util::TriggerNames(skim, era);
+
+    config.METFilters = Util::GetVector<std::string>(skim, "Analyzer.METFilter." + era);
+
+    NanoGenerator generator(config);
+    generator.Write(outFile);
+}
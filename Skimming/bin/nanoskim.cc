@@ -1,66 +1,396 @@
 #include <ChargedSkimming/Core/interface/skimmer.h>
+#include <ChargedSkimming/Core/interface/augmenter.h>
 #include <ChargedSkimming/Core/interface/nanoinput.h>
 #include <ChargedSkimming/Core/interface/output.h>
+#include <ChargedSkimming/Core/interface/replayinput.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
 
 #include <vector>
 #include <string>
 #include <chrono>
+#include <queue>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
 
-std::string ParseLine(int argc, char* argv[], const std::string& name){
-    std::string result;
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <sys/socket.h>
 
-    for(int i = 0; i < argc; ++i){
-        std::string arg = std::string(argv[i]);
+#include <TROOT.h>
 
-        if(arg.size() > 2 and name == arg.substr(2)){
-            result = std::string(argv[i+1]);
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+//Skim the entries of a job (listed events or entry range), shared by direct and server jobs so both give the same cutflow
+std::size_t SkimEntries(NanoInput& input, Output& output, Skimmer<NanoInput>& skimmer, const pt::ptree& job, const std::shared_ptr<Tracer>& tracer = nullptr, const std::shared_ptr<SlowEventRecorder>& recorder = nullptr){
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+    //Events removed by the trigger pre-filter of the cache
+    if(input.PrefilteredEntries() != 0) skimmer.Skip(input.PrefilteredEntries());
+
+    //Either the listed events, which are looked up in the event index instead of scanning the file, or an optional entry range [first, last)
+    std::vector<std::size_t> entries;
+    std::string eventList = job.get<std::string>("event-list", "");
+
+    if(eventList != "") entries = input.EventListEntries(eventList, job.get<std::string>("event-index-dir", ""), job.get<std::string>("run", "") != "MC");
+
+    else{
+        std::size_t first = job.get<std::size_t>("first-entry", 0);
+        std::size_t last = std::min(job.get<std::size_t>("last-entry", input.GetEntries()), input.GetEntries());
+
+        for(std::size_t entry = first; entry < last; ++entry) entries.push_back(entry);
+    }
+
+    for(std::size_t i = 0; i < entries.size(); ++i){
+        //Zone map is only used for entry ranges, so skipped entries are consecutive
+        std::size_t next = input.ZoneMapEntry(entries[i]);
+
+        if(next != entries[i]){
+            std::size_t nSkip = std::min(next - entries[i], entries.size() - i);
+            skimmer.Skip(nSkip);
+            i += nSkip;
+
+            if(i >= entries.size()) break;
+        }
+
+        std::size_t entry = entries[i];
+
+        if(i % 10000 == 0 and i != 0){
+            std::cout << "Events analyzed: " << i  << " of " << entries.size() << " (" << float(i)/entries.size()*100 << " %) [" << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count() << " seconds]" << std::endl;
+        }
+
+        if(tracer) tracer->BeginEvent(entry);
+        if(recorder) recorder->BeginEvent(entry);
+
+        input.SetEntry(entry);
+        skimmer.Loop(input, output);
+    }
+
+    return entries.size();
+}
+
+//Skim of one file, jobs of the server mode share the loaded corrections of the process
+std::size_t RunJob(const pt::ptree& job){
+    std::string era = job.get<std::string>("era"), run = job.get<std::string>("run");
+
+    NanoInput input(job.get<std::string>("file-name"), "Events", job.get<std::string>("cache-file", ""));
+    Output output;
+
+    Skimmer<NanoInput> skimmer(Util::SplitString(job.get<std::string>("channels"), " "), job.get<std::string>("xSec", "1"), job.get<std::string>("xSecUnc", "0"), era, run);
+    skimmer.Configure(input, output, job.get<std::string>("out-dir"), job.get<std::string>("out-file"));
+
+    //Event set is mapped once and shared by all jobs
+    std::string dedupSet = job.get<std::string>("dedup-set", "");
+    if(dedupSet != "") skimmer.SetDedupSet(CorrectionCache::Get<EventSet>("EventSet/" + dedupSet, [&](){return std::make_shared<EventSet>(dedupSet);}));
+
+    std::size_t nEvents = SkimEntries(input, output, skimmer, job);
+    skimmer.WriteOutput();
+
+    return nEvents;
+}
+
+//Open a listening/connected unix domain socket
+int OpenSocket(const std::string& path, const bool& listen){
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) throw std::runtime_error("Could not create socket: '" + path + "'");
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path too long: '" + path + "'");
+    std::copy(path.begin(), path.end(), address.sun_path);
+
+    if(listen){
+        unlink(path.c_str());
+
+        if(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 or ::listen(fd, 64) < 0){
+            throw std::runtime_error("Could not listen on socket: '" + path + "'");
+        }
+    }
+
+    else if(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0){
+        throw std::runtime_error("Could not connect to socket: '" + path + "'");
+    }
+
+    return fd;
+}
+
+//Messages are single lines of JSON
+std::string ReadMessage(const int& fd){
+    std::string message;
+    char c;
+
+    while(read(fd, &c, 1) == 1 and c != '\n') message += c;
+
+    return message;
+}
+
+void WriteMessage(const int& fd, const pt::ptree& message){
+    std::stringstream stream;
+    pt::write_json(stream, message, false);
+    std::string line = stream.str();
+    if(line.empty() or line.back() != '\n') line += '\n';
+
+    for(std::size_t written = 0; written < line.size();){
+        //Client may have disconnected, which must not kill the process with SIGPIPE
+        ssize_t n = send(fd, line.data() + written, line.size() - written, MSG_NOSIGNAL);
+        if(n <= 0) break;
+        written += n;
+    }
+}
+
+//Accept skim jobs on the socket and run them on a pool of worker threads until a stop command is received
+void Serve(const std::string& path, const std::size_t& nWorkers){
+    ROOT::EnableThreadSafety();
+
+    int server = OpenSocket(path, true);
+    std::cout << "NanoSkim server listening on " << path << " with " << nWorkers << " workers" << std::endl;
+
+    std::queue<int> connections;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stop = false;
+
+    std::function<void()> work = [&](){
+        while(true){
+            int fd;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [&](){return stop or !connections.empty();});
+                if(connections.empty()) return;
+
+                fd = connections.front();
+                connections.pop();
+            }
+
+            //First line is either the STOP command or a skim job
+            std::string message = ReadMessage(fd);
+
+            if(message == "STOP"){
+                pt::ptree reply;
+                reply.put("Status", "Stopped");
+                WriteMessage(fd, reply);
+                close(fd);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                }
+
+                //Wake up the accept loop, queued jobs are still finished by the workers
+                shutdown(server, SHUT_RDWR);
+                condition.notify_all();
+
+                continue;
+            }
+
+            pt::ptree job, reply;
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+
+            try{
+                std::stringstream stream(message);
+                pt::read_json(stream, job);
+
+                std::size_t nEvents = RunJob(job);
+
+                reply.put("Status", "OK");
+                reply.put("Events", nEvents);
+            }
+
+            catch(const std::exception& e){
+                reply.put("Status", "Error");
+                reply.put("Message", e.what());
+            }
+
+            reply.put("Seconds", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()/1e3);
+            std::cout << "Job finished: " << job.get<std::string>("file-name", "") << " (" << reply.get<std::string>("Status") << ", " << reply.get<std::string>("Seconds") << " s)" << std::endl;
+
+            WriteMessage(fd, reply);
+            close(fd);
         }
+    };
+
+    std::vector<std::thread> workers;
+    for(std::size_t i = 0; i < nWorkers; ++i) workers.push_back(std::thread(work));
+
+    while(true){
+        int fd = accept(server, nullptr, nullptr);
+
+        if(fd < 0){
+            std::lock_guard<std::mutex> lock(mutex);
+            if(stop) break;
+
+            continue;
+        }
+
+        //Messages are read by the workers, a client which sends nothing only blocks a worker until the timeout
+        timeval timeout{30, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            connections.push(fd);
+        }
+
+        condition.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
     }
 
-    return result;
+    condition.notify_all();
+    for(std::thread& worker : workers) worker.join();
+
+    //Connections accepted while the server was stopped
+    while(!connections.empty()){
+        close(connections.front());
+        connections.pop();
+    }
+
+    close(server);
+    unlink(path.c_str());
+
+    std::cout << "NanoSkim server stopped" << std::endl;
 }
 
-std::vector<std::string> SplitString(const std::string& splitString, const std::string& delimeter){
-    //Function which handles splitting of string input
-    std::vector<std::string> splittedString;
-    std::string string;
-    std::istringstream splittedStream(splitString);
-    while (std::getline(splittedStream, string, delimeter.c_str()[0])){
-        splittedString.push_back(string);
+//Send a job (or the STOP command) to a running server and wait for the reply
+int Submit(const std::string& path, const pt::ptree& job, const bool& stop){
+    int fd = OpenSocket(path, false);
+
+    if(stop){
+        std::string command = "STOP\n";
+        if(send(fd, command.data(), command.size(), MSG_NOSIGNAL) < 0) throw std::runtime_error("Could not send to socket: '" + path + "'");
     }
 
-    return splittedString;
+    else WriteMessage(fd, job);
+
+    std::stringstream stream(ReadMessage(fd));
+    close(fd);
+
+    pt::ptree reply;
+    pt::read_json(stream, reply);
+    pt::write_json(std::cout, reply);
+
+    return reply.get<std::string>("Status") == "Error";
 }
 
 int main(int argc, char* argv[]){
     //Extract informations of command line
-    std::string fileName = ParseLine(argc, argv, "file-name");
-    std::string outDir = ParseLine(argc, argv, "out-dir");
-    std::string outFile = ParseLine(argc, argv, "out-file");
-    std::string run = ParseLine(argc, argv, "run");
-    std::string era = ParseLine(argc, argv, "era");
-    std::string xSec = ParseLine(argc, argv, "xSec");
-    std::string xSecUnc = ParseLine(argc, argv, "xSecUnc");
-    std::vector<std::string> channels = SplitString(ParseLine(argc, argv, "channels"), " ");
+    std::string fileName = Util::ParseLine(argc, argv, "file-name");
+    std::string outDir = Util::ParseLine(argc, argv, "out-dir");
+    std::string outFile = Util::ParseLine(argc, argv, "out-file");
+    std::string run = Util::ParseLine(argc, argv, "run");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string xSec = Util::ParseLine(argc, argv, "xSec");
+    std::string xSecUnc = Util::ParseLine(argc, argv, "xSecUnc");
+    std::vector<std::string> channels = Util::SplitString(Util::ParseLine(argc, argv, "channels"), " ");
+    std::string zoneMapDir = Util::ParseLine(argc, argv, "zone-map-dir");
+    std::string cacheFile = Util::ParseLine(argc, argv, "cache-file");
+    std::vector<std::string> augment = Util::SplitString(Util::ParseLine(argc, argv, "augment"), " ");
+    std::vector<std::string> branches = Util::SplitString(Util::ParseLine(argc, argv, "branches"), " ");
+    std::string timingReport = Util::ParseLine(argc, argv, "timing-report");
+    std::string traceFile = Util::ParseLine(argc, argv, "trace-file");
+    std::string traceSample = Util::ParseLine(argc, argv, "trace-sample");
+    std::string ioReport = Util::ParseLine(argc, argv, "io-report");
+    std::string perfReport = Util::ParseLine(argc, argv, "perf-counters");
+    std::string slowReport = Util::ParseLine(argc, argv, "slow-events");
+    std::string slowThreshold = Util::ParseLine(argc, argv, "slow-threshold");
+    std::string slowTop = Util::ParseLine(argc, argv, "slow-top");
+    std::string slowReplay = Util::ParseLine(argc, argv, "slow-replay");
+    std::string serveSocket = Util::ParseLine(argc, argv, "serve");
+    std::string workers = Util::ParseLine(argc, argv, "workers");
+    std::string submitSocket = Util::ParseLine(argc, argv, "submit");
+    std::string dedupSet = Util::ParseLine(argc, argv, "dedup-set");
+    std::string eventList = Util::ParseLine(argc, argv, "event-list");
 
-    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    //Long running server, which keeps configs and corrections loaded between jobs
+    if(serveSocket != ""){
+        Serve(serveSocket, workers != "" ? std::stoul(workers) : std::max(1u, std::thread::hardware_concurrency()));
+        return 0;
+    }
+
+    //Job options, which are the same for a direct run and a run on a server
+    pt::ptree job;
+
+    for(const std::string& option : {"file-name", "out-dir", "out-file", "run", "era", "xSec", "xSecUnc", "channels", "cache-file", "first-entry", "last-entry", "dedup-set", "event-list", "event-index-dir"}){
+        std::string value = Util::ParseLine(argc, argv, option);
+        if(value != "") job.put(option, value);
+    }
+
+    //Run this job on a server instead ('--submit <socket> --stop' shuts the server down)
+    if(submitSocket != ""){
+        return Submit(submitSocket, job, std::find(argv, argv + argc, std::string("--stop")) != argv + argc);
+    }
+
+    //Rerun analyzers on existing skims (file name with [C] placeholder) and write new branches into friend trees
+    if(!augment.empty()){
+        if(branches.empty()) branches = {"*"};
 
-    NanoInput input(fileName, "Events");
+        Augmenter augmenter(channels, era, run, augment, branches);
+        augmenter.Run(fileName, outDir, outFile);
+
+        return 0;
+    }
+
+    //Output trees filled on a writer thread need a thread safe ROOT before the input file is opened
+    if(Skimmer<NanoInput>::ReadConfig("skim.json").get<std::size_t>("Output.AsyncSnapshots", 0) != 0) ROOT::EnableThreadSafety();
+
+    NanoInput input(fileName, "Events", cacheFile);
     Output output;
 
     Skimmer<NanoInput> skimmer(channels, xSec, xSecUnc, era, run);
     skimmer.Configure(input, output, outDir, outFile);
-  
-    for(std::size_t entry = 0; entry < input.GetEntries(); ++entry){
-        if(entry % 10000 == 0 and entry != 0){
-            std::cout << "Events analyzed: " << entry  << " of " << input.GetEntries() << " (" << float(entry)/input.GetEntries()*100 << " %) [" << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count() << " seconds]" << std::endl;
-        }
+    skimmer.SetTimingReport(timingReport);
+    if(dedupSet != "") skimmer.SetDedupSet(std::make_shared<EventSet>(dedupSet));
+    if(perfReport != "") skimmer.SetPerfCounters(perfReport);
 
-        input.SetEntry(entry);
-        skimmer.Loop(input, output);
+    //Chrome trace event timeline of every N. event
+    std::shared_ptr<Tracer> tracer;
+
+    if(traceFile != ""){
+        tracer = std::make_shared<Tracer>(traceSample != "" ? std::stoul(traceSample) : 1000);
+        skimmer.SetTracer(tracer, input);
+    }
+
+    //Entries and stage times of events above the threshold (in ms) and of the top-k slowest events
+    std::shared_ptr<SlowEventRecorder> recorder;
+
+    if(slowReport != "" or slowReplay != ""){
+        recorder = std::make_shared<SlowEventRecorder>(slowThreshold != "" ? std::stod(slowThreshold)*1e6 : 0, slowTop != "" ? std::stoul(slowTop) : 20);
+        skimmer.SetSlowEventRecorder(recorder);
+    }
+
+    //Read cost per input leaf
+    if(ioReport != "") input.EnableIOReport();
+
+    //Skipping clusters is only safe for data, for MC every event enters the weight sums
+    if(zoneMapDir != "" and eventList == ""){
+        if(run != "MC") input.SetZoneMap(zoneMapDir, skimmer.ZoneRequirements());
+        else std::cout << "Zone map is not used for MC, all events are analyzed" << std::endl;
     }
+
+    SkimEntries(input, output, skimmer, job, tracer, recorder);
    
+    input.WriteZoneMap();
     skimmer.WriteOutput();
+
+    if(tracer) tracer->Write(traceFile);
+    if(ioReport != "") input.WriteIOReport(ioReport);
+
+    if(recorder){
+        recorder->Print();
+        if(slowReport != "") recorder->WriteReport(slowReport);
+
+        //Slow events as input for AnalyzerBench
+        if(slowReplay != "") ReplayInput::Capture(input, recorder->Entries(), run != "MC", slowReplay);
+    }
 }
 
 
@@ -0,0 +1,89 @@
+#include <ChargedSkimming/Core/interface/ioprofile.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <experimental/filesystem>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Rewrite an existing skim output tree with each output profile and report write throughput/file size
+    std::string fileName = Util::ParseLine(argc, argv, "file-name");
+    std::string treeName = Util::ParseLine(argc, argv, "tree");
+    std::string outDir = Util::ParseLine(argc, argv, "out-dir");
+    std::vector<std::string> profiles = Util::SplitString(Util::ParseLine(argc, argv, "profiles"), " ");
+
+    if(fileName == "" or treeName == "") throw std::runtime_error("Usage: OutputBench --file-name <skim file> --tree <channel> [--out-dir <dir>] [--profiles \"<p1> <p2>\"]");
+    if(outDir == "") outDir = "/tmp/OutputBench";
+    std::experimental::filesystem::create_directories(outDir);
+
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+
+    if(profiles.empty()) profiles = Util::GetKeys(skim, "Output.Profiles");
+
+    std::cout << std::left << std::setw(15) << "Profile" << std::setw(12) << "Events" << std::setw(14) << "Read [s]" << std::setw(14) << "Write [s]" << std::setw(14) << "Events/s" << std::setw(14) << "MB/s (raw)" << std::setw(14) << "Size [MB]" << "Ratio" << std::endl;
+
+    for(const std::string& name : profiles){
+        IOProfile profile(skim, name);
+
+        std::shared_ptr<TFile> inFile(TFile::Open(fileName.c_str(), "READ"));
+        if(!inFile or inFile->IsZombie()) throw std::runtime_error("Could not open file: '" + fileName + "'");
+
+        TTree* inTree = inFile->Get<TTree>(treeName.c_str());
+        if(!inTree) throw std::runtime_error("Tree '" + treeName + "' not found in file: '" + fileName + "'");
+
+        std::string outName = outDir + "/" + name + ".root";
+        std::shared_ptr<TFile> outFile = std::make_shared<TFile>(outName.c_str(), "RECREATE");
+
+        std::shared_ptr<TTree> outTree(inTree->CloneTree(0));
+        outTree->SetDirectory(outFile.get());
+
+        profile.Apply(outTree.get());
+        profile.SetAutoFlush({outTree});
+
+        //Baskets are loaded first, so no disk access is timed, but they stay compressed,
+        //so GetEntry (decompression) and Fill/Write (compression) are timed separately
+        inTree->LoadBaskets();
+
+        std::chrono::steady_clock::duration readTime{0}, writeTime{0};
+
+        for(long long entry = 0; entry < inTree->GetEntries(); ++entry){
+            std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+            inTree->GetEntry(entry);
+
+            std::chrono::time_point<std::chrono::steady_clock> read = std::chrono::steady_clock::now();
+            outTree->Fill();
+
+            readTime += read - start;
+            writeTime += std::chrono::steady_clock::now() - read;
+        }
+
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        outFile->cd();
+        outTree->Write();
+        writeTime += std::chrono::steady_clock::now() - start;
+
+        float readSeconds = std::chrono::duration<float>(readTime).count(), seconds = std::chrono::duration<float>(writeTime).count();
+        long long nEvents = outTree->GetEntries(), rawBytes = outTree->GetTotBytes(), zipBytes = outTree->GetZipBytes();
+
+        outTree.reset();
+        outFile->Close();
+
+        float size = std::experimental::filesystem::file_size(outName)/1e6;
+
+        std::cout << std::left << std::setw(15) << name << std::setw(12) << nEvents << std::setw(14) << readSeconds << std::setw(14) << seconds << std::setw(14) << nEvents/seconds << std::setw(14) << rawBytes/1e6/seconds << std::setw(14) << size << float(rawBytes)/zipBytes << std::endl;
+    }
+}
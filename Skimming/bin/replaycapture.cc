@@ -0,0 +1,37 @@
+#include <ChargedSkimming/Core/interface/replayinput.h>
+#include <ChargedSkimming/Core/interface/nanoinput.h>
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+int main(int argc, char* argv[]){
+    //Capture the input state of the first events of a NanoAOD file for AnalyzerBench
+    std::string fileName = Util::ParseLine(argc, argv, "file-name");
+    std::string outFile = Util::ParseLine(argc, argv, "out-file");
+    std::string era = Util::ParseLine(argc, argv, "era");
+    std::string run = Util::ParseLine(argc, argv, "run");
+    std::string nEvents = Util::ParseLine(argc, argv, "n-events");
+
+    if(fileName == "" or outFile == "" or era == "" or run == "") throw std::runtime_error("Usage: ReplayCapture --file-name <NanoAOD file> --out-file <replay file> --era <era> --run <run> [--n-events <n>]");
+
+    pt::ptree skim;
+    pt::read_json(std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/skim.json", skim);
+
+    //Triggers of all channels, so any channel selection can be replayed
+    std::vector<std::string> triggerNames = Util::TriggerNames(skim, era);
+
+    NanoInput input(fileName, "Events");
+    input.SetTrigger(triggerNames, false);
+    input.SetTrigger(Util::GetVector<std::string>(skim, "Analyzer.METFilter." + era), true);
+
+    ReplayInput::Capture(input, nEvents != "" ? std::stoul(nEvents) : 5000, run != "MC", outFile);
+}
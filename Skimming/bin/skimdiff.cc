@@ -0,0 +1,309 @@
+#include <ChargedSkimming/Skimming/interface/util.h>
+
+#include <map>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <memory>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TLeaf.h>
+#include <TKey.h>
+#include <TList.h>
+#include <TObjArray.h>
+#include <TH1.h>
+#include <TH1D.h>
+#include <TParameter.h>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+namespace pt = boost::property_tree;
+
+struct Tolerance {
+    double abs = 0, rel = 0;
+    bool ignore = false;
+
+    bool Close(const double& ref, const double& val) const {
+        if(std::isnan(ref) or std::isnan(val)) return std::isnan(ref) and std::isnan(val);
+        return std::abs(val - ref) <= abs + rel*std::abs(ref);
+    }
+};
+
+class Tolerances {
+    private:
+        std::vector<std::pair<std::vector<std::string>, Tolerance>> groups;
+        Tolerance branchDefault, histogramDefault, parameterDefault;
+
+        static Tolerance Read(const pt::ptree& node){
+            Tolerance t;
+            t.abs = node.get<double>("abs", 0);
+            t.rel = node.get<double>("rel", 0);
+            t.ignore = node.get<bool>("ignore", false);
+
+            return t;
+        }
+
+    public:
+        Tolerances(const pt::ptree& config){
+            branchDefault = Read(config.get_child("Default"));
+            histogramDefault = Read(config.get_child("Histograms"));
+            parameterDefault = Read(config.get_child("Parameters"));
+
+            for(const std::pair<const std::string, pt::ptree>& group : config.get_child("Branches")){
+                groups.push_back({Util::GetVector<std::string>(group.second, "patterns"), Read(group.second)});
+            }
+        }
+
+        //First group with a matching pattern, otherwise the default of the object type
+        const Tolerance& Get(const std::string& name, const std::string& type = "Branch") const {
+            for(const std::pair<std::vector<std::string>, Tolerance>& group : groups){
+                for(const std::string& pattern : group.first){
+                    if(Util::MatchGlob(pattern, name)) return group.second;
+                }
+            }
+
+            return type == "Histogram" ? histogramDefault : type == "Parameter" ? parameterDefault : branchDefault;
+        }
+};
+
+//Number of differences of one branch/object and distribution of the relative differences
+struct Difference {
+    long long nCompared = 0, nDiffering = 0;
+    double maxAbs = 0;
+    std::shared_ptr<TH1D> relative;
+};
+
+void Record(std::map<std::string, Difference>& differences, const std::string& name, const double& ref, const double& val, const bool& close){
+    Difference& d = differences[name];
+    ++d.nCompared;
+
+    if(close) return;
+    ++d.nDiffering;
+    d.maxAbs = std::max(d.maxAbs, std::abs(val - ref));
+
+    if(!d.relative){
+        d.relative = std::make_shared<TH1D>(("Diff_" + name).c_str(), ("Diff_" + name).c_str(), 200, -1, 1);
+        d.relative->SetDirectory(nullptr);
+    }
+
+    d.relative->Fill(ref != 0 ? (val - ref)/std::abs(ref) : (val > 0 ? 1 : -1));
+}
+
+//Entry of each (run, event) of the tree, event numbers alone repeat across runs
+bool EventEntries(TTree* tree, std::map<std::pair<std::uint32_t, std::uint64_t>, long long>& entries){
+    TLeaf* run = tree->GetLeaf("Misc_run");
+    TLeaf* event = tree->GetLeaf("Misc_eventNumber");
+    bool unique = true;
+
+    for(long long entry = 0; entry < tree->GetEntries(); ++entry){
+        run->GetBranch()->GetEntry(entry);
+        event->GetBranch()->GetEntry(entry);
+
+        unique &= entries.insert({{run->GetTypedValue<std::uint32_t>(), event->GetTypedValue<std::uint64_t>()}, entry}).second;
+    }
+
+    return unique;
+}
+
+//Compare all leaves of the trees event by event, events are matched by run and event number
+void CompareTree(TTree* refTree, TTree* newTree, const Tolerances& tolerances, std::map<std::string, Difference>& differences, std::vector<std::string>& problems){
+    std::string treeName = refTree->GetName();
+
+    for(TTree* tree : {refTree, newTree}){
+        if(tree->GetLeaf("Misc_run") == nullptr or tree->GetLeaf("Misc_eventNumber") == nullptr){
+            problems.push_back(treeName + ": no Misc_run/Misc_eventNumber, trees can not be matched");
+            return;
+        }
+    }
+
+    std::map<std::pair<std::uint32_t, std::uint64_t>, long long> refEntries, newEntries;
+    bool refUnique = EventEntries(refTree, refEntries), newUnique = EventEntries(newTree, newEntries);
+
+    if(!refUnique or !newUnique){
+        problems.push_back(treeName + ": duplicated (run, event) in " + (refUnique ? "new file" : "reference") + ", trees can not be matched");
+        return;
+    }
+
+    std::vector<std::pair<TLeaf*, TLeaf*>> leaves;
+    TObjArray* refLeaves = refTree->GetListOfLeaves();
+
+    for(int i = 0; i < refLeaves->GetEntries(); ++i){
+        TLeaf* refLeaf = static_cast<TLeaf*>(refLeaves->At(i));
+        if(tolerances.Get(refLeaf->GetName()).ignore) continue;
+
+        TLeaf* newLeaf = newTree->GetLeaf(refLeaf->GetName());
+        if(newLeaf == nullptr) problems.push_back(treeName + ": branch only in reference: " + refLeaf->GetName());
+        else leaves.push_back({refLeaf, newLeaf});
+    }
+
+    TObjArray* newLeaves = newTree->GetListOfLeaves();
+
+    for(int i = 0; i < newLeaves->GetEntries(); ++i){
+        std::string name = newLeaves->At(i)->GetName();
+        if(!tolerances.Get(name).ignore and refTree->GetLeaf(name.c_str()) == nullptr) problems.push_back(treeName + ": branch only in new file: " + name);
+    }
+
+    long long nMissing = 0, nMatched = 0;
+
+    for(const std::pair<const std::pair<std::uint32_t, std::uint64_t>, long long>& ref : refEntries){
+        std::map<std::pair<std::uint32_t, std::uint64_t>, long long>::const_iterator match = newEntries.find(ref.first);
+        if(match == newEntries.end()){
+            ++nMissing;
+            continue;
+        }
+
+        refTree->GetEntry(ref.second);
+        newTree->GetEntry(match->second);
+        ++nMatched;
+
+        for(const std::pair<TLeaf*, TLeaf*>& leaf : leaves){
+            std::string name = treeName + "_" + leaf.first->GetName();
+            const Tolerance& tolerance = tolerances.Get(leaf.first->GetName());
+
+            int refLen = leaf.first->GetLen(), newLen = leaf.second->GetLen();
+
+            //Different number of objects counts as one difference of the branch
+            if(refLen != newLen){
+                Record(differences, name, refLen, newLen, false);
+                continue;
+            }
+
+            for(int i = 0; i < refLen; ++i){
+                double ref = leaf.first->GetValue(i), val = leaf.second->GetValue(i);
+                Record(differences, name, ref, val, tolerance.Close(ref, val));
+            }
+        }
+    }
+
+    if(nMissing != 0) problems.push_back(treeName + ": " + std::to_string(nMissing) + " events only in reference");
+    if(newTree->GetEntries() != nMatched) problems.push_back(treeName + ": " + std::to_string(newTree->GetEntries() - nMatched) + " events only in new file");
+
+    std::cout << "Compared tree: " << treeName << " (" << nMatched << " matched events, " << leaves.size() << " branches)" << std::endl;
+}
+
+void CompareHistogram(TH1* ref, TH1* val, const Tolerances& tolerances, std::map<std::string, Difference>& differences, std::vector<std::string>& problems){
+    std::string name = ref->GetName();
+
+    if(ref->GetNbinsX() != val->GetNbinsX()){
+        problems.push_back(name + ": different number of bins");
+        return;
+    }
+
+    const Tolerance& tolerance = tolerances.Get(name, "Histogram");
+
+    //Including under/overflow
+    for(int i = 0; i <= ref->GetNbinsX() + 1; ++i){
+        Record(differences, name, ref->GetBinContent(i), val->GetBinContent(i), tolerance.Close(ref->GetBinContent(i), val->GetBinContent(i)));
+    }
+}
+
+template <typename P>
+bool CompareParameter(TObject* ref, TObject* val, const Tolerances& tolerances, std::map<std::string, Difference>& differences){
+    P* refPar = dynamic_cast<P*>(ref);
+    P* valPar = dynamic_cast<P*>(val);
+    if(refPar == nullptr or valPar == nullptr) return false;
+
+    Record(differences, refPar->GetName(), refPar->GetVal(), valPar->GetVal(), tolerances.Get(refPar->GetName(), "Parameter").Close(refPar->GetVal(), valPar->GetVal()));
+
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    //Compare two skim outputs tree by tree, event by event, and their histograms/parameters
+    std::string refName = Util::ParseLine(argc, argv, "ref-file");
+    std::string newName = Util::ParseLine(argc, argv, "new-file");
+    std::string config = Util::ParseLine(argc, argv, "tolerances");
+    std::string outName = Util::ParseLine(argc, argv, "out-file");
+
+    if(refName == "" or newName == "") throw std::runtime_error("Usage: SkimDiff --ref-file <skim file> --new-file <skim file> [--tolerances <json>] [--out-file <root file with difference histograms>]");
+    if(config == "") config = std::string(std::getenv("CMSSW_BASE")) + "/src/ChargedSkimming/Skimming/data/config/UL/diff.json";
+
+    pt::ptree diff;
+    pt::read_json(config, diff);
+    Tolerances tolerances(diff);
+
+    std::shared_ptr<TFile> refFile(TFile::Open(refName.c_str(), "READ"));
+    std::shared_ptr<TFile> newFile(TFile::Open(newName.c_str(), "READ"));
+    if(!refFile or refFile->IsZombie()) throw std::runtime_error("Could not open file: '" + refName + "'");
+    if(!newFile or newFile->IsZombie()) throw std::runtime_error("Could not open file: '" + newName + "'");
+
+    std::map<std::string, Difference> differences;
+    std::vector<std::string> problems, compared;
+
+    TList* keys = refFile->GetListOfKeys();
+
+    for(int i = 0; i < keys->GetEntries(); ++i){
+        TKey* key = static_cast<TKey*>(keys->At(i));
+        std::string name = key->GetName();
+
+        //Keys are sorted by cycle, only the newest cycle is compared
+        if(std::find(compared.begin(), compared.end(), name) != compared.end()) continue;
+        compared.push_back(name);
+
+        if(tolerances.Get(name, "Histogram").ignore) continue;
+
+        TObject* ref = key->ReadObj();
+        TObject* val = newFile->Get(name.c_str());
+
+        if(val == nullptr){
+            problems.push_back(name + ": only in reference");
+            continue;
+        }
+
+        if(dynamic_cast<TTree*>(ref) != nullptr and dynamic_cast<TTree*>(val) != nullptr) CompareTree(static_cast<TTree*>(ref), static_cast<TTree*>(val), tolerances, differences, problems);
+        else if(dynamic_cast<TH1*>(ref) != nullptr and dynamic_cast<TH1*>(val) != nullptr) CompareHistogram(static_cast<TH1*>(ref), static_cast<TH1*>(val), tolerances, differences, problems);
+        else if(CompareParameter<TParameter<float>>(ref, val, tolerances, differences)) continue;
+        else if(CompareParameter<TParameter<double>>(ref, val, tolerances, differences)) continue;
+        else if(CompareParameter<TParameter<int>>(ref, val, tolerances, differences)) continue;
+        else std::cout << "Not compared: " << name << " (" << key->GetClassName() << ")" << std::endl;
+    }
+
+    TList* newKeys = newFile->GetListOfKeys();
+
+    for(int i = 0; i < newKeys->GetEntries(); ++i){
+        std::string name = newKeys->At(i)->GetName();
+        if(!tolerances.Get(name, "Histogram").ignore and refFile->Get(name.c_str()) == nullptr) problems.push_back(name + ": only in new file");
+    }
+
+    //Summary of all compared quantities with differences
+    long long nDiffering = 0;
+    std::shared_ptr<TH1D> summary = std::make_shared<TH1D>("DiffSummary", "DiffSummary", 1, 0, 1);
+    summary->SetDirectory(nullptr);
+
+    std::cout << std::left << std::setw(50) << "Quantity" << std::setw(14) << "Compared" << std::setw(14) << "Differing" << "Max abs. diff." << std::endl;
+
+    for(const std::pair<const std::string, Difference>& d : differences){
+        if(d.second.nDiffering == 0) continue;
+
+        nDiffering += d.second.nDiffering;
+        summary->Fill(d.first.c_str(), d.second.nDiffering);
+
+        std::cout << std::left << std::setw(50) << d.first << std::setw(14) << d.second.nCompared << std::setw(14) << d.second.nDiffering << d.second.maxAbs << std::endl;
+    }
+
+    for(const std::string& problem : problems) std::cout << "Mismatch: " << problem << std::endl;
+
+    if(outName != ""){
+        std::shared_ptr<TFile> outFile = std::make_shared<TFile>(outName.c_str(), "RECREATE");
+        summary->Write();
+
+        for(const std::pair<const std::string, Difference>& d : differences){
+            if(d.second.relative) d.second.relative->Write();
+        }
+
+        outFile->Close();
+        std::cout << "Written difference histograms: " << outName << std::endl;
+    }
+
+    bool identical = nDiffering == 0 and problems.empty();
+    std::cout << (identical ? "Outputs agree within tolerances" : "Outputs differ: " + std::to_string(nDiffering) + " differing values, " + std::to_string(problems.size()) + " structural mismatches") << std::endl;
+
+    return identical ? 0 : 1;
+}
@@ -1,6 +1,23 @@
 #ifndef UTIL_H
 #define UTIL_H
 
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <system_error>
+#include <experimental/filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
@@ -16,7 +33,7 @@ namespace Util{
         return vec;
     };
 
-    std::vector<std::string> GetKeys(const boost::property_tree::ptree& tree, const std::string path){
+    inline std::vector<std::string> GetKeys(const boost::property_tree::ptree& tree, const std::string path){
         std::vector<std::string> keys;
         boost::property_tree::ptree node = tree.get_child(path);
 
@@ -27,9 +44,157 @@ namespace Util{
         return keys;
     }
 
-    float DeltaR(const float& eta1, const float& phi1, const float& eta2, const float& phi2){
+    //Trigger names of the channels (all channels if none are given) in channel order, each name once
+    inline std::vector<std::string> TriggerNames(const boost::property_tree::ptree& skim, const std::string& era, const std::vector<std::string>& channels = {}){
+        std::vector<std::string> names;
+
+        for(const std::string& channel : channels.empty() ? GetKeys(skim, "Channel") : channels){
+            for(const std::string& name : GetVector<std::string>(skim, "Channel." + channel + ".Trigger." + era)){
+                if(std::find(names.begin(), names.end(), name) == names.end()) names.push_back(name);
+            }
+        }
+
+        return names;
+    }
+
+    inline float DeltaR(const float& eta1, const float& phi1, const float& eta2, const float& phi2){
         return std::sqrt(std::pow(eta1 - eta2, 2) + std::pow(phi1 - phi2, 2));
     }
+
+    //Value of the command line option "--<name> <value>", empty if not given
+    inline std::string ParseLine(int argc, char* argv[], const std::string& name){
+        std::string result;
+
+        for(int i = 0; i < argc - 1; ++i){
+            std::string arg = std::string(argv[i]);
+
+            if(arg.size() > 2 and name == arg.substr(2)){
+                result = std::string(argv[i+1]);
+            }
+        }
+
+        return result;
+    }
+
+    //Function which handles splitting of string input
+    inline std::vector<std::string> SplitString(const std::string& splitString, const std::string& delimeter){
+        std::vector<std::string> splittedString;
+        std::string string;
+        std::istringstream splittedStream(splitString);
+
+        while (std::getline(splittedStream, string, delimeter.c_str()[0])){
+            splittedString.push_back(string);
+        }
+
+        return splittedString;
+    }
+
+    //Glob matching with '*' (any sequence) and '?' (any character)
+    inline bool MatchGlob(const std::string& pattern, const std::string& name){
+        std::size_t p = 0, n = 0, star = std::string::npos, mark = 0;
+
+        while(n < name.size()){
+            if(p < pattern.size() and (pattern[p] == '?' or pattern[p] == name[n])){
+                ++p; ++n;
+            }
+
+            else if(p < pattern.size() and pattern[p] == '*'){
+                star = p++;
+                mark = n;
+            }
+
+            else if(star != std::string::npos){
+                p = star + 1;
+                n = ++mark;
+            }
+
+            else return false;
+        }
+
+        while(p < pattern.size() and pattern[p] == '*') ++p;
+
+        return p == pattern.size();
+    }
+
+    //FNV-1a hash, which (unlike std::hash) is the same for every toolchain, so it can be used to name cached files
+    inline std::uint64_t Hash(const char* bytes, const std::size_t& n, std::uint64_t hash = 14695981039346656037ULL){
+        for(std::size_t i = 0; i < n; ++i){
+            hash ^= static_cast<unsigned char>(bytes[i]);
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+    inline std::string HashName(const std::uint64_t& hash){
+        std::stringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+        return name.str();
+    }
+
+    //Let write fill a temporary file, which is then renamed, so concurrent jobs never read a half written file
+    inline void WriteAtomic(const std::string& fileName, const std::function<void(const std::string&)>& write){
+        std::experimental::filesystem::path parent = std::experimental::filesystem::path(fileName).parent_path();
+        if(!parent.empty()) std::experimental::filesystem::create_directories(parent);
+
+        std::string tmp = fileName + "." + std::to_string(::getpid()) + ".tmp";
+
+        try {
+            write(tmp);
+            std::experimental::filesystem::rename(tmp, fileName);
+        }
+
+        catch(...){
+            std::error_code error;
+            std::experimental::filesystem::remove(tmp, error);
+            throw;
+        }
+    }
+
+    //Read-only memory mapping of a whole file, the destructor unmaps and closes it (also if the owner's constructor throws afterwards)
+    class MappedFile {
+        private:
+            int fd = -1;
+            char* data = nullptr;
+            std::size_t size = 0;
+
+        public:
+            //What describes the file in the error messages (e.g. "cache file")
+            MappedFile(const std::string& fileName, const std::string& what){
+                fd = open(fileName.c_str(), O_RDONLY);
+                if(fd < 0) throw std::runtime_error("Could not open " + what + ": '" + fileName + "'");
+
+                struct stat info;
+                if(fstat(fd, &info) != 0){
+                    close(fd);
+                    throw std::runtime_error("Could not stat " + what + ": '" + fileName + "'");
+                }
+
+                size = info.st_size;
+                if(size == 0) return;
+
+                void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+                if(mapped == MAP_FAILED){
+                    close(fd);
+                    throw std::runtime_error("Could not memory-map " + what + ": '" + fileName + "'");
+                }
+
+                data = static_cast<char*>(mapped);
+            }
+
+            ~MappedFile(){
+                if(data != nullptr) munmap(data, size);
+                if(fd >= 0) close(fd);
+            }
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            char* Data() const {return data;}
+            std::size_t Size() const {return size;}
+    };
 };
 
 #endif
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+
+import os
+import json
+import sys
+import shutil
+import argparse
+import subprocess
+
+#Regression check of the skim output for a CI job, which is not part of this repository.
+#The job has to run in a CMSSW environment with the bins built, a non zero exit code marks a difference:
+#  skimDiffCI.py --ref-dir <ref> --update   (on the base branch)
+#  skimDiffCI.py --ref-dir <ref>            (on the change)
+
+def parser():
+    parser = argparse.ArgumentParser(description = "Skim the synthetic benchmark sample and compare the output to a reference skim with SkimDiff")
+    parser.add_argument("--work-dir", type = str, default = "/tmp/SkimDiffCI", help = "Directory for the synthetic sample and the skim outputs")
+    parser.add_argument("--ref-dir", type = str, required = True, help = "Directory with the reference skim (e.g. produced from the base branch with --update)")
+    parser.add_argument("--era", type = str, default = "2018")
+    parser.add_argument("--preset", type = str, default = "ttbar", choices = ["ttbar", "data"])
+    parser.add_argument("--n-events", type = int, default = 5000)
+    parser.add_argument("--seed", type = int, default = 42)
+    parser.add_argument("--channels", type = str, nargs = "+", default = [])
+    parser.add_argument("--tolerances", type = str, default = "", help = "Tolerance config, default is Skimming/data/config/UL/diff.json")
+    parser.add_argument("--update", action = "store_true", help = "Store the new skim as reference instead of comparing")
+
+    return parser.parse_args()
+
+def run(command):
+    print(" ".join(command))
+    return subprocess.run(command).returncode
+
+def main():
+    args = parser()
+
+    sample = "{}/{}_{}_{}.root".format(args.work_dir, args.preset, args.era, args.seed)
+    skimDir = "{}/skim".format(args.work_dir)
+    runType = "MC" if args.preset == "ttbar" else "A"
+
+    os.makedirs(args.work_dir, exist_ok = True)
+
+    #Synthetic sample is deterministic for a given seed, so it is only generated once
+    if not os.path.exists(sample):
+        if run(["NanoGen", "--out-file", sample, "--era", args.era, "--preset", args.preset, "--n-events", str(args.n_events), "--seed", str(args.seed)]) != 0:
+            sys.exit("Generation of synthetic sample failed")
+
+    channels = args.channels
+
+    if not channels:
+        with open("{}/src/ChargedSkimming/Skimming/data/config/UL/skim.json".format(os.environ["CMSSW_BASE"])) as f:
+            channels = list(json.load(f)["Channel"].keys())
+
+    if os.path.exists(skimDir):
+        shutil.rmtree(skimDir)
+
+    if run(["NanoSkim", "--file-name", sample, "--out-dir", "{}/[C]".format(skimDir), "--out-file", "skim.root", "--channels", " ".join(channels),
+            "--era", args.era, "--run", runType, "--xSec", "1", "--xSecUnc", "0"]) != 0:
+        sys.exit("Skimming of synthetic sample failed")
+
+    if args.update:
+        if os.path.exists(args.ref_dir):
+            shutil.rmtree(args.ref_dir)
+
+        shutil.copytree(skimDir, args.ref_dir)
+        print("Stored reference skim in {}".format(args.ref_dir))
+        return
+
+    failed = []
+
+    for channel in channels:
+        command = ["SkimDiff", "--ref-file", "{}/{}/skim.root".format(args.ref_dir, channel), "--new-file", "{}/{}/skim.root".format(skimDir, channel),
+                   "--out-file", "{}/diff_{}.root".format(args.work_dir, channel)]
+
+        if args.tolerances:
+            command.extend(["--tolerances", args.tolerances])
+
+        if run(command) != 0:
+            failed.append(channel)
+
+    if failed:
+        sys.exit("Skim outputs differ for channels: {}".format(", ".join(failed)))
+
+    print("Skim outputs agree for all channels")
+
+if __name__ == "__main__":
+    main()